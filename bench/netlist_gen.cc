@@ -0,0 +1,154 @@
+#include "netlist_gen.h"
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <sstream>
+
+Placement NetlistGenerator::generate(const NetlistGenOptions& options) {
+    Placement pl;
+    const int n = std::max(1, options.num_cells);
+    const int min_size = std::max(1, options.min_size);
+    const int max_size = std::max(min_size, options.max_size);
+    std::mt19937 rng(options.seed);
+    std::uniform_int_distribution<int> size_dist(min_size, max_size);
+
+    // Cells and die
+    pl.cells.reserve(n);
+    double area = 0.0;
+    for (int i = 0; i < n; ++i) {
+        int w = size_dist(rng);
+        int h = size_dist(rng);
+        pl.cells.emplace_back(i, 0, 0, w, h, false);
+        area += static_cast<double>(w) * h;
+    }
+    const double utilization = std::min(1.0, std::max(0.01, options.utilization));
+    const int side = std::max(max_size, static_cast<int>(std::ceil(std::sqrt(area / utilization))));
+    pl.grid = Grid(side, side);
+
+    // Fixed cells: an even lattice, no denser than one cell per max_size
+    // squared so they never overlap
+    const int lattice_max = side / max_size;
+    int num_fixed = static_cast<int>(std::lround(std::min(1.0, std::max(0.0, options.fixed_fraction)) * n));
+    num_fixed = static_cast<int>(std::min<long long>(num_fixed, 1LL * lattice_max * lattice_max));
+    if (num_fixed > 0) {
+        const int per_side = static_cast<int>(std::ceil(std::sqrt(static_cast<double>(num_fixed))));
+        const int pitch = side / per_side;
+        std::vector<int> order(n);
+        for (int i = 0; i < n; ++i) order[i] = i;
+        std::shuffle(order.begin(), order.end(), rng);
+        for (int k = 0; k < num_fixed; ++k) {
+            Cell& cell = pl.cells[order[k]];
+            cell.fixed = true;
+            cell.x = (k % per_side) * pitch + (pitch - cell.w) / 2;
+            cell.y = (k / per_side) * pitch + (pitch - cell.h) / 2;
+        }
+    }
+    for (auto& cell : pl.cells) {
+        if (cell.fixed) continue;
+        cell.x = std::uniform_int_distribution<int>(0, side - cell.w)(rng);
+        cell.y = std::uniform_int_distribution<int>(0, side - cell.h)(rng);
+    }
+
+    // Net degrees
+    std::vector<int> degree_values;
+    std::vector<double> degree_weights;
+    for (const auto& d : options.degrees) {
+        if (d.first >= 2 && d.second > 0) {
+            degree_values.push_back(std::min(d.first, n));
+            degree_weights.push_back(d.second);
+        }
+    }
+    if (degree_values.empty() || n < 2) {
+        pl.buildIndex();
+        pl.updateGrid();
+        return pl;
+    }
+    std::discrete_distribution<int> degree_dist(degree_weights.begin(), degree_weights.end());
+
+    // Span level weights 2^(L * (p - 1)) for L = 1 .. top
+    int top = 1;
+    while ((1LL << top) < n) top++;
+    std::vector<double> level_weights(top + 1, 0.0);
+    for (int level = 1; level <= top; ++level) {
+        level_weights[level] = std::pow(2.0, level * (options.rent_exponent - 1.0));
+    }
+    // Level distribution for each lowest usable level
+    std::vector<std::discrete_distribution<int>> level_dists(top + 1);
+    for (int lo = 1; lo <= top; ++lo) {
+        level_dists[lo] = std::discrete_distribution<int>(level_weights.begin() + lo, level_weights.end());
+    }
+
+    const long long num_nets = std::llround(std::max(0.0, options.nets_per_cell) * n);
+    pl.nets.reserve(num_nets);
+    std::uniform_int_distribution<int> cell_dist(0, n - 1);
+    std::vector<int> members;
+    for (long long k = 0; k < num_nets; ++k) {
+        const int degree = degree_values[degree_dist(rng)];
+        const int source = cell_dist(rng);
+
+        // Smallest level whose block can hold the net
+        int min_level = 1;
+        while ((1LL << min_level) < degree) min_level++;
+        int level = top;
+        long long begin = 0, end = n;
+        if (min_level < top) level = min_level + level_dists[min_level](rng);
+        for (; level < top; ++level) {
+            begin = (static_cast<long long>(source) >> level) << level;
+            end = std::min<long long>(begin + (1LL << level), n);
+            if (end - begin >= degree) break;
+        }
+        if (level >= top) {
+            begin = 0;
+            end = n;
+        }
+
+        // One pin in the other half makes the net span the whole block
+        members.assign(1, source);
+        const long long half = level > 0 ? (1LL << (level - 1)) : 0;
+        long long other_begin = ((source - begin) < half) ? begin + half : begin;
+        long long other_end = std::min(other_begin + half, end);
+        if (half > 0 && other_begin < other_end) {
+            members.push_back(static_cast<int>(
+                std::uniform_int_distribution<long long>(other_begin, other_end - 1)(rng)));
+        }
+        std::uniform_int_distribution<long long> block_dist(begin, end - 1);
+        while (static_cast<int>(members.size()) < degree) {
+            int cell = static_cast<int>(block_dist(rng));
+            if (std::find(members.begin(), members.end(), cell) == members.end()) members.push_back(cell);
+        }
+
+        Net net(static_cast<int>(k));
+        net.pins.reserve(members.size());
+        for (int c : members) {
+            const Cell& cell = pl.cells[c];
+            net.pins.emplace_back(cell.id, std::uniform_int_distribution<int>(0, cell.w - 1)(rng),
+                                  std::uniform_int_distribution<int>(0, cell.h - 1)(rng));
+        }
+        pl.nets.push_back(std::move(net));
+    }
+
+    pl.buildIndex();
+    pl.updateGrid();
+    return pl;
+}
+
+bool NetlistGenerator::parseDegrees(const std::string& text, std::vector<std::pair<int, double>>& degrees) {
+    std::vector<std::pair<int, double>> parsed;
+    std::istringstream iss(text);
+    std::string item;
+    while (std::getline(iss, item, ',')) {
+        size_t colon = item.find(':');
+        if (colon == std::string::npos) return false;
+        try {
+            int degree = std::stoi(item.substr(0, colon));
+            double weight = std::stod(item.substr(colon + 1));
+            if (degree < 2 || weight < 0) return false;
+            parsed.emplace_back(degree, weight);
+        } catch (const std::exception&) {
+            return false;
+        }
+    }
+    if (parsed.empty()) return false;
+    degrees = parsed;
+    return true;
+}
@@ -0,0 +1,44 @@
+#ifndef NETLIST_GEN_H
+#define NETLIST_GEN_H
+
+#include "../model/placement.h"
+#include <string>
+#include <utility>
+#include <vector>
+
+// Synthetic netlist generator for benchmarks.
+// Cells are leaves of an implicit binary hierarchy (cell i sits in block
+// i >> L at level L). Rent's rule, T = t * B^p, says the number of nets
+// leaving blocks of B cells, summed over all N / B blocks, grows as
+// N * t * B^(p-1); so a net's smallest enclosing block is at level L with
+// probability proportional to 2^(L * (p - 1)). Each net draws a degree, a
+// source cell and such a level, puts one pin in the other half of the
+// source's block and the rest anywhere in the block.
+//
+// Cell sizes are uniform in [min_size, max_size]. The die is square and
+// sized for the target utilisation. Fixed cells sit on an even lattice
+// over the die; movable cells start at random positions.
+
+struct NetlistGenOptions {
+    int num_cells = 10000;
+    double rent_exponent = 0.65;   // p; higher means more global nets
+    double nets_per_cell = 1.0;
+    // Net degree distribution as (degree, weight) pairs
+    std::vector<std::pair<int, double>> degrees = {{2, 60}, {3, 20}, {4, 10}, {6, 7}, {12, 3}};
+    double fixed_fraction = 0.02;  // Share of cells that are fixed
+    double utilization = 0.7;      // Cell area / die area
+    int min_size = 1;
+    int max_size = 4;
+    unsigned seed = 1;
+};
+
+class NetlistGenerator {
+public:
+    // Generate an indexed placement
+    static Placement generate(const NetlistGenOptions& options);
+
+    // Parse a degree distribution such as "2:60,3:20,4:10"; false if malformed
+    static bool parseDegrees(const std::string& text, std::vector<std::pair<int, double>>& degrees);
+};
+
+#endif // NETLIST_GEN_H
@@ -0,0 +1,456 @@
+// Placement benchmark suite: synthetic netlists, per-kernel
+// microbenchmarks and end-to-end runs, with results written as JSON so
+// runs can be compared between releases.
+
+#include "bench/netlist_gen.h"
+#include "cost/cost.h"
+#include "cost/incremental_cost.h"
+#include "cost/kernels.h"
+#include "detail/detail_place.h"
+#include "global/quadratic_place.h"
+#include "io/snapshot.h"
+#include "legal/abacus.h"
+#include "legal/legalize.h"
+#include "opt/anneal.h"
+#include "util/thread_pool.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Timed repetitions stop after this much time (at least one run)
+static const double kMinBenchSeconds = 0.5;
+static const int kMaxReps = 20;
+
+// Annealing sweep: moves per cell, capped, at a mid-range temperature
+static const int kSweepMovesPerCell = 10;
+static const int kMaxSweepMoves = 2000000;
+static const double kSweepTemperature = 100.0;
+
+// Epoch cap of the adaptive schedule, as in placement_simulator
+static const int kAdaptiveMaxEpochs = 1000;
+
+struct BenchOptions {
+    std::vector<int> sizes = {1000, 10000, 100000, 1000000};
+    std::string suite = "all";          // all | micro | e2e
+    std::string output_file = "bench_results.json";
+    std::string generate_file;          // Write the first size as a snapshot and stop
+    int threads = 0;                    // 0 = hardware concurrency
+    int anneal_max_cells = 100000;      // Largest size of the annealing end-to-end run
+    NetlistGenOptions gen;
+};
+
+// One benchmark result: timings plus named metrics
+struct BenchResult {
+    std::string name;
+    int cells = 0;
+    int reps = 0;
+    double min_seconds = 0.0;
+    double median_seconds = 0.0;
+    std::vector<std::pair<std::string, double>> metrics;
+};
+
+// Silences std::cout while in scope; the library reports progress there
+class QuietScope {
+public:
+    QuietScope() : saved_(std::cout.rdbuf(nullptr)) {}
+    ~QuietScope() { std::cout.rdbuf(saved_); }
+
+private:
+    std::streambuf* saved_;
+};
+
+static double seconds(std::chrono::steady_clock::time_point start) {
+    std::chrono::duration<double> d = std::chrono::steady_clock::now() - start;
+    return d.count();
+}
+
+// Run fn repeatedly until kMinBenchSeconds have passed or kMaxReps runs
+static void timeReps(BenchResult& r, const std::function<void()>& fn) {
+    std::vector<double> times;
+    auto start = std::chrono::steady_clock::now();
+    do {
+        auto t = std::chrono::steady_clock::now();
+        {
+            QuietScope quiet;
+            fn();
+        }
+        times.push_back(seconds(t));
+    } while (seconds(start) < kMinBenchSeconds && static_cast<int>(times.size()) < kMaxReps);
+    std::sort(times.begin(), times.end());
+    r.reps = static_cast<int>(times.size());
+    r.min_seconds = times.front();
+    r.median_seconds = times[times.size() / 2];
+}
+
+// Time a single run of fn (for kernels that change the placement)
+static void timeOnce(BenchResult& r, const std::function<void()>& fn) {
+    auto t = std::chrono::steady_clock::now();
+    {
+        QuietScope quiet;
+        fn();
+    }
+    r.reps = 1;
+    r.min_seconds = r.median_seconds = seconds(t);
+}
+
+static void report(const BenchResult& r, std::vector<BenchResult>& results) {
+    std::cout << "  " << r.name << ": " << r.median_seconds << " s";
+    if (r.reps > 1) std::cout << " (median of " << r.reps << ")";
+    for (const auto& m : r.metrics) std::cout << ", " << m.first << " = " << m.second;
+    std::cout << std::endl;
+    results.push_back(r);
+}
+
+static BenchResult makeResult(const std::string& name, const Placement& pl) {
+    BenchResult r;
+    r.name = name;
+    r.cells = static_cast<int>(pl.cells.size());
+    return r;
+}
+
+// Time a cost function with the active kernels and, when those are not
+// the scalar ones, again as "<name>_scalar" with the scalar kernels forced
+static void runKernel(const std::string& name, const Placement& design,
+                      const std::function<double()>& fn, std::vector<BenchResult>& results) {
+    BenchResult r = makeResult(name, design);
+    double value = 0.0;
+    timeReps(r, [&]() { value = fn(); });
+    r.metrics.emplace_back("value", value);
+    report(r, results);
+    if (std::string(CostKernels::activeIsa()) == "scalar") return;
+
+    BenchResult s = makeResult(name + "_scalar", design);
+    CostKernels::forceScalar(true);
+    timeReps(s, [&]() { value = fn(); });
+    CostKernels::forceScalar(false);
+    s.metrics.emplace_back("value", value);
+    s.metrics.emplace_back("speedup", s.median_seconds / std::max(r.median_seconds, 1e-9));
+    report(s, results);
+}
+
+static void runMicro(const Placement& design, const BenchOptions& opt, std::vector<BenchResult>& results) {
+    // Cost kernels
+    runKernel("hpwl", design, [&]() { return CostCalculator::calculateTotalHPWL(design); }, results);
+    {
+        BenchResult r = makeResult("overlap", design);
+        double value = 0.0;
+        timeReps(r, [&]() { value = CostCalculator::calculateOverlapPenalty(design); });
+        r.metrics.emplace_back("value", value);
+        report(r, results);
+    }
+    {
+        BenchResult r = makeResult("density", design);
+        double value = 0.0;
+        timeReps(r, [&]() { value = CostCalculator::calculateDensityPenalty(design); });
+        r.metrics.emplace_back("value", value);
+        report(r, results);
+    }
+
+    // Annealing move throughput at a fixed temperature
+    {
+        BenchResult r = makeResult("anneal_moves", design);
+        Placement pl = design;
+        SimulatedAnnealing sa(1000.0, 0.90, 1.0, 0.1);
+        sa.setSeed(opt.gen.seed);
+        sa.setVerbose(false);
+        sa.prepare(pl);
+        IncrementalCost cost(pl, sa.lambdaOverlap(), sa.lambdaDensity(), sa.densityBinSize());
+        const long long want = static_cast<long long>(kSweepMovesPerCell) * static_cast<long long>(pl.cells.size());
+        const int moves = static_cast<int>(std::min<long long>(want, kMaxSweepMoves));
+        int accepted = 0;
+        timeOnce(r, [&]() { accepted = sa.sweep(pl, cost, moves, kSweepTemperature); });
+        r.metrics.emplace_back("moves", moves);
+        r.metrics.emplace_back("moves_per_second", moves / std::max(r.min_seconds, 1e-9));
+        r.metrics.emplace_back("acceptance", static_cast<double>(accepted) / std::max(moves, 1));
+        report(r, results);
+    }
+}
+
+// Global placement is the input of the legalizers and the detailed placer
+// in a real flow, so it is run once per size and shared: the microbenchmarks
+// legalize it with Legalizer and refine the result, and the end-to-end run
+// end_to_end_global is global placement, Abacus legalization and detailed
+// placement. end_to_end is placement_simulator's default flow: adaptive
+// annealing from the random start, greedy legalization and detailed
+// placement.
+static void runPlacementFlow(const Placement& design, const BenchOptions& opt,
+                             std::vector<BenchResult>& results) {
+    Placement global = design;
+    BenchResult g = makeResult("global_place", design);
+    timeOnce(g, [&]() {
+        GlobalPlaceOptions gp;
+        gp.num_threads = opt.threads;
+        QuadraticPlacer::place(global, gp);
+    });
+    g.metrics.emplace_back("hpwl", CostCalculator::calculateTotalHPWL(global));
+    g.metrics.emplace_back("overflow", QuadraticPlacer::overflow(global, QuadraticPlacer::defaultBinSize(global)));
+    if (opt.suite != "e2e") report(g, results);
+
+    if (opt.suite != "e2e") {
+        Placement pl = global;
+        BenchResult r = makeResult("legalize", design);
+        timeOnce(r, [&]() { Legalizer::legalize(pl); });
+        r.metrics.emplace_back("illegal_cells", static_cast<double>(Legalizer::illegalCells(pl).size()));
+        r.metrics.emplace_back("hpwl", CostCalculator::calculateTotalHPWL(pl));
+        report(r, results);
+
+        BenchResult d = makeResult("detailed_place", design);
+        const double before = CostCalculator::calculateTotalHPWL(pl);
+        DetailedPlacer dp;
+        dp.setSeed(opt.gen.seed);
+        dp.setThreads(opt.threads);
+        timeOnce(d, [&]() { dp.detailedPlace(pl, 5, 10); });
+        const double after = CostCalculator::calculateTotalHPWL(pl);
+        d.metrics.emplace_back("hpwl", after);
+        d.metrics.emplace_back("hpwl_reduction", before > 0 ? (before - after) / before : 0.0);
+        report(d, results);
+    }
+
+    if (opt.suite == "micro") return;
+
+    if (static_cast<int>(design.cells.size()) <= opt.anneal_max_cells) {
+        Placement pl = design;
+        BenchResult r = makeResult("end_to_end", design);
+        double anneal_s = 0.0, legal_s = 0.0, detail_s = 0.0;
+        timeOnce(r, [&]() {
+            auto t = std::chrono::steady_clock::now();
+            SimulatedAnnealing sa(1000.0, 0.90, 1.0, 0.1);
+            sa.setSeed(opt.gen.seed);
+            sa.setAdaptive(AdaptiveOptions());
+            sa.optimize(pl, kAdaptiveMaxEpochs, 0);
+            anneal_s = seconds(t);
+
+            t = std::chrono::steady_clock::now();
+            Legalizer::legalize(pl);
+            legal_s = seconds(t);
+
+            t = std::chrono::steady_clock::now();
+            DetailedPlacer dp;
+            dp.setSeed(opt.gen.seed);
+            dp.setThreads(opt.threads);
+            dp.detailedPlace(pl, 5, 10);
+            detail_s = seconds(t);
+        });
+        r.metrics.emplace_back("anneal_seconds", anneal_s);
+        r.metrics.emplace_back("legalize_seconds", legal_s);
+        r.metrics.emplace_back("detail_seconds", detail_s);
+        r.metrics.emplace_back("hpwl", CostCalculator::calculateTotalHPWL(pl));
+        r.metrics.emplace_back("illegal_cells", static_cast<double>(Legalizer::illegalCells(pl).size()));
+        report(r, results);
+    } else {
+        std::cout << "  end_to_end: skipped above " << opt.anneal_max_cells
+                  << " cells (--anneal-max-cells)" << std::endl;
+    }
+
+    {
+        Placement pl = global;
+        BenchResult r = makeResult("end_to_end_global", design);
+        double legal_s = 0.0, detail_s = 0.0;
+        timeOnce(r, [&]() {
+            auto t = std::chrono::steady_clock::now();
+            AbacusLegalizer::legalize(pl);
+            legal_s = seconds(t);
+
+            t = std::chrono::steady_clock::now();
+            DetailedPlacer dp;
+            dp.setSeed(opt.gen.seed);
+            dp.setThreads(opt.threads);
+            dp.detailedPlace(pl, 5, 10);
+            detail_s = seconds(t);
+        });
+        r.min_seconds = r.median_seconds = g.min_seconds + legal_s + detail_s;
+        r.metrics.emplace_back("global_seconds", g.min_seconds);
+        r.metrics.emplace_back("legalize_seconds", legal_s);
+        r.metrics.emplace_back("detail_seconds", detail_s);
+        r.metrics.emplace_back("hpwl", CostCalculator::calculateTotalHPWL(pl));
+        r.metrics.emplace_back("illegal_cells", static_cast<double>(Legalizer::illegalCells(pl).size()));
+        report(r, results);
+    }
+}
+
+static bool writeResults(const std::vector<BenchResult>& results, const BenchOptions& opt) {
+    std::ofstream out(opt.output_file);
+    if (!out.is_open()) {
+        std::cerr << "Error: Cannot open file " << opt.output_file << " for writing" << std::endl;
+        return false;
+    }
+    out.precision(9);
+    const NetlistGenOptions& g = opt.gen;
+    out << "{\n";
+    out << "  \"format\": \"placement_bench\",\n";
+    out << "  \"version\": 1,\n";
+    out << "  \"threads\": " << (opt.threads > 0 ? opt.threads : ThreadPool::defaultThreads()) << ",\n";
+    out << "  \"isa\": \"" << CostKernels::activeIsa() << "\",\n";
+    out << "  \"generator\": {\"rent_exponent\": " << g.rent_exponent
+        << ", \"nets_per_cell\": " << g.nets_per_cell
+        << ", \"fixed_fraction\": " << g.fixed_fraction
+        << ", \"utilization\": " << g.utilization
+        << ", \"min_size\": " << g.min_size << ", \"max_size\": " << g.max_size
+        << ", \"seed\": " << g.seed << ", \"degrees\": [";
+    for (size_t i = 0; i < g.degrees.size(); ++i) {
+        out << (i ? ", " : "") << "[" << g.degrees[i].first << ", " << g.degrees[i].second << "]";
+    }
+    out << "]},\n";
+    out << "  \"results\": [\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const BenchResult& r = results[i];
+        out << "    {\"name\": \"" << r.name << "\", \"cells\": " << r.cells
+            << ", \"reps\": " << r.reps << ", \"min_seconds\": " << r.min_seconds
+            << ", \"median_seconds\": " << r.median_seconds;
+        for (const auto& m : r.metrics) out << ", \"" << m.first << "\": " << m.second;
+        out << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n";
+    out << "}\n";
+    out.close();
+    if (out.fail()) {
+        std::cerr << "Error: Failed writing " << opt.output_file << std::endl;
+        return false;
+    }
+    return true;
+}
+
+static void printUsage(const char* prog) {
+    std::cout << "Usage: " << prog << " [options]\n"
+              << "  --sizes=N,N,...          Cell counts, k/m suffixes allowed (default 1k,10k,100k,1m)\n"
+              << "  --suite=all|micro|e2e    Benchmarks to run (default all)\n"
+              << "  --output=FILE            JSON results (default bench_results.json)\n"
+              << "  --threads=N              Worker threads (default: all cores)\n"
+              << "  --anneal-max-cells=N     Largest size of the annealing end-to-end run (default 100k)\n"
+              << "  --seed=N                 Generator and optimizer seed (default 1)\n"
+              << "  --rent=P                 Rent exponent (default 0.65)\n"
+              << "  --nets-per-cell=X        Nets per cell (default 1.0)\n"
+              << "  --degrees=D:W,...        Net degree weights (default 2:60,3:20,4:10,6:7,12:3)\n"
+              << "  --fixed=F                Fraction of fixed cells (default 0.02)\n"
+              << "  --utilization=U          Cell area / die area (default 0.7)\n"
+              << "  --cell-size=MIN-MAX      Cell width and height range (default 1-4)\n"
+              << "  --generate=FILE          Write the first size as a snapshot and exit\n";
+}
+
+// Cell count with an optional k or m suffix
+static int parseSize(const std::string& text) {
+    size_t used = 0;
+    double value = std::stod(text, &used);
+    std::string suffix = text.substr(used);
+    if (suffix == "k" || suffix == "K") value *= 1e3;
+    else if (suffix == "m" || suffix == "M") value *= 1e6;
+    else if (!suffix.empty()) throw std::invalid_argument(text);
+    if (value < 1 || value > 1e9) throw std::out_of_range(text);
+    return static_cast<int>(value);
+}
+
+static bool parseArgs(int argc, char* argv[], BenchOptions& opt) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg.compare(0, 2, "--") != 0) {
+            std::cerr << "Error: Unexpected argument " << arg << std::endl;
+            return false;
+        }
+        std::string name = arg.substr(2);
+        std::string value;
+        size_t eq = name.find('=');
+        if (eq != std::string::npos) {
+            value = name.substr(eq + 1);
+            name = name.substr(0, eq);
+        }
+
+        if (name == "help") {
+            printUsage(argv[0]);
+            std::exit(0);
+        } else if (name == "sizes") {
+            opt.sizes.clear();
+            std::istringstream iss(value);
+            std::string item;
+            while (std::getline(iss, item, ',')) opt.sizes.push_back(parseSize(item));
+        } else if (name == "suite") {
+            opt.suite = value;
+        } else if (name == "output") {
+            opt.output_file = value;
+        } else if (name == "threads") {
+            opt.threads = std::stoi(value);
+        } else if (name == "anneal-max-cells") {
+            opt.anneal_max_cells = parseSize(value);
+        } else if (name == "seed") {
+            opt.gen.seed = static_cast<unsigned>(std::stoul(value));
+        } else if (name == "rent") {
+            opt.gen.rent_exponent = std::stod(value);
+        } else if (name == "nets-per-cell") {
+            opt.gen.nets_per_cell = std::stod(value);
+        } else if (name == "degrees") {
+            if (!NetlistGenerator::parseDegrees(value, opt.gen.degrees)) {
+                std::cerr << "Error: --degrees must look like 2:60,3:20,4:10" << std::endl;
+                return false;
+            }
+        } else if (name == "fixed") {
+            opt.gen.fixed_fraction = std::stod(value);
+        } else if (name == "utilization") {
+            opt.gen.utilization = std::stod(value);
+        } else if (name == "cell-size") {
+            size_t dash = value.find('-');
+            opt.gen.min_size = std::stoi(value.substr(0, dash));
+            opt.gen.max_size = dash == std::string::npos ? opt.gen.min_size : std::stoi(value.substr(dash + 1));
+        } else if (name == "generate") {
+            opt.generate_file = value;
+        } else {
+            std::cerr << "Error: Unknown option --" << name << std::endl;
+            printUsage(argv[0]);
+            return false;
+        }
+    }
+    if (opt.suite != "all" && opt.suite != "micro" && opt.suite != "e2e") {
+        std::cerr << "Error: --suite must be all, micro or e2e" << std::endl;
+        return false;
+    }
+    if (opt.sizes.empty()) {
+        std::cerr << "Error: --sizes is empty" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    BenchOptions opt;
+    try {
+        if (!parseArgs(argc, argv, opt)) return 1;
+    } catch (const std::exception&) {
+        std::cerr << "Error: Invalid option value" << std::endl;
+        return 1;
+    }
+
+    if (!opt.generate_file.empty()) {
+        opt.gen.num_cells = opt.sizes.front();
+        Placement pl = NetlistGenerator::generate(opt.gen);
+        if (!Snapshot::write(pl, opt.generate_file)) return 1;
+        std::cout << "Generated " << pl.cells.size() << " cells, " << pl.nets.size() << " nets on a "
+                  << pl.grid.W << " x " << pl.grid.H << " grid: " << opt.generate_file << std::endl;
+        return 0;
+    }
+
+    std::cout << "Cost kernels: " << CostKernels::activeIsa() << std::endl;
+    std::vector<BenchResult> results;
+    for (int size : opt.sizes) {
+        opt.gen.num_cells = size;
+        auto start = std::chrono::steady_clock::now();
+        Placement design = NetlistGenerator::generate(opt.gen);
+        std::cout << "Design: " << design.cells.size() << " cells, " << design.nets.size() << " nets, "
+                  << design.netlist.numPins() << " pins, grid " << design.grid.W << " x " << design.grid.H
+                  << " (generated in " << seconds(start) << " s)" << std::endl;
+
+        if (opt.suite != "e2e") runMicro(design, opt, results);
+        runPlacementFlow(design, opt, results);
+        std::cout << std::endl;
+
+        // Results so far survive a run that is stopped at a large size
+        if (!writeResults(results, opt)) return 1;
+    }
+    std::cout << "Results written to " << opt.output_file << std::endl;
+    return 0;
+}
@@ -25,6 +25,8 @@ if not exist obj\opt mkdir obj\opt
 if not exist obj\legal mkdir obj\legal
 if not exist obj\detail mkdir obj\detail
 if not exist obj\viz mkdir obj\viz
+if not exist obj\util mkdir obj\util
+if not exist obj\global mkdir obj\global
 
 echo Compiling source files...
 g++ -std=c++17 -Wall -Wextra -O2 -I. -c main.cpp -o obj\main.o
@@ -33,26 +35,95 @@ if %ERRORLEVEL% NEQ 0 goto :error
 g++ -std=c++17 -Wall -Wextra -O2 -I. -c model\placement.cc -o obj\model\placement.o
 if %ERRORLEVEL% NEQ 0 goto :error
 
+g++ -std=c++17 -Wall -Wextra -O2 -I. -c model\netlist.cc -o obj\model\netlist.o
+if %ERRORLEVEL% NEQ 0 goto :error
+
+g++ -std=c++17 -Wall -Wextra -O2 -I. -c model\spatial_index.cc -o obj\model\spatial_index.o
+if %ERRORLEVEL% NEQ 0 goto :error
+
 g++ -std=c++17 -Wall -Wextra -O2 -I. -c io\reader.cc -o obj\io\reader.o
 if %ERRORLEVEL% NEQ 0 goto :error
 
+g++ -std=c++17 -Wall -Wextra -O2 -I. -c io\parallel_reader.cc -o obj\io\parallel_reader.o
+if %ERRORLEVEL% NEQ 0 goto :error
+
+g++ -std=c++17 -Wall -Wextra -O2 -I. -c io\bookshelf_reader.cc -o obj\io\bookshelf_reader.o
+if %ERRORLEVEL% NEQ 0 goto :error
+
+g++ -std=c++17 -Wall -Wextra -O2 -I. -c io\mapped_file.cc -o obj\io\mapped_file.o
+if %ERRORLEVEL% NEQ 0 goto :error
+
+g++ -std=c++17 -Wall -Wextra -O2 -I. -c io\snapshot.cc -o obj\io\snapshot.o
+if %ERRORLEVEL% NEQ 0 goto :error
+
 g++ -std=c++17 -Wall -Wextra -O2 -I. -c cost\cost.cc -o obj\cost\cost.o
 if %ERRORLEVEL% NEQ 0 goto :error
 
+g++ -std=c++17 -Wall -Wextra -O2 -I. -c cost\density_map.cc -o obj\cost\density_map.o
+if %ERRORLEVEL% NEQ 0 goto :error
+
+g++ -std=c++17 -Wall -Wextra -O2 -I. -c cost\incremental_cost.cc -o obj\cost\incremental_cost.o
+if %ERRORLEVEL% NEQ 0 goto :error
+
+g++ -std=c++17 -Wall -Wextra -O2 -I. -c cost\kernels.cc -o obj\cost\kernels.o
+if %ERRORLEVEL% NEQ 0 goto :error
+
 g++ -std=c++17 -Wall -Wextra -O2 -I. -c opt\anneal.cc -o obj\opt\anneal.o
 if %ERRORLEVEL% NEQ 0 goto :error
 
+g++ -std=c++17 -Wall -Wextra -O2 -I. -c opt\checkpoint.cc -o obj\opt\checkpoint.o
+if %ERRORLEVEL% NEQ 0 goto :error
+
+g++ -std=c++17 -Wall -Wextra -O2 -I. -c opt\multistart.cc -o obj\opt\multistart.o
+if %ERRORLEVEL% NEQ 0 goto :error
+
+g++ -std=c++17 -Wall -Wextra -O2 -I. -c opt\tempering.cc -o obj\opt\tempering.o
+if %ERRORLEVEL% NEQ 0 goto :error
+
+g++ -std=c++17 -Wall -Wextra -O2 -I. -c opt\partition_anneal.cc -o obj\opt\partition_anneal.o
+if %ERRORLEVEL% NEQ 0 goto :error
+
+g++ -std=c++17 -Wall -Wextra -O2 -I. -c opt\multilevel.cc -o obj\opt\multilevel.o
+if %ERRORLEVEL% NEQ 0 goto :error
+
+g++ -std=c++17 -Wall -Wextra -O2 -I. -c global\sparse.cc -o obj\global\sparse.o
+if %ERRORLEVEL% NEQ 0 goto :error
+
+g++ -std=c++17 -Wall -Wextra -O2 -I. -c global\quadratic_place.cc -o obj\global\quadratic_place.o
+if %ERRORLEVEL% NEQ 0 goto :error
+
+g++ -std=c++17 -Wall -Wextra -O2 -I. -c global\poisson.cc -o obj\global\poisson.o
+if %ERRORLEVEL% NEQ 0 goto :error
+
+g++ -std=c++17 -Wall -Wextra -O2 -I. -c global\electrostatic_place.cc -o obj\global\electrostatic_place.o
+if %ERRORLEVEL% NEQ 0 goto :error
+
 g++ -std=c++17 -Wall -Wextra -O2 -I. -c legal\legalize.cc -o obj\legal\legalize.o
 if %ERRORLEVEL% NEQ 0 goto :error
 
+g++ -std=c++17 -Wall -Wextra -O2 -I. -c legal\abacus.cc -o obj\legal\abacus.o
+if %ERRORLEVEL% NEQ 0 goto :error
+
+g++ -std=c++17 -Wall -Wextra -O2 -I. -c legal\parallel_legalize.cc -o obj\legal\parallel_legalize.o
+if %ERRORLEVEL% NEQ 0 goto :error
+
 g++ -std=c++17 -Wall -Wextra -O2 -I. -c detail\detail_place.cc -o obj\detail\detail_place.o
 if %ERRORLEVEL% NEQ 0 goto :error
 
 g++ -std=c++17 -Wall -Wextra -O2 -I. -c viz\write_json.cc -o obj\viz\write_json.o
 if %ERRORLEVEL% NEQ 0 goto :error
 
+g++ -std=c++17 -Wall -Wextra -O2 -I. -c util\thread_pool.cc -o obj\util\thread_pool.o
+if %ERRORLEVEL% NEQ 0 goto :error
+
+g++ -std=c++17 -Wall -Wextra -O2 -I. -c util\profiler.cc -o obj\util\profiler.o
+if %ERRORLEVEL% NEQ 0 goto :error
+
+g++ -std=c++17 -Wall -Wextra -O2 -I. -c util\assignment.cc -o obj\util\assignment.o
+if %ERRORLEVEL% NEQ 0 goto :error
+
 echo Linking executable...
-g++ -std=c++17 -Wall -Wextra -O2 -o placement_simulator.exe obj\main.o obj\model\placement.o obj\io\reader.o obj\cost\cost.o obj\opt\anneal.o obj\legal\legalize.o obj\detail\detail_place.o obj\viz\write_json.o
+g++ -std=c++17 -Wall -Wextra -O2 -o placement_simulator.exe obj\main.o obj\model\placement.o obj\model\netlist.o obj\model\spatial_index.o obj\io\reader.o obj\io\parallel_reader.o obj\io\bookshelf_reader.o obj\io\mapped_file.o obj\io\snapshot.o obj\cost\cost.o obj\cost\density_map.o obj\cost\incremental_cost.o obj\cost\kernels.o obj\opt\anneal.o obj\opt\checkpoint.o obj\opt\multistart.o obj\opt\tempering.o obj\opt\partition_anneal.o obj\opt\multilevel.o obj\global\sparse.o obj\global\quadratic_place.o obj\global\poisson.o obj\global\electrostatic_place.o obj\legal\legalize.o obj\legal\abacus.o obj\legal\parallel_legalize.o obj\detail\detail_place.o obj\viz\write_json.o obj\util\thread_pool.o obj\util\profiler.o obj\util\assignment.o
 if %ERRORLEVEL% NEQ 0 goto :error
 
 echo.
@@ -1,8 +1,24 @@
 #include "cost.h"
+#include "density_map.h"
+#include "kernels.h"
+#include "../model/spatial_index.h"
+#include "../util/profiler.h"
 #include <algorithm>
 #include <cmath>
 #include <climits>
 
+namespace {
+
+// Per-thread SoA copy of the cells, kept across calls so its arrays are
+// allocated once; each full evaluation only refreshes the contents
+const CellStore& cellStore(const Placement& pl) {
+    thread_local CellStore store;
+    store.assign(pl.cells);
+    return store;
+}
+
+}  // namespace
+
 void CostCalculator::getPinPosition(const Placement& pl, const Pin& pin, int& x, int& y) {
     const Cell* cell = pl.findCell(pin.cell_id);
     if (cell) {
@@ -33,95 +49,119 @@ double CostCalculator::calculateHPWL(const Placement& pl, const Net& net) {
     return (max_x - min_x) + (max_y - min_y);
 }
 
-double CostCalculator::calculateTotalHPWL(const Placement& pl) {
-    double total = 0.0;
-    for (const auto& net : pl.nets) {
-        total += calculateHPWL(pl, net);
+long long CostCalculator::calculateNetHPWL(const Placement& pl, int net) {
+    const Netlist& nl = pl.netlist;
+    int begin = nl.net_pin_start[net];
+    int end = nl.net_pin_start[net + 1];
+    if (begin == end) return 0;
+    
+    int min_x = INT_MAX, max_x = INT_MIN;
+    int min_y = INT_MAX, max_y = INT_MIN;
+    
+    for (int p = begin; p < end; ++p) {
+        int x = 0, y = 0;
+        int c = nl.pin_cell[p];
+        if (c >= 0) {
+            x = pl.cells[c].x + nl.pin_dx[p];
+            y = pl.cells[c].y + nl.pin_dy[p];
+        }
+        
+        min_x = std::min(min_x, x);
+        max_x = std::max(max_x, x);
+        min_y = std::min(min_y, y);
+        max_y = std::max(max_y, y);
     }
-    return total;
+    
+    return static_cast<long long>(max_x - min_x) + (max_y - min_y);
 }
 
-double CostCalculator::calculateOverlapPenalty(const Placement& pl) {
-    double penalty = 0.0;
-    
-    // Check all pairs of cells for overlap
-    for (size_t i = 0; i < pl.cells.size(); ++i) {
-        for (size_t j = i + 1; j < pl.cells.size(); ++j) {
-            const Cell& c1 = pl.cells[i];
-            const Cell& c2 = pl.cells[j];
-            
-            // Check if cells overlap
-            bool overlap_x = !(c1.x + c1.w <= c2.x || c2.x + c2.w <= c1.x);
-            bool overlap_y = !(c1.y + c1.h <= c2.y || c2.y + c2.h <= c1.y);
-            
-            if (overlap_x && overlap_y) {
-                // Calculate overlapping area
-                int overlap_w = std::min(c1.x + c1.w, c2.x + c2.w) - std::max(c1.x, c2.x);
-                int overlap_h = std::min(c1.y + c1.h, c2.y + c2.h) - std::max(c1.y, c2.y);
-                penalty += overlap_w * overlap_h;
-            }
+double CostCalculator::totalHPWL(const Placement& pl, const CellStore& store) {
+    if (!pl.hasIndex()) {
+        double total = 0.0;
+        for (const auto& net : pl.nets) {
+            total += calculateHPWL(pl, net);
         }
+        return total;
     }
     
-    return penalty;
+    // Streaming pass over the CSR pin arrays with the vectorized kernel
+    return static_cast<double>(CostKernels::totalHPWL(store, pl.netlist));
 }
 
-double CostCalculator::calculateDensityPenalty(const Placement& pl) {
-    if (pl.grid.W == 0 || pl.grid.H == 0) return 0.0;
+double CostCalculator::overlapPenalty(const Placement& pl, const CellStore& store) {
+    // Only pairs that share a spatial bin can overlap
+    SpatialIndex index;
+    index.build(pl);
     
-    // Divide grid into bins and check density distribution
-    const int num_bins = 10;
-    int bin_w = pl.grid.W / num_bins;
-    int bin_h = pl.grid.H / num_bins;
+    // Candidates of each cell are gathered into contiguous SoA scratch and
+    // scored with the batched rectangle kernel
+    std::vector<int32_t> cx, cy, cw, ch;
+    long long penalty = 0;
     
-    std::vector<std::vector<int>> bin_density(num_bins, std::vector<int>(num_bins, 0));
-    
-    // Count cells in each bin
-    for (const auto& cell : pl.cells) {
-        int bin_x = std::min(cell.x / bin_w, num_bins - 1);
-        int bin_y = std::min(cell.y / bin_h, num_bins - 1);
-        bin_density[bin_y][bin_x] += cell.w * cell.h;
+    for (int i = 0; i < store.size(); ++i) {
+        cx.clear();
+        cy.clear();
+        cw.clear();
+        ch.clear();
+        index.query(store.x[i], store.y[i], store.x[i] + store.w[i], store.y[i] + store.h[i],
+                    [&](int j) {
+            if (j <= i) return;
+            cx.push_back(store.x[j]);
+            cy.push_back(store.y[j]);
+            cw.push_back(store.w[j]);
+            ch.push_back(store.h[j]);
+        });
+        penalty += CostKernels::overlapBatch(store.x[i], store.y[i], store.w[i], store.h[i],
+                                             cx.data(), cy.data(), cw.data(), ch.data(),
+                                             static_cast<int>(cx.size()));
     }
     
-    // Calculate variance in density
-    double mean = 0.0;
-    int total_area = 0;
-    for (int y = 0; y < num_bins; ++y) {
-        for (int x = 0; x < num_bins; ++x) {
-            total_area += bin_density[y][x];
-        }
-    }
-    mean = total_area / (double)(num_bins * num_bins);
-    
-    double variance = 0.0;
-    for (int y = 0; y < num_bins; ++y) {
-        for (int x = 0; x < num_bins; ++x) {
-            double diff = bin_density[y][x] - mean;
-            variance += diff * diff;
-        }
-    }
-    variance /= (num_bins * num_bins);
-    
-    return variance;
+    return static_cast<double>(penalty);
+}
+
+double CostCalculator::calculateTotalHPWL(const Placement& pl) {
+    Profiler::count(Profiler::FULL_COST_EVALUATIONS);
+    return totalHPWL(pl, cellStore(pl));
+}
+
+double CostCalculator::calculateOverlapPenalty(const Placement& pl) {
+    Profiler::count(Profiler::FULL_COST_EVALUATIONS);
+    return overlapPenalty(pl, cellStore(pl));
+}
+
+double CostCalculator::calculateDensityPenalty(const Placement& pl, int bin_size) {
+    DensityMap map;
+    map.build(pl, bin_size, bin_size);
+    return map.variance();
 }
 
 double CostCalculator::calculateTotalCost(const Placement& pl,
                                           double lambda_overlap,
-                                          double lambda_density) {
-    double hpwl = calculateTotalHPWL(pl);
-    double overlap = calculateOverlapPenalty(pl);
-    double density = calculateDensityPenalty(pl);
+                                          double lambda_density,
+                                          int density_bin_size) {
+    return calculateCostBreakdown(pl, lambda_overlap, lambda_density, density_bin_size).total;
+}
+
+CostBreakdown CostCalculator::calculateCostBreakdown(const Placement& pl,
+                                                     double lambda_overlap,
+                                                     double lambda_density,
+                                                     int density_bin_size) {
+    Profiler::count(Profiler::FULL_COST_EVALUATIONS);
+    const CellStore& store = cellStore(pl);
     
-    return hpwl + lambda_overlap * overlap + lambda_density * density;
+    CostBreakdown b;
+    b.hpwl = totalHPWL(pl, store);
+    b.overlap = overlapPenalty(pl, store);
+    b.density = calculateDensityPenalty(pl, density_bin_size);
+    b.total = b.hpwl + lambda_overlap * b.overlap + lambda_density * b.density;
+    return b;
 }
 
 double CostCalculator::calculateCostDelta(const Placement& old_pl,
                                           const Placement& new_pl,
                                           double lambda_overlap,
                                           double lambda_density) {
-    // For efficiency, we could compute only the delta, but for simplicity
-    // we compute full costs. In a production system, incremental updates
-    // would be more efficient.
+    // Whole-placement comparison; per-move deltas come from IncrementalCost
     double old_cost = calculateTotalCost(old_pl, lambda_overlap, lambda_density);
     double new_cost = calculateTotalCost(new_pl, lambda_overlap, lambda_density);
     return new_cost - old_cost;
@@ -2,36 +2,61 @@
 #define COST_H
 
 #include "../model/placement.h"
+#include "../model/cell_store.h"
 
 // Cost function computation for placement optimization
 
+// All cost terms of one full evaluation
+struct CostBreakdown {
+    double hpwl;
+    double overlap;
+    double density;
+    double total;
+};
+
 class CostCalculator {
 public:
     // Calculate Half-Perimeter Wire Length for a net
     static double calculateHPWL(const Placement& pl, const Net& net);
     
+    // HPWL of net `net` (by index) using the placement's CSR netlist
+    static long long calculateNetHPWL(const Placement& pl, int net);
+    
     // Calculate total HPWL for all nets
     static double calculateTotalHPWL(const Placement& pl);
     
     // Calculate overlap penalty (sum of overlapping cell areas)
     static double calculateOverlapPenalty(const Placement& pl);
     
-    // Calculate density penalty (imbalance in cell distribution)
-    static double calculateDensityPenalty(const Placement& pl);
+    // Calculate density penalty (variance of per-bin cell area, see DensityMap)
+    // A bin size <= 0 uses DensityMap's default binning
+    static double calculateDensityPenalty(const Placement& pl, int bin_size = 0);
     
     // Calculate total cost with weights
     static double calculateTotalCost(const Placement& pl, 
                                      double lambda_overlap = 1.0,
-                                     double lambda_density = 0.1);
+                                     double lambda_density = 0.1,
+                                     int density_bin_size = 0);
     
-    // Calculate cost delta for a proposed move
-    // This is more efficient than recalculating total cost
+    // Calculate every term in one pass over a shared SoA snapshot; used for
+    // reports and convergence checks
+    static CostBreakdown calculateCostBreakdown(const Placement& pl,
+                                                double lambda_overlap = 1.0,
+                                                double lambda_density = 0.1,
+                                                int density_bin_size = 0);
+    
+    // Calculate cost delta between two full placements
+    // Optimizers scoring single moves should use IncrementalCost instead
     static double calculateCostDelta(const Placement& old_pl,
                                     const Placement& new_pl,
                                     double lambda_overlap = 1.0,
                                     double lambda_density = 0.1);
     
 private:
+    // Full-placement kernels on an SoA snapshot
+    static double totalHPWL(const Placement& pl, const CellStore& store);
+    static double overlapPenalty(const Placement& pl, const CellStore& store);
+    
     // Helper to get pin position
     static void getPinPosition(const Placement& pl, const Pin& pin, int& x, int& y);
 };
@@ -0,0 +1,61 @@
+#include "density_map.h"
+#include <algorithm>
+
+void DensityMap::build(const Placement& pl, int bin_w, int bin_h) {
+    grid_w_ = pl.grid.W;
+    grid_h_ = pl.grid.H;
+    bin_w_ = bin_w > 0 ? bin_w : std::max(1, pl.grid.W / kDefaultBins);
+    bin_h_ = bin_h > 0 ? bin_h : std::max(1, pl.grid.H / kDefaultBins);
+    nbx_ = pl.grid.W > 0 ? (pl.grid.W + bin_w_ - 1) / bin_w_ : 0;
+    nby_ = pl.grid.H > 0 ? (pl.grid.H + bin_h_ - 1) / bin_h_ : 0;
+    if (nbx_ == 0 || nby_ == 0) {
+        nbx_ = nby_ = 0;
+    }
+
+    area_.assign(static_cast<size_t>(nbx_) * nby_, 0);
+    sum_ = 0;
+    sum_sq_ = 0;
+    for (const auto& cell : pl.cells) {
+        addCell(cell);
+    }
+}
+
+void DensityMap::accumulate(int x, int y, int w, int h, int sign) {
+    if (nbx_ == 0) return;
+
+    // Clip the footprint to the grid; area outside it belongs to no bin
+    int x0 = std::max(x, 0), x1 = std::min(x + w, grid_w_);
+    int y0 = std::max(y, 0), y1 = std::min(y + h, grid_h_);
+    if (x0 >= x1 || y0 >= y1) return;
+
+    int bx0 = x0 / bin_w_, bx1 = (x1 - 1) / bin_w_;
+    int by0 = y0 / bin_h_, by1 = (y1 - 1) / bin_h_;
+    for (int by = by0; by <= by1; ++by) {
+        int oy = std::min(y1, (by + 1) * bin_h_) - std::max(y0, by * bin_h_);
+        for (int bx = bx0; bx <= bx1; ++bx) {
+            int ox = std::min(x1, (bx + 1) * bin_w_) - std::max(x0, bx * bin_w_);
+            long long a = static_cast<long long>(ox) * oy * sign;
+            long long& bin = area_[by * nbx_ + bx];
+            sum_sq_ += 2 * bin * a + a * a;
+            bin += a;
+            sum_ += a;
+        }
+    }
+}
+
+void DensityMap::addChange(const DensityMap& before, const DensityMap& after) {
+    sum_ = 0;
+    sum_sq_ = 0;
+    for (size_t i = 0; i < area_.size(); ++i) {
+        area_[i] += after.area_[i] - before.area_[i];
+        sum_ += area_[i];
+        sum_sq_ += area_[i] * area_[i];
+    }
+}
+
+double DensityMap::variance() const {
+    if (area_.empty()) return 0.0;
+    const double n = static_cast<double>(area_.size());
+    double mean = sum_ / n;
+    return std::max(0.0, sum_sq_ / n - mean * mean);
+}
@@ -0,0 +1,51 @@
+#ifndef DENSITY_MAP_H
+#define DENSITY_MAP_H
+
+#include "../model/placement.h"
+#include <vector>
+
+// Persistent bin map for the density penalty.
+// Each cell contributes the part of its area that falls into every bin it
+// straddles. The map keeps the running sum and sum of squares of the bin
+// areas, so moving a cell updates the variance in O(bins touched).
+
+class DensityMap {
+public:
+    // Default bin count per side when no bin size is given
+    static const int kDefaultBins = 10;
+
+    DensityMap() : grid_w_(0), grid_h_(0), bin_w_(1), bin_h_(1), nbx_(0), nby_(0), sum_(0), sum_sq_(0) {}
+
+    // Rebuild from the placement. A bin size <= 0 splits that side of the
+    // grid into kDefaultBins bins (at least one grid unit wide).
+    void build(const Placement& pl, int bin_w = 0, int bin_h = 0);
+
+    // Add or remove a cell's footprint
+    void addCell(const Cell& cell) { accumulate(cell.x, cell.y, cell.w, cell.h, 1); }
+    void removeCell(const Cell& cell) { accumulate(cell.x, cell.y, cell.w, cell.h, -1); }
+
+    // Add the bin areas of `after` minus those of `before`, two maps with
+    // this map's bins; merges the moves made on copies of this map
+    void addChange(const DensityMap& before, const DensityMap& after);
+
+    // Variance of the bin areas (the density penalty)
+    double variance() const;
+
+    int binWidth() const { return bin_w_; }
+    int binHeight() const { return bin_h_; }
+    int numBinsX() const { return nbx_; }
+    int numBinsY() const { return nby_; }
+    long long binArea(int bx, int by) const { return area_[by * nbx_ + bx]; }
+
+private:
+    int grid_w_, grid_h_;
+    int bin_w_, bin_h_;
+    int nbx_, nby_;
+    std::vector<long long> area_;
+    long long sum_;     // Sum of bin areas
+    long long sum_sq_;  // Sum of squared bin areas
+
+    void accumulate(int x, int y, int w, int h, int sign);
+};
+
+#endif // DENSITY_MAP_H
@@ -0,0 +1,171 @@
+#include "incremental_cost.h"
+#include "cost.h"
+#include "kernels.h"
+#include "../util/profiler.h"
+#include <algorithm>
+
+IncrementalCost::IncrementalCost(Placement& pl, double lambda_overlap, double lambda_density,
+                                 int density_bin_size)
+    : pl_(pl), lambda_overlap_(lambda_overlap), lambda_density_(lambda_density),
+      hpwl_(0), overlap_(0), density_bin_size_(density_bin_size),
+      pending_hpwl_delta_(0), pending_overlap_delta_(0), pending_density_delta_(0.0),
+      stamp_(0), evaluations_(0) {
+    if (!pl_.hasIndex()) {
+        pl_.buildIndex();
+    }
+    rebuild();
+}
+
+IncrementalCost::~IncrementalCost() {
+    Profiler::count(Profiler::COST_EVALUATIONS, evaluations_);
+}
+
+static long long overlapArea(const Cell& a, const Cell& b) {
+    int w = std::min(a.x + a.w, b.x + b.w) - std::max(a.x, b.x);
+    if (w <= 0) return 0;
+    int h = std::min(a.y + a.h, b.y + b.h) - std::max(a.y, b.y);
+    if (h <= 0) return 0;
+    return static_cast<long long>(w) * h;
+}
+
+long long IncrementalCost::movedOverlap() const {
+    // Overlap of every pair that involves at least one moved cell; only the
+    // cells sharing a bin with a moved cell are looked at
+    long long total = 0;
+    for (size_t m = 0; m < moved_.size(); ++m) {
+        const Cell& cm = pl_.cells[moved_[m].idx];
+        index_.query(cm.x, cm.y, cm.x + cm.w, cm.y + cm.h, [&](int j) {
+            for (const auto& s : moved_) {
+                if (s.idx == j) return;
+            }
+            total += overlapArea(cm, pl_.cells[j]);
+        });
+        for (size_t k = m + 1; k < moved_.size(); ++k) {
+            total += overlapArea(cm, pl_.cells[moved_[k].idx]);
+        }
+    }
+    return total;
+}
+
+void IncrementalCost::moveCell(int idx, int x, int y) {
+    Cell& cell = pl_.cells[idx];
+    density_.removeCell(cell);
+    cell.x = x;
+    cell.y = y;
+    density_.addCell(cell);
+    index_.update(idx, x, y, cell.w, cell.h);
+}
+
+double IncrementalCost::totalCost() const {
+    return hpwl() + lambda_overlap_ * overlap() + lambda_density_ * density();
+}
+
+void IncrementalCost::rebuild() {
+    moved_.clear();
+    pending_nets_.clear();
+    net_stamp_.assign(pl_.nets.size(), 0);
+
+    CellStore store;
+    store.assign(pl_.cells);
+    net_hpwl_.assign(pl_.nets.size(), 0);
+    hpwl_ = CostKernels::netHPWL(store, pl_.netlist, net_hpwl_.data());
+
+    index_.build(pl_);
+    overlap_ = 0;
+    for (size_t i = 0; i < pl_.cells.size(); ++i) {
+        const Cell& ci = pl_.cells[i];
+        index_.query(ci.x, ci.y, ci.x + ci.w, ci.y + ci.h, [&](int j) {
+            if (j > static_cast<int>(i)) overlap_ += overlapArea(ci, pl_.cells[j]);
+        });
+    }
+
+    density_.build(pl_, density_bin_size_, density_bin_size_);
+}
+
+double IncrementalCost::evaluateShift(int cell_idx, int new_x, int new_y) {
+    Cell& cell = pl_.cells[cell_idx];
+    moved_.assign(1, Saved{cell_idx, cell.x, cell.y});
+
+    long long old_overlap = movedOverlap();
+    double old_density = density();
+    moveCell(cell_idx, new_x, new_y);
+
+    pending_overlap_delta_ = movedOverlap() - old_overlap;
+    pending_density_delta_ = density() - old_density;
+    return evaluatePending();
+}
+
+double IncrementalCost::evaluateSwap(int cell_idx1, int cell_idx2) {
+    Cell& c1 = pl_.cells[cell_idx1];
+    Cell& c2 = pl_.cells[cell_idx2];
+    moved_.assign({Saved{cell_idx1, c1.x, c1.y}, Saved{cell_idx2, c2.x, c2.y}});
+
+    long long old_overlap = movedOverlap();
+    double old_density = density();
+    int x1 = c1.x, y1 = c1.y;
+    moveCell(cell_idx1, c2.x, c2.y);
+    moveCell(cell_idx2, x1, y1);
+
+    pending_overlap_delta_ = movedOverlap() - old_overlap;
+    pending_density_delta_ = density() - old_density;
+    return evaluatePending();
+}
+
+double IncrementalCost::evaluateMoves(const std::vector<int>& cells, const std::vector<int>& new_x,
+                                      const std::vector<int>& new_y) {
+    moved_.clear();
+    for (int idx : cells) {
+        moved_.push_back(Saved{idx, pl_.cells[idx].x, pl_.cells[idx].y});
+    }
+
+    long long old_overlap = movedOverlap();
+    double old_density = density();
+    for (size_t i = 0; i < cells.size(); ++i) {
+        moveCell(cells[i], new_x[i], new_y[i]);
+    }
+
+    pending_overlap_delta_ = movedOverlap() - old_overlap;
+    pending_density_delta_ = density() - old_density;
+    return evaluatePending();
+}
+
+double IncrementalCost::evaluatePending() {
+    // Re-score only the nets attached to the moved cells
+    ++evaluations_;
+    ++stamp_;
+    pending_nets_.clear();
+    pending_hpwl_delta_ = 0;
+    const Netlist& nl = pl_.netlist;
+    for (const auto& s : moved_) {
+        for (int k = nl.cell_net_start[s.idx]; k < nl.cell_net_start[s.idx + 1]; ++k) {
+            int n = nl.cell_nets[k];
+            if (net_stamp_[n] == stamp_) continue;
+            net_stamp_[n] = stamp_;
+            long long h = CostCalculator::calculateNetHPWL(pl_, n);
+            pending_hpwl_delta_ += h - net_hpwl_[n];
+            pending_nets_.emplace_back(n, h);
+        }
+    }
+
+    return static_cast<double>(pending_hpwl_delta_)
+         + lambda_overlap_ * static_cast<double>(pending_overlap_delta_)
+         + lambda_density_ * pending_density_delta_;
+}
+
+void IncrementalCost::commit() {
+    for (const auto& nh : pending_nets_) {
+        net_hpwl_[nh.first] = nh.second;
+    }
+    hpwl_ += pending_hpwl_delta_;
+    overlap_ += pending_overlap_delta_;
+    moved_.clear();
+    pending_nets_.clear();
+}
+
+void IncrementalCost::rollback() {
+    for (const auto& s : moved_) {
+        moveCell(s.idx, s.x, s.y);
+    }
+    moved_.clear();
+    pending_nets_.clear();
+}
@@ -0,0 +1,94 @@
+#ifndef INCREMENTAL_COST_H
+#define INCREMENTAL_COST_H
+
+#include "density_map.h"
+#include "../model/placement.h"
+#include "../model/spatial_index.h"
+#include <cstdint>
+#include <vector>
+
+// Incremental cost engine for move-based optimizers.
+//
+// Uses the placement's CSR netlist for cell -> nets adjacency and caches the
+// HPWL of every net, the total overlap area and the density bins, so a SHIFT
+// or SWAP is scored by touching only the moved cells, their nets and their
+// neighbours. A move is evaluated with evaluateShift()/evaluateSwap(), which
+// leaves the cells at their new positions, and is then either committed or
+// rolled back.
+
+class IncrementalCost {
+public:
+    IncrementalCost(Placement& pl, double lambda_overlap = 1.0,
+                    double lambda_density = 0.1, int density_bin_size = 0);
+    ~IncrementalCost();
+
+    IncrementalCost(const IncrementalCost&) = delete;
+    IncrementalCost& operator=(const IncrementalCost&) = delete;
+
+    // Recompute all cached terms from the current cell positions
+    void rebuild();
+
+    // Cached cost terms (same definitions as CostCalculator)
+    double hpwl() const { return static_cast<double>(hpwl_); }
+    double overlap() const { return static_cast<double>(overlap_); }
+    double density() const { return density_.variance(); }
+    double totalCost() const;
+
+    // Move a cell (by index) and return the cost delta. The move stays
+    // pending until commit() or rollback().
+    double evaluateShift(int cell_idx, int new_x, int new_y);
+
+    // Swap the positions of two cells and return the cost delta
+    double evaluateSwap(int cell_idx1, int cell_idx2);
+
+    // Move several cells at once (cells[i] to (new_x[i], new_y[i])) and
+    // return the cost delta
+    double evaluateMoves(const std::vector<int>& cells, const std::vector<int>& new_x,
+                         const std::vector<int>& new_y);
+
+    // Keep or undo the pending move
+    void commit();
+    void rollback();
+
+    // Density bins, and replacing them with a map of a larger placement
+    // that this one is a part of (same bins, no pending move); moves then
+    // update that copy
+    const DensityMap& densityMap() const { return density_; }
+    void setDensityMap(const DensityMap& map) { density_ = map; }
+
+    // Spatial index kept in sync with the cell positions
+    const SpatialIndex& spatialIndex() const { return index_; }
+
+private:
+    Placement& pl_;
+    double lambda_overlap_;
+    double lambda_density_;
+
+    // Cached terms
+    std::vector<long long> net_hpwl_;
+    long long hpwl_;
+    long long overlap_;
+    SpatialIndex index_;
+
+    int density_bin_size_;
+    DensityMap density_;
+
+    // Pending move
+    struct Saved { int idx, x, y; };
+    std::vector<Saved> moved_;
+    std::vector<std::pair<int, long long>> pending_nets_;
+    long long pending_hpwl_delta_;
+    long long pending_overlap_delta_;
+    double pending_density_delta_;
+    std::vector<int> net_stamp_;
+    int stamp_;
+
+    // Moves scored, reported to the profiler on destruction
+    uint64_t evaluations_;
+
+    long long movedOverlap() const;
+    void moveCell(int idx, int x, int y);
+    double evaluatePending();
+};
+
+#endif // INCREMENTAL_COST_H
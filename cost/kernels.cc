@@ -0,0 +1,284 @@
+#include "kernels.h"
+#include <algorithm>
+#include <climits>
+#include <vector>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define COST_KERNELS_AVX2 1
+#include <immintrin.h>
+#endif
+
+namespace {
+
+bool g_force_scalar = false;
+
+bool useAvx2() {
+#ifdef COST_KERNELS_AVX2
+    static const bool supported = __builtin_cpu_supports("avx2");
+    return supported && !g_force_scalar;
+#else
+    return false;
+#endif
+}
+
+// Per-thread pin position scratch, reused across calls
+struct PinScratch {
+    std::vector<int32_t> px, py;
+};
+
+PinScratch& pinScratch(int num_pins) {
+    thread_local PinScratch scratch;
+    if (static_cast<int>(scratch.px.size()) < num_pins) {
+        scratch.px.resize(num_pins);
+        scratch.py.resize(num_pins);
+    }
+    return scratch;
+}
+
+// ---------------------------------------------------------------------------
+// Scalar kernels
+
+void pinPositionsScalar(const CellStore& cells, const Netlist& nl,
+                        int32_t* px, int32_t* py) {
+    const int num_pins = nl.numPins();
+    for (int p = 0; p < num_pins; ++p) {
+        int c = nl.pin_cell[p];
+        if (c >= 0) {
+            px[p] = cells.x[c] + nl.pin_dx[p];
+            py[p] = cells.y[c] + nl.pin_dy[p];
+        } else {
+            px[p] = 0;
+            py[p] = 0;
+        }
+    }
+}
+
+void rangeMinMaxScalar(const int32_t* v, int begin, int end, int& lo, int& hi) {
+    for (int p = begin; p < end; ++p) {
+        lo = std::min(lo, v[p]);
+        hi = std::max(hi, v[p]);
+    }
+}
+
+// Box and HPWL of one net into the outputs that are not null
+long long storeNet(int n, int lo_x, int hi_x, int lo_y, int hi_y,
+                   int* min_x, int* max_x, int* min_y, int* max_y,
+                   long long* net_hpwl) {
+    if (min_x) {
+        min_x[n] = lo_x;
+        max_x[n] = hi_x;
+        min_y[n] = lo_y;
+        max_y[n] = hi_y;
+    }
+    long long hpwl = static_cast<long long>(hi_x - lo_x) + (hi_y - lo_y);
+    if (net_hpwl) net_hpwl[n] = hpwl;
+    return hpwl;
+}
+
+// Reduce pin positions to per-net boxes and HPWL; any output may be null
+long long reduceNetsScalar(const Netlist& nl, const int32_t* px, const int32_t* py,
+                           int* min_x, int* max_x, int* min_y, int* max_y,
+                           long long* net_hpwl) {
+    long long total = 0;
+    const int num_nets = nl.numNets();
+    for (int n = 0; n < num_nets; ++n) {
+        int begin = nl.net_pin_start[n];
+        int end = nl.net_pin_start[n + 1];
+        int lo_x = 0, hi_x = 0, lo_y = 0, hi_y = 0;
+        if (begin != end) {
+            lo_x = lo_y = INT_MAX;
+            hi_x = hi_y = INT_MIN;
+            rangeMinMaxScalar(px, begin, end, lo_x, hi_x);
+            rangeMinMaxScalar(py, begin, end, lo_y, hi_y);
+        }
+        total += storeNet(n, lo_x, hi_x, lo_y, hi_y, min_x, max_x, min_y, max_y, net_hpwl);
+    }
+    return total;
+}
+
+long long overlapBatchScalar(int x, int y, int w, int h,
+                             const int32_t* cx, const int32_t* cy,
+                             const int32_t* cw, const int32_t* ch, int n) {
+    long long total = 0;
+    for (int i = 0; i < n; ++i) {
+        int ow = std::min(x + w, cx[i] + cw[i]) - std::max(x, cx[i]);
+        int oh = std::min(y + h, cy[i] + ch[i]) - std::max(y, cy[i]);
+        if (ow > 0 && oh > 0) total += static_cast<long long>(ow) * oh;
+    }
+    return total;
+}
+
+// ---------------------------------------------------------------------------
+// AVX2 kernels
+
+#ifdef COST_KERNELS_AVX2
+
+__attribute__((target("avx2")))
+void pinPositionsAvx2(const CellStore& cells, const Netlist& nl,
+                      int32_t* px, int32_t* py) {
+    const int num_pins = nl.numPins();
+    const int* pc = nl.pin_cell.data();
+    const int* dx = nl.pin_dx.data();
+    const int* dy = nl.pin_dy.data();
+    const int* xs = cells.x.data();
+    const int* ys = cells.y.data();
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i minus_one = _mm256_set1_epi32(-1);
+
+    int p = 0;
+    for (; p + 8 <= num_pins; p += 8) {
+        __m256i idx = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pc + p));
+        // Pins of unknown cells sit at (0, 0); their lanes are not gathered
+        __m256i valid = _mm256_cmpgt_epi32(idx, minus_one);
+        __m256i gx = _mm256_mask_i32gather_epi32(zero, xs, idx, valid, 4);
+        __m256i gy = _mm256_mask_i32gather_epi32(zero, ys, idx, valid, 4);
+        __m256i ox = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(dx + p));
+        __m256i oy = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(dy + p));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(px + p),
+                            _mm256_and_si256(_mm256_add_epi32(gx, ox), valid));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(py + p),
+                            _mm256_and_si256(_mm256_add_epi32(gy, oy), valid));
+    }
+    for (; p < num_pins; ++p) {
+        int c = pc[p];
+        px[p] = c >= 0 ? xs[c] + dx[p] : 0;
+        py[p] = c >= 0 ? ys[c] + dy[p] : 0;
+    }
+}
+
+__attribute__((target("avx2")))
+int hmin(__m256i v) {
+    __m128i m = _mm_min_epi32(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+    m = _mm_min_epi32(m, _mm_shuffle_epi32(m, _MM_SHUFFLE(1, 0, 3, 2)));
+    m = _mm_min_epi32(m, _mm_shuffle_epi32(m, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtsi128_si32(m);
+}
+
+__attribute__((target("avx2")))
+int hmax(__m256i v) {
+    __m128i m = _mm_max_epi32(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+    m = _mm_max_epi32(m, _mm_shuffle_epi32(m, _MM_SHUFFLE(1, 0, 3, 2)));
+    m = _mm_max_epi32(m, _mm_shuffle_epi32(m, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtsi128_si32(m);
+}
+
+__attribute__((target("avx2")))
+void rangeMinMaxAvx2(const int32_t* v, int begin, int end, int& lo, int& hi) {
+    int p = begin;
+    if (end - begin >= 8) {
+        __m256i vlo = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(v + p));
+        __m256i vhi = vlo;
+        for (p += 8; p + 8 <= end; p += 8) {
+            __m256i d = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(v + p));
+            vlo = _mm256_min_epi32(vlo, d);
+            vhi = _mm256_max_epi32(vhi, d);
+        }
+        lo = std::min(lo, hmin(vlo));
+        hi = std::max(hi, hmax(vhi));
+    }
+    rangeMinMaxScalar(v, p, end, lo, hi);
+}
+
+// Nets of 1 to kMaxBatchDegree pins are reduced eight at a time, one net per
+// lane, gathering pin j of all eight in step j; larger nets are reduced one
+// at a time over their pin range
+const int kMaxBatchDegree = 16;
+
+__attribute__((target("avx2")))
+long long reduceNetsAvx2(const Netlist& nl, const int32_t* px, const int32_t* py,
+                         int* min_x, int* max_x, int* min_y, int* max_y,
+                         long long* net_hpwl) {
+    long long total = 0;
+    const int num_degrees = static_cast<int>(nl.degree_start.size()) - 1;
+    const int* pin_start = nl.net_pin_start.data();
+    alignas(32) int32_t lo_x[8], hi_x[8], lo_y[8], hi_y[8];
+
+    for (int d = 0; d < num_degrees; ++d) {
+        const int* nets = nl.net_by_degree.data() + nl.degree_start[d];
+        const int count = nl.degree_start[d + 1] - nl.degree_start[d];
+        int i = 0;
+        if (d >= 1 && d <= kMaxBatchDegree) {
+            for (; i + 8 <= count; i += 8) {
+                __m256i ids = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(nets + i));
+                __m256i p = _mm256_i32gather_epi32(pin_start, ids, 4);
+                __m256i vlo_x = _mm256_i32gather_epi32(px, p, 4);
+                __m256i vlo_y = _mm256_i32gather_epi32(py, p, 4);
+                __m256i vhi_x = vlo_x, vhi_y = vlo_y;
+                const __m256i one = _mm256_set1_epi32(1);
+                for (int j = 1; j < d; ++j) {
+                    p = _mm256_add_epi32(p, one);
+                    __m256i x = _mm256_i32gather_epi32(px, p, 4);
+                    __m256i y = _mm256_i32gather_epi32(py, p, 4);
+                    vlo_x = _mm256_min_epi32(vlo_x, x);
+                    vhi_x = _mm256_max_epi32(vhi_x, x);
+                    vlo_y = _mm256_min_epi32(vlo_y, y);
+                    vhi_y = _mm256_max_epi32(vhi_y, y);
+                }
+                _mm256_store_si256(reinterpret_cast<__m256i*>(lo_x), vlo_x);
+                _mm256_store_si256(reinterpret_cast<__m256i*>(hi_x), vhi_x);
+                _mm256_store_si256(reinterpret_cast<__m256i*>(lo_y), vlo_y);
+                _mm256_store_si256(reinterpret_cast<__m256i*>(hi_y), vhi_y);
+                for (int k = 0; k < 8; ++k) {
+                    total += storeNet(nets[i + k], lo_x[k], hi_x[k], lo_y[k], hi_y[k],
+                                      min_x, max_x, min_y, max_y, net_hpwl);
+                }
+            }
+        }
+        for (; i < count; ++i) {
+            const int n = nets[i];
+            int lx = 0, hx = 0, ly = 0, hy = 0;
+            if (d > 0) {
+                lx = ly = INT_MAX;
+                hx = hy = INT_MIN;
+                rangeMinMaxAvx2(px, pin_start[n], pin_start[n + 1], lx, hx);
+                rangeMinMaxAvx2(py, pin_start[n], pin_start[n + 1], ly, hy);
+            }
+            total += storeNet(n, lx, hx, ly, hy, min_x, max_x, min_y, max_y, net_hpwl);
+        }
+    }
+    return total;
+}
+
+#endif // COST_KERNELS_AVX2
+
+// Pin positions followed by the per-net reduction, with the active ISA;
+// the AVX2 reduction needs the pin-count groups
+long long netReduce(const CellStore& cells, const Netlist& nl,
+                    int* min_x, int* max_x, int* min_y, int* max_y,
+                    long long* net_hpwl) {
+    PinScratch& s = pinScratch(nl.numPins());
+#ifdef COST_KERNELS_AVX2
+    if (useAvx2() && static_cast<int>(nl.net_by_degree.size()) == nl.numNets()) {
+        pinPositionsAvx2(cells, nl, s.px.data(), s.py.data());
+        return reduceNetsAvx2(nl, s.px.data(), s.py.data(), min_x, max_x, min_y, max_y, net_hpwl);
+    }
+#endif
+    pinPositionsScalar(cells, nl, s.px.data(), s.py.data());
+    return reduceNetsScalar(nl, s.px.data(), s.py.data(), min_x, max_x, min_y, max_y, net_hpwl);
+}
+
+}  // namespace
+
+void CostKernels::netBoundingBoxes(const CellStore& cells, const Netlist& netlist,
+                                   int* min_x, int* max_x, int* min_y, int* max_y) {
+    netReduce(cells, netlist, min_x, max_x, min_y, max_y, nullptr);
+}
+
+long long CostKernels::netHPWL(const CellStore& cells, const Netlist& netlist,
+                               long long* net_hpwl) {
+    return netReduce(cells, netlist, nullptr, nullptr, nullptr, nullptr, net_hpwl);
+}
+
+long long CostKernels::overlapBatch(int x, int y, int w, int h,
+                                    const int32_t* cx, const int32_t* cy,
+                                    const int32_t* cw, const int32_t* ch, int n) {
+    return overlapBatchScalar(x, y, w, h, cx, cy, cw, ch, n);
+}
+
+const char* CostKernels::activeIsa() {
+    return useAvx2() ? "avx2" : "scalar";
+}
+
+void CostKernels::forceScalar(bool scalar) {
+    g_force_scalar = scalar;
+}
@@ -0,0 +1,43 @@
+#ifndef KERNELS_H
+#define KERNELS_H
+
+#include "../model/cell_store.h"
+#include "../model/netlist.h"
+
+// Vectorized cost kernels over the SoA cell store and the CSR netlist.
+// The net kernels have an AVX2 and a scalar implementation; the AVX2 one
+// is picked at runtime when the CPU supports it. The AVX2 net reduction
+// takes small nets eight at a time from the netlist's pin-count groups.
+// The overlap kernel is scalar only: a cell has a handful of candidates,
+// too few to fill the vector lanes.
+
+class CostKernels {
+public:
+    // Per-net pin bounding boxes. Output arrays hold netlist.numNets()
+    // entries; nets without pins get an all-zero box.
+    static void netBoundingBoxes(const CellStore& cells, const Netlist& netlist,
+                                 int* min_x, int* max_x, int* min_y, int* max_y);
+
+    // HPWL of every net into `net_hpwl` (may be null); returns the total
+    static long long netHPWL(const CellStore& cells, const Netlist& netlist,
+                             long long* net_hpwl);
+
+    // Total HPWL
+    static long long totalHPWL(const CellStore& cells, const Netlist& netlist) {
+        return netHPWL(cells, netlist, nullptr);
+    }
+
+    // Sum of the overlap areas between rectangle (x, y, w, h) and `n`
+    // candidate rectangles given as SoA arrays (scalar)
+    static long long overlapBatch(int x, int y, int w, int h,
+                                  const int32_t* cx, const int32_t* cy,
+                                  const int32_t* cw, const int32_t* ch, int n);
+
+    // Name of the implementation in use ("avx2" or "scalar")
+    static const char* activeIsa();
+
+    // Force the scalar kernels (for benchmarking and cross-checking)
+    static void forceScalar(bool scalar);
+};
+
+#endif // KERNELS_H
@@ -1,116 +1,547 @@
 #include "detail_place.h"
-#include "../cost/cost.h"
+#include "../util/assignment.h"
+#include "../util/profiler.h"
+#include "../util/thread_pool.h"
 #include <algorithm>
-#include <random>
+#include <chrono>
+#include <climits>
+#include <cstdlib>
 #include <iostream>
 
-bool DetailedPlacer::tryLocalMove(Placement& pl, Cell& cell, int window_size) {
-    if (cell.fixed) return false;
-    
-    int old_x = cell.x;
-    int old_y = cell.y;
-    
-    double old_cost = CostCalculator::calculateTotalCost(pl);
-    
-    // Try small moves within window
-    std::random_device rd;
-    std::mt19937 rng(rd());
-    std::uniform_int_distribution<int> dist(-window_size, window_size);
-    
-    int new_x = old_x + dist(rng);
-    int new_y = old_y + dist(rng);
-    
-    // Ensure bounds
-    new_x = std::max(0, std::min(new_x, pl.grid.W - cell.w));
-    new_y = std::max(0, std::min(new_y, pl.grid.H - cell.h));
-    
-    // Check if position is valid
-    bool can_place = true;
-    for (int dy = 0; dy < cell.h && can_place; ++dy) {
-        for (int dx = 0; dx < cell.w && can_place; ++dx) {
-            int gx = new_x + dx;
-            int gy = new_y + dy;
-            if (pl.grid.isOccupied(gx, gy) && pl.grid.occ[gy][gx] != cell.id) {
-                can_place = false;
+namespace {
+
+const std::vector<DetailedPlacer::WindowMove> kNoMoves;
+
+// Position of a cell, taking pending moves (a window worker's own cells)
+// into account
+void cellPosition(const Placement& pl, int c, const std::vector<DetailedPlacer::WindowMove>& moved,
+                  int& x, int& y) {
+    for (const auto& m : moved) {
+        if (m.cell == c) {
+            x = m.x;
+            y = m.y;
+            return;
+        }
+    }
+    x = pl.cells[c].x;
+    y = pl.cells[c].y;
+}
+
+// HPWL of a net with one cell moved to (x, y) on top of the pending moves;
+// reads the placement only
+long long netHPWLWith(const Placement& pl, int net, int cell_idx, int x, int y,
+                      const std::vector<DetailedPlacer::WindowMove>& moved = kNoMoves) {
+    const Netlist& nl = pl.netlist;
+    int begin = nl.net_pin_start[net];
+    int end = nl.net_pin_start[net + 1];
+    if (begin == end) return 0;
+
+    int min_x = INT_MAX, max_x = INT_MIN;
+    int min_y = INT_MAX, max_y = INT_MIN;
+    for (int p = begin; p < end; ++p) {
+        int px = 0, py = 0;
+        int c = nl.pin_cell[p];
+        if (c == cell_idx) {
+            px = x + nl.pin_dx[p];
+            py = y + nl.pin_dy[p];
+        } else if (c >= 0) {
+            cellPosition(pl, c, moved, px, py);
+            px += nl.pin_dx[p];
+            py += nl.pin_dy[p];
+        }
+        min_x = std::min(min_x, px);
+        max_x = std::max(max_x, px);
+        min_y = std::min(min_y, py);
+        max_y = std::max(max_y, py);
+    }
+    return static_cast<long long>(max_x - min_x) + (max_y - min_y);
+}
+
+// Seed of a window's RNG in one pass
+unsigned windowSeed(unsigned base, int window) {
+    return base * 0x9e3779b1u + static_cast<unsigned>(window) * 0x85ebca77u;
+}
+
+}  // namespace
+
+bool DetailedPlacer::fits(const Placement& pl, const Cell& cell, int x, int y,
+                          int ignore1, int ignore2) {
+    if (x < 0 || y < 0 || x + cell.w > pl.grid.W || y + cell.h > pl.grid.H) {
+        return false;
+    }
+    for (int gy = y; gy < y + cell.h; ++gy) {
+        for (int gx = x; gx < x + cell.w; ++gx) {
+            int id = pl.grid.cellAt(gx, gy);
+            if (id != -1 && id != ignore1 && id != ignore2) return false;
+        }
+    }
+    return true;
+}
+
+bool DetailedPlacer::optimalRegion(const Placement& pl, int cell_idx,
+                                   int& x0, int& y0, int& x1, int& y1) {
+    const Netlist& nl = pl.netlist;
+    const Cell& cell = pl.cells[cell_idx];
+    std::vector<int> xs, ys;
+
+    for (int k = nl.cell_net_start[cell_idx]; k < nl.cell_net_start[cell_idx + 1]; ++k) {
+        int n = nl.cell_nets[k];
+        bool found = false;
+        int dx = 0, dy = 0;
+        int min_x = 0, max_x = 0, min_y = 0, max_y = 0;
+        bool any = false;
+        for (int p = nl.net_pin_start[n]; p < nl.net_pin_start[n + 1]; ++p) {
+            int c = nl.pin_cell[p];
+            if (c < 0) continue;
+            if (c == cell_idx) {
+                if (!found) {
+                    dx = nl.pin_dx[p];
+                    dy = nl.pin_dy[p];
+                    found = true;
+                }
+                continue;
+            }
+            int px = pl.cells[c].x + nl.pin_dx[p];
+            int py = pl.cells[c].y + nl.pin_dy[p];
+            if (!any) {
+                min_x = max_x = px;
+                min_y = max_y = py;
+                any = true;
+            } else {
+                min_x = std::min(min_x, px);
+                max_x = std::max(max_x, px);
+                min_y = std::min(min_y, py);
+                max_y = std::max(max_y, py);
             }
         }
+        if (!any) continue;
+
+        // Box edges, shifted from pin to cell corner
+        xs.push_back(min_x - dx);
+        xs.push_back(max_x - dx);
+        ys.push_back(min_y - dy);
+        ys.push_back(max_y - dy);
+    }
+    if (xs.empty()) return false;
+
+    // Any position between the two middle edges minimises the HPWL sum
+    std::sort(xs.begin(), xs.end());
+    std::sort(ys.begin(), ys.end());
+    size_t m = xs.size() / 2;
+    x0 = std::max(0, std::min(xs[m - 1], pl.grid.W - cell.w));
+    x1 = std::max(0, std::min(xs[m], pl.grid.W - cell.w));
+    y0 = std::max(0, std::min(ys[m - 1], pl.grid.H - cell.h));
+    y1 = std::max(0, std::min(ys[m], pl.grid.H - cell.h));
+    return true;
+}
+
+bool DetailedPlacer::tryGlobalSwap(Placement& pl, IncrementalCost& cost, int cell_idx) {
+    const Cell& a = pl.cells[cell_idx];
+    if (a.fixed) return false;
+
+    int x0, y0, x1, y1;
+    if (!optimalRegion(pl, cell_idx, x0, y0, x1, y1)) return false;
+    if (a.x >= x0 && a.x <= x1 && a.y >= y0 && a.y <= y1) return false;
+
+    double best_delta = 0.0;
+    int best_swap = -1;
+    int best_x = -1, best_y = -1;
+
+    // Swap with cells whose corner can reach the region
+    std::vector<int> candidates;
+    cost.spatialIndex().query(x0, y0, x1 + a.w, y1 + a.h, [&](int j) {
+        if (j != cell_idx && !pl.cells[j].fixed) candidates.push_back(j);
+    });
+    std::sort(candidates.begin(), candidates.end());
+    if (static_cast<int>(candidates.size()) > kSwapCandidates) {
+        std::shuffle(candidates.begin(), candidates.end(), rng_);
+        candidates.resize(kSwapCandidates);
     }
-    
-    if (!can_place) return false;
-    
-    // Temporarily move cell
-    cell.x = new_x;
-    cell.y = new_y;
-    pl.updateGrid();
-    
-    double new_cost = CostCalculator::calculateTotalCost(pl);
-    
-    // Accept if better
-    if (new_cost < old_cost) {
-        return true;
+
+    for (int j : candidates) {
+        const Cell& b = pl.cells[j];
+
+        // Both footprints must land on free squares and not on each other
+        if (!fits(pl, a, b.x, b.y, a.id, b.id)) continue;
+        if (!fits(pl, b, a.x, a.y, a.id, b.id)) continue;
+        bool clash = b.x < a.x + b.w && a.x < b.x + a.w &&
+                     b.y < a.y + b.h && a.y < b.y + a.h;
+        if (clash) continue;
+
+        double delta = cost.evaluateSwap(cell_idx, j);
+        cost.rollback();
+        if (delta < best_delta) {
+            best_delta = delta;
+            best_swap = j;
+        }
+    }
+
+    // Move to free spots in the region
+    std::uniform_int_distribution<int> rx(x0, x1);
+    std::uniform_int_distribution<int> ry(y0, y1);
+    for (int t = 0; t < kSwapCandidates; ++t) {
+        int x = rx(rng_);
+        int y = ry(rng_);
+        if (!fits(pl, a, x, y, a.id, -1)) continue;
+
+        double delta = cost.evaluateShift(cell_idx, x, y);
+        cost.rollback();
+        if (delta < best_delta) {
+            best_delta = delta;
+            best_swap = -1;
+            best_x = x;
+            best_y = y;
+        }
+    }
+
+    if (best_delta >= 0.0) return false;
+
+    if (best_swap >= 0) {
+        pl.removeCell(cell_idx);
+        pl.removeCell(best_swap);
+        cost.evaluateSwap(cell_idx, best_swap);
+        cost.commit();
+        pl.insertCell(cell_idx);
+        pl.insertCell(best_swap);
     } else {
-        // Revert
-        cell.x = old_x;
-        cell.y = old_y;
-        pl.updateGrid();
-        return false;
+        pl.removeCell(cell_idx);
+        cost.evaluateShift(cell_idx, best_x, best_y);
+        cost.commit();
+        pl.insertCell(cell_idx);
     }
+    return true;
 }
 
-void DetailedPlacer::optimizeWindow(Placement& pl, int center_x, int center_y, int window_size) {
-    // Find cells in window
-    std::vector<Cell*> cells_in_window;
-    
-    for (auto& cell : pl.cells) {
-        if (cell.fixed) continue;
-        
-        int cell_center_x = cell.x + cell.w / 2;
-        int cell_center_y = cell.y + cell.h / 2;
-        
-        if (std::abs(cell_center_x - center_x) <= window_size &&
-            std::abs(cell_center_y - center_y) <= window_size) {
-            cells_in_window.push_back(&cell);
-        }
-    }
-    
-    // Try local moves for cells in window
-    for (Cell* cell : cells_in_window) {
-        tryLocalMove(pl, *cell, window_size / 2);
+std::vector<DetailedPlacer::WindowMove> DetailedPlacer::optimizeWindow(
+        Placement& pl, const IncrementalCost& cost, int x0, int y0, int x1, int y1,
+        int max_shift, std::mt19937& rng) {
+    // Cells whose center lies in the window; the center is inside the
+    // footprint, so these are among the cells intersecting it
+    std::vector<int> cells_in_window;
+    cost.spatialIndex().query(x0, y0, x1, y1, [&](int idx) {
+        const Cell& cell = pl.cells[idx];
+        int cx = cell.x + cell.w / 2;
+        int cy = cell.y + cell.h / 2;
+        if (!cell.fixed && cx >= x0 && cx < x1 && cy >= y0 && cy < y1) {
+            cells_in_window.push_back(idx);
+        }
+    });
+    std::sort(cells_in_window.begin(), cells_in_window.end());
+
+    const Netlist& nl = pl.netlist;
+    std::vector<WindowMove> moves;
+    std::vector<int> slot(cells_in_window.size(), -1);  // Entry in `moves`
+    std::uniform_int_distribution<int> dist(-max_shift, max_shift);
+    for (int round = 0; round < kLocalRounds; ++round) {
+        for (size_t i = 0; i < cells_in_window.size(); ++i) {
+            int idx = cells_in_window[i];
+            const Cell& start = pl.cells[idx];
+            Cell cell = start;
+            if (slot[i] >= 0) {
+                cell.x = moves[slot[i]].x;
+                cell.y = moves[slot[i]].y;
+            }
+
+            // Stay within max_shift of the start position, which keeps
+            // the cell within reach of its window
+            int new_x = std::max(start.x - max_shift, std::min(cell.x + dist(rng), start.x + max_shift));
+            int new_y = std::max(start.y - max_shift, std::min(cell.y + dist(rng), start.y + max_shift));
+            new_x = std::max(0, std::min(new_x, pl.grid.W - cell.w));
+            new_y = std::max(0, std::min(new_y, pl.grid.H - cell.h));
+            if (new_x == cell.x && new_y == cell.y) continue;
+            if (!fits(pl, cell, new_x, new_y, cell.id, -1)) continue;
+
+            // Cells of other windows do not move until the barrier
+            long long delta = 0;
+            for (int k = nl.cell_net_start[idx]; k < nl.cell_net_start[idx + 1]; ++k) {
+                int n = nl.cell_nets[k];
+                delta += netHPWLWith(pl, n, idx, new_x, new_y, moves) -
+                         netHPWLWith(pl, n, idx, cell.x, cell.y, moves);
+            }
+            if (delta >= 0) continue;
+
+            pl.grid.erase(cell);
+            cell.x = new_x;
+            cell.y = new_y;
+            pl.grid.paint(cell);
+            if (slot[i] < 0) {
+                slot[i] = static_cast<int>(moves.size());
+                moves.push_back(WindowMove{idx, new_x, new_y});
+            } else {
+                moves[slot[i]].x = new_x;
+                moves[slot[i]].y = new_y;
+            }
+        }
     }
+    return moves;
 }
 
-void DetailedPlacer::detailedPlace(Placement& pl, int window_size, int max_iterations) {
-    std::cout << "Performing detailed placement..." << std::endl;
-    
-    double initial_cost = CostCalculator::calculateTotalCost(pl);
-    
-    for (int iter = 0; iter < max_iterations; ++iter) {
-        // Divide grid into windows and optimize each
-        int num_windows_x = (pl.grid.W + window_size - 1) / window_size;
-        int num_windows_y = (pl.grid.H + window_size - 1) / window_size;
-        
-        for (int wy = 0; wy < num_windows_y; ++wy) {
-            for (int wx = 0; wx < num_windows_x; ++wx) {
-                int center_x = (wx + 0.5) * window_size;
-                int center_y = (wy + 0.5) * window_size;
-                
-                optimizeWindow(pl, center_x, center_y, window_size);
+int DetailedPlacer::windowPass(Placement& pl, IncrementalCost& cost, ThreadPool& pool,
+                               int window_size, WindowPassStats& stats) {
+    ProfileScope scope("detail_window_pass");
+    auto start = std::chrono::steady_clock::now();
+    const int max_shift = window_size / 2;
+    const int num_windows_x = (pl.grid.W + window_size - 1) / window_size;
+    const int num_windows_y = (pl.grid.H + window_size - 1) / window_size;
+
+    // A moved cell stays within reach of its window, so windows k apart
+    // touch disjoint grid squares
+    int reach = max_shift;
+    for (const auto& cell : pl.cells) {
+        if (!cell.fixed) reach = std::max(reach, std::max(cell.w, cell.h) + max_shift);
+    }
+    const int k = 1 + (2 * reach + window_size - 1) / window_size;
+
+    const unsigned base = rng_();
+    stats = WindowPassStats();
+    stats.colours = k * k;
+    stats.threads = pool.size();
+
+    for (int colour = 0; colour < k * k; ++colour) {
+        std::vector<int> windows;
+        for (int wy = colour / k; wy < num_windows_y; wy += k) {
+            for (int wx = colour % k; wx < num_windows_x; wx += k) {
+                windows.push_back(wy * num_windows_x + wx);
             }
         }
-        
-        double current_cost = CostCalculator::calculateTotalCost(pl);
-        
-        if (iter % 5 == 0 || iter == max_iterations - 1) {
-            std::cout << "  Iteration " << iter << ": cost = " << current_cost << std::endl;
+        if (windows.empty()) continue;
+
+        // Contiguous chunks of windows per task
+        const int count = static_cast<int>(windows.size());
+        const int chunks = std::min(count, 4 * pool.size());
+        std::vector<std::vector<WindowMove>> window_moves(count);
+        std::vector<double> chunk_busy(chunks, 0.0);
+        pool.parallelFor(chunks, [&](int c) {
+            auto chunk_start = std::chrono::steady_clock::now();
+            for (int i = c * count / chunks; i < (c + 1) * count / chunks; ++i) {
+                int x0 = (windows[i] % num_windows_x) * window_size;
+                int y0 = (windows[i] / num_windows_x) * window_size;
+                std::mt19937 rng(windowSeed(base, windows[i]));
+                window_moves[i] = optimizeWindow(pl, cost, x0, y0, x0 + window_size,
+                                                 y0 + window_size, max_shift, rng);
+            }
+            std::chrono::duration<double> busy = std::chrono::steady_clock::now() - chunk_start;
+            chunk_busy[c] = busy.count();
+        });
+        for (double b : chunk_busy) stats.busy += b;
+
+        // Barrier: windows on shared nets were scored against each other's
+        // old positions, so the engine has the final word
+        for (const auto& moves : window_moves) {
+            if (moves.empty()) continue;
+            std::vector<int> cells, xs, ys;
+            for (const auto& m : moves) {
+                cells.push_back(m.cell);
+                xs.push_back(m.x);
+                ys.push_back(m.y);
+            }
+            if (cost.evaluateMoves(cells, xs, ys) < 0) {
+                cost.commit();
+                stats.moves += static_cast<int>(cells.size());
+            } else {
+                // The grid holds the new footprints: put the old ones back
+                for (int idx : cells) pl.removeCell(idx);
+                cost.rollback();
+                for (int idx : cells) pl.insertCell(idx);
+            }
+        }
+    }
+
+    std::chrono::duration<double> wall = std::chrono::steady_clock::now() - start;
+    stats.wall = wall.count();
+    return stats.moves;
+}
+
+std::vector<DetailedPlacer::MatchSet> DetailedPlacer::buildSets(const Placement& pl,
+                                                                const IncrementalCost& cost,
+                                                                int x0, int y0, int x1, int y1) {
+    std::vector<int> in_window;
+    cost.spatialIndex().query(x0, y0, x1, y1, [&](int idx) {
+        const Cell& cell = pl.cells[idx];
+        if (!cell.fixed && cell.x >= x0 && cell.x < x1 && cell.y >= y0 && cell.y < y1) {
+            in_window.push_back(idx);
+        }
+    });
+
+    // Same-size cells can take each other's positions without changing
+    // overlap or density
+    std::stable_sort(in_window.begin(), in_window.end(), [&](int a, int b) {
+        const Cell& ca = pl.cells[a];
+        const Cell& cb = pl.cells[b];
+        if (ca.w != cb.w) return ca.w < cb.w;
+        if (ca.h != cb.h) return ca.h < cb.h;
+        return a < b;
+    });
+
+    // Greedy independent sets, first fit: a cell joins the first open set
+    // of its size that shares no net with it, or opens a new one. With no
+    // shared nets the HPWL change is a sum over cells, so the assignment is
+    // exact.
+    const Netlist& nl = pl.netlist;
+    std::vector<MatchSet> sets;
+    std::vector<MatchSet> open;
+    std::vector<std::vector<int>> open_nets;
+    auto close = [&](size_t k) {
+        if (open[k].cells.size() >= 2) sets.push_back(open[k]);
+        open.erase(open.begin() + k);
+        open_nets.erase(open_nets.begin() + k);
+    };
+    for (int idx : in_window) {
+        if (!open.empty()) {
+            const Cell& first = pl.cells[open[0].cells[0]];
+            if (first.w != pl.cells[idx].w || first.h != pl.cells[idx].h) {
+                while (!open.empty()) close(0);
+            }
+        }
+        size_t k = 0;
+        for (; k < open.size(); ++k) {
+            bool shares = false;
+            for (int j = nl.cell_net_start[idx]; j < nl.cell_net_start[idx + 1] && !shares; ++j) {
+                shares = std::find(open_nets[k].begin(), open_nets[k].end(),
+                                   nl.cell_nets[j]) != open_nets[k].end();
+            }
+            if (!shares) break;
+        }
+        if (k == open.size()) {
+            open.emplace_back();
+            open_nets.emplace_back();
         }
-        
-        // Early termination if no improvement
-        if (current_cost >= initial_cost * 0.999) {
+
+        open[k].cells.push_back(idx);
+        open[k].slot_x.push_back(pl.cells[idx].x);
+        open[k].slot_y.push_back(pl.cells[idx].y);
+        open_nets[k].insert(open_nets[k].end(), nl.cell_nets.begin() + nl.cell_net_start[idx],
+                            nl.cell_nets.begin() + nl.cell_net_start[idx + 1]);
+        if (static_cast<int>(open[k].cells.size()) == kMaxSetSize) close(k);
+    }
+    while (!open.empty()) close(0);
+    return sets;
+}
+
+void DetailedPlacer::matchSet(const Placement& pl, MatchSet& set) {
+    const Netlist& nl = pl.netlist;
+    const int n = static_cast<int>(set.cells.size());
+
+    // cost[i][j]: HPWL of cell i's nets with cell i on slot j
+    std::vector<double> matrix(static_cast<size_t>(n) * n, 0.0);
+    for (int i = 0; i < n; ++i) {
+        int idx = set.cells[i];
+        for (int j = 0; j < n; ++j) {
+            long long h = 0;
+            for (int k = nl.cell_net_start[idx]; k < nl.cell_net_start[idx + 1]; ++k) {
+                h += netHPWLWith(pl, nl.cell_nets[k], idx, set.slot_x[j], set.slot_y[j]);
+            }
+            matrix[static_cast<size_t>(i) * n + j] = static_cast<double>(h);
+        }
+    }
+
+    double current = 0.0;
+    for (int i = 0; i < n; ++i) current += matrix[static_cast<size_t>(i) * n + i];
+    set.gain = current - AssignmentSolver::solve(matrix, n, set.assign);
+}
+
+int DetailedPlacer::applySet(Placement& pl, IncrementalCost& cost, const MatchSet& set) {
+    if (set.gain < 0.5) return 0;
+
+    std::vector<int> cells, xs, ys;
+    for (size_t i = 0; i < set.cells.size(); ++i) {
+        int j = set.assign[i];
+        if (j == static_cast<int>(i)) continue;
+        cells.push_back(set.cells[i]);
+        xs.push_back(set.slot_x[j]);
+        ys.push_back(set.slot_y[j]);
+    }
+    if (cells.empty()) return 0;
+
+    // Sets of other windows may have moved cells on shared nets since this
+    // one was solved, so the engine has the final word
+    for (int idx : cells) pl.removeCell(idx);
+    bool accept = cost.evaluateMoves(cells, xs, ys) < 0;
+    if (accept) {
+        cost.commit();
+    } else {
+        cost.rollback();
+    }
+    for (int idx : cells) pl.insertCell(idx);
+    return accept ? static_cast<int>(cells.size()) : 0;
+}
+
+int DetailedPlacer::independentSetPass(Placement& pl, IncrementalCost& cost, ThreadPool& pool,
+                                       int window_size) {
+    ProfileScope scope("detail_independent_set");
+    int num_windows_x = (pl.grid.W + window_size - 1) / window_size;
+    int num_windows_y = (pl.grid.H + window_size - 1) / window_size;
+
+    int moved = 0;
+    for (int colour = 0; colour < 4; ++colour) {
+        std::vector<int> windows;
+        for (int wy = colour / 2; wy < num_windows_y; wy += 2) {
+            for (int wx = colour % 2; wx < num_windows_x; wx += 2) {
+                windows.push_back(wy * num_windows_x + wx);
+            }
+        }
+
+        // Build and solve concurrently; nothing is moved until all are done
+        std::vector<std::vector<MatchSet>> window_sets(windows.size());
+        pool.parallelFor(static_cast<int>(windows.size()), [&](int i) {
+            int x0 = (windows[i] % num_windows_x) * window_size;
+            int y0 = (windows[i] / num_windows_x) * window_size;
+            window_sets[i] = buildSets(pl, cost, x0, y0, x0 + window_size, y0 + window_size);
+            for (auto& set : window_sets[i]) matchSet(pl, set);
+        });
+
+        for (const auto& sets : window_sets) {
+            for (const auto& set : sets) moved += applySet(pl, cost, set);
+        }
+    }
+    return moved;
+}
+
+int DetailedPlacer::globalSwapPass(Placement& pl, IncrementalCost& cost) {
+    ProfileScope scope("detail_global_swap");
+    int accepted = 0;
+    for (size_t i = 0; i < pl.cells.size(); ++i) {
+        if (tryGlobalSwap(pl, cost, static_cast<int>(i))) accepted++;
+    }
+    return accepted;
+}
+
+void DetailedPlacer::detailedPlace(Placement& pl, int window_size, int max_iterations) {
+    std::cout << "Performing detailed placement..." << std::endl;
+
+    // Moves are checked against the occupancy grid
+    if (!pl.grid.hasOccupancy()) {
+        pl.grid = Grid(pl.grid.W, pl.grid.H);
+        pl.updateGrid();
+    }
+
+    IncrementalCost cost(pl, lambda_overlap_, lambda_density_);
+    ThreadPool pool(num_threads_);
+    double initial_cost = cost.totalCost();
+    double prev_cost = initial_cost;
+
+    for (int iter = 0; iter < max_iterations; ++iter) {
+        WindowPassStats stats;
+        int local_moves = windowPass(pl, cost, pool, window_size, stats);
+        int ism_moves = independentSetPass(pl, cost, pool, kIsmWindowScale * window_size);
+        int global_moves = globalSwapPass(pl, cost);
+        double current_cost = cost.totalCost();
+
+        std::cout << "  Iteration " << iter << ": cost = " << current_cost
+                  << ", local moves = " << local_moves
+                  << ", ISM moves = " << ism_moves
+                  << ", global moves = " << global_moves << std::endl;
+        std::cout << "    Window pass: " << stats.wall << " s, " << stats.colours
+                  << " colours on " << stats.threads << " threads, parallel efficiency "
+                  << 100.0 * stats.efficiency() << "%" << std::endl;
+
+        // Early termination if the iteration gained less than 0.1%
+        if (current_cost >= prev_cost * 0.999) {
             break;
         }
+        prev_cost = current_cost;
     }
-    
-    double final_cost = CostCalculator::calculateTotalCost(pl);
+
+    double final_cost = cost.totalCost();
     std::cout << "Detailed placement: " << initial_cost << " -> " << final_cost << std::endl;
 }
-
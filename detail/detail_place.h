@@ -2,21 +2,134 @@
 #define DETAIL_PLACE_H
 
 #include "../model/placement.h"
+#include "../cost/incremental_cost.h"
+#include <random>
+#include <vector>
 
-// Detailed placement: local refinement to further reduce wire length
+class ThreadPool;
+
+// Detailed placement: local refinement to further reduce wire length.
+// Every iteration runs a parallel window pass of small random shifts, an
+// independent-set matching pass and a global swap pass that moves cells
+// toward their optimal region. All moves are
+// scored with the incremental cost engine and only keep the placement
+// legal: a cell only moves onto free grid squares.
 
 class DetailedPlacer {
 public:
+    explicit DetailedPlacer(double lambda_overlap = 1.0, double lambda_density = 0.1)
+        : lambda_overlap_(lambda_overlap), lambda_density_(lambda_density),
+          num_threads_(0), rng_(std::random_device{}()) {}
+
+    // Seed the move generator; without a seed runs are not reproducible
+    void setSeed(unsigned seed) { rng_.seed(seed); }
+
+    // Worker threads for the window and matching passes (<= 0: all cores)
+    void setThreads(int num_threads) { num_threads_ = num_threads; }
+
     // Perform detailed placement refinement
-    static void detailedPlace(Placement& pl, int window_size = 5, int max_iterations = 10);
-    
-    // Optimize within a local window
-    static void optimizeWindow(Placement& pl, int center_x, int center_y, int window_size);
-    
+    void detailedPlace(Placement& pl, int window_size = 5, int max_iterations = 10);
+
+    // A position chosen for a cell by a window worker
+    struct WindowMove { int cell, x, y; };
+
+    // Timing of one window pass
+    struct WindowPassStats {
+        int moves = 0;        // Cells moved by accepted windows
+        int colours = 0;      // Colours (barriers) in the schedule
+        int threads = 1;
+        double wall = 0.0;    // Seconds for the whole pass
+        double busy = 0.0;    // Seconds spent inside window workers
+
+        // Share of the threads' time spent on window work
+        double efficiency() const {
+            return wall > 0.0 ? busy / (wall * threads) : 0.0;
+        }
+    };
+
+    // Window pass: the die is tiled into windows and every movable cell
+    // tries a few small random shifts in the window holding its center. The
+    // windows are coloured so that same-colour windows are further apart
+    // than any moved cell's footprint can reach; each colour runs on the
+    // pool, followed by a barrier where the windows' moves are checked with
+    // the cost engine and kept or undone in window order. Each window has
+    // its own RNG seeded from this placer's RNG, so results only depend on
+    // the seed.
+    int windowPass(Placement& pl, IncrementalCost& cost, ThreadPool& pool, int window_size,
+                   WindowPassStats& stats);
+
+    // Window worker: shift the movable cells whose center lies in
+    // [x0, x1) x [y0, y1), up to max_shift from where they started, keeping
+    // shifts onto free squares that reduce HPWL. Reads cell positions only and updates the
+    // grid squares the moved cells leave and take; returns the moves.
+    static std::vector<WindowMove> optimizeWindow(Placement& pl, const IncrementalCost& cost,
+                                                  int x0, int y0, int x1, int y1,
+                                                  int max_shift, std::mt19937& rng);
+
+    // Independent-set matching: in every window, groups of same-size
+    // movable cells that share no nets are re-assigned to each other's
+    // positions by an optimal assignment. Windows of one colour of a 2x2
+    // colouring are far enough apart to be matched concurrently; results
+    // are applied in window order. Returns the number of cells moved.
+    int independentSetPass(Placement& pl, IncrementalCost& cost, ThreadPool& pool,
+                           int window_size);
+
+    // Try to move every movable cell into (or swap it with a cell in) its
+    // optimal region; returns the number of accepted moves
+    int globalSwapPass(Placement& pl, IncrementalCost& cost);
+
+    // Optimal region of a cell: the range of positions (for its lower-left
+    // corner) between the medians of its nets' bounding-box edges, with the
+    // cell itself left out of the boxes. False if it has no other pins.
+    static bool optimalRegion(const Placement& pl, int cell_idx,
+                              int& x0, int& y0, int& x1, int& y1);
+
 private:
-    // Try small perturbations in a window
-    static bool tryLocalMove(Placement& pl, Cell& cell, int window_size);
+    double lambda_overlap_;
+    double lambda_density_;
+    int num_threads_;
+    std::mt19937 rng_;
+
+    // Candidates tried per global swap
+    static const int kSwapCandidates = 8;
+
+    // Shifts tried per cell in a window pass
+    static const int kLocalRounds = 4;
+
+    // Largest independent set matched at once, and ISM window size relative
+    // to the local-move window
+    static const int kMaxSetSize = 16;
+    static const int kIsmWindowScale = 3;
+
+    // Independent set with its slots (the cells' positions when the set was
+    // built) and the optimal slot for each cell
+    struct MatchSet {
+        std::vector<int> cells;
+        std::vector<int> slot_x, slot_y;
+        std::vector<int> assign;
+        double gain = 0.0;  // HPWL saved by the assignment
+    };
+
+    // Independent sets of the movable cells whose lower-left corner lies in
+    // [x0, x1) x [y0, y1); reads the placement only
+    static std::vector<MatchSet> buildSets(const Placement& pl, const IncrementalCost& cost,
+                                           int x0, int y0, int x1, int y1);
+
+    // Solve the assignment of a set; reads the placement only
+    static void matchSet(const Placement& pl, MatchSet& set);
+
+    // Move a matched set to its assignment if the engine agrees it improves
+    // the cost; returns the number of cells moved
+    static int applySet(Placement& pl, IncrementalCost& cost, const MatchSet& set);
+
+    // Try swaps and free spots in the cell's optimal region; keeps the best
+    // improving one
+    bool tryGlobalSwap(Placement& pl, IncrementalCost& cost, int cell_idx);
+
+    // True if `cell` fits at (x, y) on squares that are free or belong to
+    // the cells `ignore1`/`ignore2`
+    static bool fits(const Placement& pl, const Cell& cell, int x, int y,
+                     int ignore1, int ignore2);
 };
 
 #endif // DETAIL_PLACE_H
-
@@ -0,0 +1,486 @@
+#include "electrostatic_place.h"
+#include "poisson.h"
+#include "quadratic_place.h"
+#include "../cost/cost.h"
+#include "../util/profiler.h"
+#include "../util/thread_pool.h"
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <iostream>
+#include <random>
+
+namespace {
+
+// Work is split into this many chunks whatever the thread count, so
+// partial sums always combine in the same order
+const int kChunks = 16;
+
+// Bins per side: about one bin per charge, within these limits
+const int kMinBins = 16;
+const int kMaxBins = 1024;
+
+// WA smoothing length: gamma = kGammaScale * bin * 10^(k * overflow + b)
+const double kGammaScale = 8.0;
+const double kGammaK = 20.0 / 9.0;
+const double kGammaB = -11.0 / 9.0;
+
+// Lambda growth per iteration is kLambdaBase^(1 - dWL / (kWlRef * WL)),
+// clamped to [kLambdaMin, kLambdaBase]
+const double kLambdaBase = 1.1;
+const double kLambdaMin = 0.95;
+const double kWlRef = 0.01;
+
+// Backtracking tries per Nesterov step
+const int kMaxBacktracks = 10;
+
+// Progress means the overflow fell by kProgress (relative) since the last
+// progress. Lambda stops growing after kFreezeIterations without progress,
+// and the loop ends after kPlateauIterations.
+const double kProgress = 0.02;
+const int kFreezeIterations = 20;
+const int kPlateauIterations = 100;
+
+// Iterates within this overflow of the best are compared by HPWL
+const double kOverflowTolerance = 0.005;
+
+void forChunks(ThreadPool& pool, int n, const std::function<void(int, int, int)>& fn) {
+    pool.parallelFor(kChunks, [&](int c) {
+        fn(c, static_cast<int>(static_cast<long long>(n) * c / kChunks),
+           static_cast<int>(static_cast<long long>(n) * (c + 1) / kChunks));
+    });
+}
+
+double distance(const std::vector<double>& a0, const std::vector<double>& b0,
+                const std::vector<double>& a1, const std::vector<double>& b1) {
+    double sum = 0.0;
+    for (size_t i = 0; i < a0.size(); ++i) {
+        double da = a0[i] - a1[i], db = b0[i] - b1[i];
+        sum += da * da + db * db;
+    }
+    return std::sqrt(sum);
+}
+
+// Bin geometry shared by the density kernels
+struct Bins {
+    int m;
+    double bw, bh;
+
+    int clampX(double x) const { return std::max(0, std::min(static_cast<int>(x / bw), m - 1)); }
+    int clampY(double y) const { return std::max(0, std::min(static_cast<int>(y / bh), m - 1)); }
+
+    // Call fn(bin, overlap area) for every bin a rectangle covers
+    template <typename Fn>
+    void forOverlaps(double x0, double y0, double x1, double y1, Fn fn) const {
+        int bx0 = clampX(x0), bx1 = clampX(x1);
+        int by0 = clampY(y0), by1 = clampY(y1);
+        for (int by = by0; by <= by1; ++by) {
+            double oy = std::min(y1, (by + 1) * bh) - std::max(y0, by * bh);
+            if (oy <= 0.0) continue;
+            for (int bx = bx0; bx <= bx1; ++bx) {
+                double ox = std::min(x1, (bx + 1) * bw) - std::max(x0, bx * bw);
+                if (ox > 0.0) fn(by * m + bx, ox * oy);
+            }
+        }
+    }
+};
+
+int defaultBins(int charges) {
+    int m = kMinBins;
+    while (m < kMaxBins && static_cast<long long>(m) * m < charges) m *= 2;
+    return m;
+}
+
+}  // namespace
+
+ElectrostaticPlacer::Metrics ElectrostaticPlacer::gradient(
+        const Placement& pl, const State& st, const PoissonSolver& poisson,
+        const std::vector<double>& fixed_density, double lambda,
+        const std::vector<double>& x, const std::vector<double>& y,
+        std::vector<double>& gx, std::vector<double>& gy, ThreadPool& pool, Workspace& ws) {
+    ProfileScope scope("electrostatic_gradient");
+    Metrics metrics;
+    const Netlist& nl = pl.netlist;
+    const int num_vars = static_cast<int>(x.size());
+    const int num_pins = nl.numPins();
+    const int m = poisson.bins();
+    const Bins bins{m, static_cast<double>(pl.grid.W) / m, static_cast<double>(pl.grid.H) / m};
+    const double bin_area = bins.bw * bins.bh;
+    const double gamma = st.gamma;
+
+    // Pin positions
+    std::vector<double>& px = ws.px;
+    std::vector<double>& py = ws.py;
+    px.resize(num_pins);
+    py.resize(num_pins);
+    forChunks(pool, num_pins, [&](int, int begin, int end) {
+        for (int p = begin; p < end; ++p) {
+            int c = nl.pin_cell[p];
+            if (c < 0) {
+                px[p] = py[p] = 0.0;
+                continue;
+            }
+            int v = st.var[c];
+            if (v >= 0) {
+                px[p] = x[v] - 0.5 * st.w[v] + nl.pin_dx[p];
+                py[p] = y[v] - 0.5 * st.h[v] + nl.pin_dy[p];
+            } else {
+                px[p] = pl.cells[c].x + nl.pin_dx[p];
+                py[p] = pl.cells[c].y + nl.pin_dy[p];
+            }
+        }
+    });
+
+    // Weighted-average wirelength and its gradient per pin
+    std::vector<double>& pgx = ws.pgx;
+    std::vector<double>& pgy = ws.pgy;
+    pgx.assign(num_pins, 0.0);
+    pgy.assign(num_pins, 0.0);
+    std::vector<double> chunk_wa(kChunks, 0.0), chunk_hpwl(kChunks, 0.0);
+    forChunks(pool, nl.numNets(), [&](int chunk, int begin, int end) {
+        double wa = 0.0, hpwl = 0.0;
+        auto axis = [&](const std::vector<double>& pos, std::vector<double>& grad, int p0, int p1) {
+            double hi = -1e300, lo = 1e300;
+            for (int p = p0; p < p1; ++p) {
+                if (nl.pin_cell[p] < 0) continue;
+                hi = std::max(hi, pos[p]);
+                lo = std::min(lo, pos[p]);
+            }
+            // Exponents relative to the extremes, so nothing overflows
+            double sa = 0.0, xa = 0.0, sb = 0.0, xb = 0.0;
+            for (int p = p0; p < p1; ++p) {
+                if (nl.pin_cell[p] < 0) continue;
+                double d = pos[p] - hi, e = pos[p] - lo;
+                double a = std::exp(d / gamma), b = std::exp(-e / gamma);
+                sa += a;
+                xa += d * a;
+                sb += b;
+                xb += e * b;
+            }
+            for (int p = p0; p < p1; ++p) {
+                if (nl.pin_cell[p] < 0) continue;
+                double d = pos[p] - hi, e = pos[p] - lo;
+                double a = std::exp(d / gamma), b = std::exp(-e / gamma);
+                grad[p] = a * (sa + (d * sa - xa) / gamma) / (sa * sa) -
+                          b * (sb - (e * sb - xb) / gamma) / (sb * sb);
+            }
+            wa += (xa / sa + hi) - (xb / sb + lo);
+            hpwl += hi - lo;
+        };
+        for (int n = begin; n < end; ++n) {
+            int p0 = nl.net_pin_start[n], p1 = nl.net_pin_start[n + 1];
+            int pins = 0;
+            for (int p = p0; p < p1; ++p) {
+                if (nl.pin_cell[p] >= 0) pins++;
+            }
+            if (pins < 2) continue;
+            axis(px, pgx, p0, p1);
+            axis(py, pgy, p0, p1);
+        }
+        chunk_wa[chunk] = wa;
+        chunk_hpwl[chunk] = hpwl;
+    });
+    for (int c = 0; c < kChunks; ++c) {
+        metrics.wa += chunk_wa[c];
+        metrics.hpwl += chunk_hpwl[c];
+    }
+
+    // Density: partial maps per chunk, combined in chunk order
+    const size_t nb = static_cast<size_t>(m) * m;
+    std::vector<std::vector<double>>& part_all = ws.part_all;
+    std::vector<std::vector<double>>& part_real = ws.part_real;
+    part_all.resize(kChunks);
+    part_real.resize(kChunks);
+    forChunks(pool, num_vars, [&](int chunk, int begin, int end) {
+        std::vector<double>& all = part_all[chunk];
+        std::vector<double>& real = part_real[chunk];
+        all.assign(nb, 0.0);
+        real.assign(nb, 0.0);
+        for (int v = begin; v < end; ++v) {
+            const bool is_real = v < st.num_cells;
+            bins.forOverlaps(x[v] - 0.5 * st.dw[v], y[v] - 0.5 * st.dh[v],
+                             x[v] + 0.5 * st.dw[v], y[v] + 0.5 * st.dh[v], [&](int b, double area) {
+                all[b] += st.scale[v] * area;
+                if (is_real) real[b] += st.scale[v] * area;
+            });
+        }
+    });
+    // Combined by bin range; each bin still adds the chunks in order. The
+    // overflow of the real cells is the area above the target share of
+    // free space.
+    std::vector<double>& rho = ws.rho;
+    std::vector<double>& real_area = ws.real_area;
+    rho.resize(nb);
+    real_area.resize(nb);
+    std::vector<double> chunk_over(kChunks, 0.0);
+    forChunks(pool, static_cast<int>(nb), [&](int chunk, int begin, int end) {
+        double over = 0.0;
+        for (int b = begin; b < end; ++b) {
+            double r = fixed_density[b], ra = 0.0;
+            for (int c = 0; c < kChunks; ++c) {
+                r += part_all[c][b];
+                ra += part_real[c][b];
+            }
+            rho[b] = r / bin_area;
+            real_area[b] = ra;
+            over += std::max(0.0, ra + fixed_density[b] - bin_area * st.target_density);
+        }
+        chunk_over[chunk] = over;
+    });
+    double over = 0.0, total = 0.0;
+    for (int c = 0; c < kChunks; ++c) over += chunk_over[c];
+    for (int v = 0; v < st.num_cells; ++v) total += st.w[v] * st.h[v];
+
+    std::vector<double>& field_x = ws.field_x;
+    std::vector<double>& field_y = ws.field_y;
+    poisson.solve(rho, ws.psi, field_x, field_y, &pool);
+
+    // Charge gradient (-q * field) plus wirelength, preconditioned
+    gx.assign(num_vars, 0.0);
+    gy.assign(num_vars, 0.0);
+    std::vector<double> chunk_wl_norm(kChunks, 0.0), chunk_density_norm(kChunks, 0.0);
+    forChunks(pool, num_vars, [&](int chunk, int begin, int end) {
+        double wl_norm = 0.0, density_norm = 0.0;
+        for (int v = begin; v < end; ++v) {
+            double fx = 0.0, fy = 0.0;
+            bins.forOverlaps(x[v] - 0.5 * st.dw[v], y[v] - 0.5 * st.dh[v],
+                             x[v] + 0.5 * st.dw[v], y[v] + 0.5 * st.dh[v], [&](int b, double area) {
+                fx += area * field_x[b];
+                fy += area * field_y[b];
+            });
+            double wx = 0.0, wy = 0.0;
+            if (v < st.num_cells) {
+                int c = st.cell[v];
+                for (int k = nl.cell_pin_start[c]; k < nl.cell_pin_start[c + 1]; ++k) {
+                    wx += pgx[nl.cell_pins[k]];
+                    wy += pgy[nl.cell_pins[k]];
+                }
+            }
+            fx *= -st.scale[v];
+            fy *= -st.scale[v];
+            wl_norm += std::fabs(wx) + std::fabs(wy);
+            density_norm += std::fabs(fx) + std::fabs(fy);
+            double precond = std::max(1.0, st.precond_pins[v] + lambda * st.w[v] * st.h[v]);
+            gx[v] = (wx + lambda * fx) / precond;
+            gy[v] = (wy + lambda * fy) / precond;
+        }
+        chunk_wl_norm[chunk] = wl_norm;
+        chunk_density_norm[chunk] = density_norm;
+    });
+    for (int c = 0; c < kChunks; ++c) {
+        metrics.wl_norm += chunk_wl_norm[c];
+        metrics.density_norm += chunk_density_norm[c];
+    }
+
+    metrics.overflow = total > 0.0 ? over / total : 0.0;
+    return metrics;
+}
+
+void ElectrostaticPlacer::place(Placement& pl, const ElectrostaticOptions& options) {
+    // Start from the wirelength-optimal (clumped) quadratic solution
+    GlobalPlaceOptions qp;
+    qp.max_iterations = 0;
+    qp.num_threads = options.num_threads;
+    QuadraticPlacer::place(pl, qp);
+
+    std::cout << "Electrostatic global placement..." << std::endl;
+    const Netlist& nl = pl.netlist;
+
+    State st;
+    st.target_density = options.target_density;
+    st.var.assign(pl.cells.size(), -1);
+    double movable_area = 0.0, fixed_area = 0.0, sum_w = 0.0, sum_h = 0.0;
+    std::vector<double> x, y;
+    for (size_t i = 0; i < pl.cells.size(); ++i) {
+        const Cell& cell = pl.cells[i];
+        if (cell.fixed) {
+            fixed_area += static_cast<double>(cell.w) * cell.h;
+            continue;
+        }
+        st.var[i] = static_cast<int>(st.cell.size());
+        st.cell.push_back(static_cast<int>(i));
+        st.w.push_back(cell.w);
+        st.h.push_back(cell.h);
+        st.precond_pins.push_back(nl.cell_pin_start[i + 1] - nl.cell_pin_start[i]);
+        x.push_back(cell.x + 0.5 * cell.w);
+        y.push_back(cell.y + 0.5 * cell.h);
+        movable_area += static_cast<double>(cell.w) * cell.h;
+        sum_w += cell.w;
+        sum_h += cell.h;
+    }
+    st.num_cells = static_cast<int>(st.cell.size());
+    if (st.num_cells == 0) {
+        std::cout << "No movable cells to place" << std::endl;
+        return;
+    }
+
+    // Fillers of average cell size take up the whitespace above the target
+    const double die_area = static_cast<double>(pl.grid.W) * pl.grid.H;
+    const double filler_w = sum_w / st.num_cells, filler_h = sum_h / st.num_cells;
+    const double filler_area = options.target_density * (die_area - fixed_area) - movable_area;
+    const int num_fillers = filler_area > 0.0 ? static_cast<int>(filler_area / (filler_w * filler_h)) : 0;
+    std::mt19937 rng(options.seed);
+    std::uniform_real_distribution<double> fx(0.5 * filler_w, pl.grid.W - 0.5 * filler_w);
+    std::uniform_real_distribution<double> fy(0.5 * filler_h, pl.grid.H - 0.5 * filler_h);
+    for (int i = 0; i < num_fillers; ++i) {
+        st.w.push_back(filler_w);
+        st.h.push_back(filler_h);
+        st.precond_pins.push_back(0.0);
+        x.push_back(fx(rng));
+        y.push_back(fy(rng));
+    }
+    const int num_vars = static_cast<int>(x.size());
+
+    const int m = options.bins > 0 ? options.bins : defaultBins(num_vars);
+    const Bins bins{m, static_cast<double>(pl.grid.W) / m, static_cast<double>(pl.grid.H) / m};
+    PoissonSolver poisson(m, pl.grid.W, pl.grid.H);
+
+    // Charges smaller than a bin are stretched to sqrt(2) bins, keeping
+    // their area, so the density they see is smooth
+    for (int v = 0; v < num_vars; ++v) {
+        st.dw.push_back(std::max(st.w[v], std::sqrt(2.0) * bins.bw));
+        st.dh.push_back(std::max(st.h[v], std::sqrt(2.0) * bins.bh));
+        st.scale.push_back(st.w[v] * st.h[v] / (st.dw[v] * st.dh[v]));
+    }
+
+    // Fixed cells are static charges at the target density
+    std::vector<double> fixed_density(static_cast<size_t>(m) * m, 0.0);
+    for (const auto& cell : pl.cells) {
+        if (!cell.fixed) continue;
+        bins.forOverlaps(cell.x, cell.y, cell.x + cell.w, cell.y + cell.h, [&](int b, double area) {
+            fixed_density[b] += options.target_density * area;
+        });
+    }
+
+    ThreadPool pool(options.num_threads);
+    auto clampAll = [&](std::vector<double>& cx, std::vector<double>& cy) {
+        for (int v = 0; v < num_vars; ++v) {
+            cx[v] = std::max(0.5 * st.w[v], std::min(cx[v], pl.grid.W - 0.5 * st.w[v]));
+            cy[v] = std::max(0.5 * st.h[v], std::min(cy[v], pl.grid.H - 0.5 * st.h[v]));
+        }
+    };
+    clampAll(x, y);
+
+    // Initial lambda balances the two gradient terms
+    Workspace ws;
+    std::vector<double> g_vx, g_vy;
+    st.gamma = kGammaScale * bins.bw * std::pow(10.0, kGammaK + kGammaB);
+    Metrics cur = gradient(pl, st, poisson, fixed_density, 0.0, x, y, g_vx, g_vy, pool, ws);
+    double lambda = cur.density_norm > 0.0 ? cur.wl_norm / cur.density_norm : 1.0;
+    st.gamma = kGammaScale * bins.bw * std::pow(10.0, kGammaK * cur.overflow + kGammaB);
+
+    // Nesterov: u is the major solution, v the reference point
+    std::vector<double> ux = x, uy = y, vx = x, vy = y;
+    cur = gradient(pl, st, poisson, fixed_density, lambda, vx, vy, g_vx, g_vy, pool, ws);
+
+    // First step length from a small trial move
+    std::vector<double> tx = vx, ty = vy, tgx, tgy;
+    double gmax = 0.0;
+    for (int v = 0; v < num_vars; ++v) gmax = std::max(gmax, std::max(std::fabs(g_vx[v]), std::fabs(g_vy[v])));
+    if (gmax <= 0.0) gmax = 1.0;
+    for (int v = 0; v < num_vars; ++v) {
+        tx[v] -= 0.1 * bins.bw * g_vx[v] / gmax;
+        ty[v] -= 0.1 * bins.bh * g_vy[v] / gmax;
+    }
+    clampAll(tx, ty);
+    gradient(pl, st, poisson, fixed_density, lambda, tx, ty, tgx, tgy, pool, ws);
+    double dg = distance(g_vx, g_vy, tgx, tgy);
+    double step = dg > 0.0 ? distance(vx, vy, tx, ty) / dg : bins.bw;
+
+    // Best iterate so far: lowest overflow, then lowest HPWL among
+    // iterates of about the same overflow
+    Metrics best = cur;
+    std::vector<double> best_x = vx, best_y = vy;
+    int best_iter = 0;
+    double progress_overflow = cur.overflow;
+    int progress_iter = 0;
+
+    double a = 1.0;
+    int iter = 0;
+    std::vector<double> nux, nuy, nvx, nvy, ngx, ngy;
+    for (; iter < options.max_iterations && cur.overflow > options.target_overflow; ++iter) {
+        const double a_next = 0.5 * (1.0 + std::sqrt(4.0 * a * a + 1.0));
+        const double coef = (a - 1.0) / a_next;
+        Metrics next;
+        for (int t = 0; t < kMaxBacktracks; ++t) {
+            nux = vx;
+            nuy = vy;
+            for (int v = 0; v < num_vars; ++v) {
+                nux[v] -= step * g_vx[v];
+                nuy[v] -= step * g_vy[v];
+            }
+            clampAll(nux, nuy);
+            nvx = nux;
+            nvy = nuy;
+            for (int v = 0; v < num_vars; ++v) {
+                nvx[v] += coef * (nux[v] - ux[v]);
+                nvy[v] += coef * (nuy[v] - uy[v]);
+            }
+            clampAll(nvx, nvy);
+            next = gradient(pl, st, poisson, fixed_density, lambda, nvx, nvy, ngx, ngy, pool, ws);
+
+            // Accept once the local Lipschitz estimate supports the step
+            double d = distance(g_vx, g_vy, ngx, ngy);
+            double predicted = d > 0.0 ? distance(vx, vy, nvx, nvy) / d : step;
+            bool accept = predicted >= 0.95 * step;
+            step = predicted;
+            if (accept) break;
+        }
+
+        ux.swap(nux);
+        uy.swap(nuy);
+        vx.swap(nvx);
+        vy.swap(nvy);
+        g_vx.swap(ngx);
+        g_vy.swap(ngy);
+        a = a_next;
+
+        if (next.overflow < progress_overflow * (1.0 - kProgress)) {
+            progress_overflow = next.overflow;
+            progress_iter = iter;
+        }
+        if (next.overflow < best.overflow - kOverflowTolerance ||
+            (next.overflow <= best.overflow + kOverflowTolerance && next.hpwl < best.hpwl)) {
+            best = next;
+            best_x = vx;
+            best_y = vy;
+            best_iter = iter;
+        }
+
+        // The penalty grows fastest while HPWL holds steady, and not at all
+        // while it no longer brings the overflow down
+        if (iter - progress_iter < kFreezeIterations) {
+            double p = (next.hpwl - cur.hpwl) / (kWlRef * std::max(cur.hpwl, 1.0));
+            lambda *= std::max(kLambdaMin, std::min(kLambdaBase, std::pow(kLambdaBase, 1.0 - p)));
+        }
+        st.gamma = kGammaScale * bins.bw * std::pow(10.0, kGammaK * next.overflow + kGammaB);
+        cur = next;
+
+        if (iter % 50 == 0) {
+            std::cout << "  Iteration " << iter << ": overflow = " << 100.0 * cur.overflow
+                      << "%, HPWL = " << cur.hpwl << ", lambda = " << lambda << std::endl;
+        }
+        if (iter - progress_iter >= kPlateauIterations) {
+            std::cout << "  Overflow stalled at " << 100.0 * cur.overflow << "%" << std::endl;
+            ++iter;
+            break;
+        }
+    }
+    if (best_iter + 1 < iter) {
+        std::cout << "  Keeping iteration " << best_iter << ": overflow = " << 100.0 * best.overflow
+                  << "%, HPWL = " << best.hpwl << std::endl;
+    }
+
+    for (int v = 0; v < st.num_cells; ++v) {
+        Cell& cell = pl.cells[st.cell[v]];
+        cell.x = static_cast<int>(std::lround(best_x[v] - 0.5 * cell.w));
+        cell.y = static_cast<int>(std::lround(best_y[v] - 0.5 * cell.h));
+        cell.x = std::max(0, std::min(cell.x, pl.grid.W - cell.w));
+        cell.y = std::max(0, std::min(cell.y, pl.grid.H - cell.h));
+    }
+    pl.updateGrid();
+
+    std::cout << "Electrostatic placement: " << iter << " iterations, " << num_fillers
+              << " fillers, " << m << "x" << m << " bins, overflow = " << 100.0 * best.overflow
+              << "%, HPWL = " << CostCalculator::calculateTotalHPWL(pl) << std::endl;
+}
@@ -0,0 +1,82 @@
+#ifndef ELECTROSTATIC_PLACE_H
+#define ELECTROSTATIC_PLACE_H
+
+#include "../model/placement.h"
+#include <vector>
+
+class ThreadPool;
+class PoissonSolver;
+
+// Electrostatics-based nonlinear global placement (ePlace style).
+// Cells are positive charges and the density penalty is their potential
+// energy, with the field computed by the spectral Poisson solver on an
+// M x M bin grid. Wirelength is the weighted-average (WA) smoothing of
+// HPWL, and its smoothing length shrinks as the overflow drops. Whitespace
+// is filled with filler cells (up to the target density) so that the real
+// cells do not have to spread over the whole die. The objective
+// WA + lambda * energy is minimised with Nesterov's accelerated gradient.
+// The step length comes from the local Lipschitz estimate, with
+// backtracking, and the gradient is preconditioned by pin count and
+// charge. Lambda grows until the overflow target is met, but not while the
+// overflow has stopped falling; the loop also ends once the overflow has
+// stalled, and the best iterate (by overflow, then HPWL) is returned.
+// Gradient and density kernels run on fixed chunks over structure-of-arrays
+// data, so results do not depend on the thread count.
+
+struct ElectrostaticOptions {
+    unsigned seed = 1;             // Filler cell start positions
+    int max_iterations = 1000;
+    double target_density = 0.9;   // Fillers top each bin's free area up to this
+    double target_overflow = 0.1;  // Stop once overflow falls below this
+    int bins = 0;                  // Bins per side (power of two); 0 = from cell count
+    int num_threads = 0;           // 0 = hardware concurrency
+};
+
+class ElectrostaticPlacer {
+public:
+    // Global placement of the movable cells, starting from a wirelength-only
+    // quadratic solve. Positions are rounded and clamped to the grid;
+    // overlaps are left to legalization.
+    static void place(Placement& pl, const ElectrostaticOptions& options = ElectrostaticOptions());
+
+private:
+    // Charges (movable cells, then fillers) as structure of arrays
+    struct State {
+        int num_cells = 0;          // Real cells come first
+        std::vector<int> cell;      // Variable -> cell index (real cells)
+        std::vector<int> var;       // Cell index -> variable, -1 for fixed
+        std::vector<double> w, h;   // Sizes
+        std::vector<double> dw, dh; // Density footprint (stretched to a bin)
+        std::vector<double> scale;  // Area kept when stretched
+        std::vector<double> precond_pins;  // Pin count per variable
+        double target_density = 0.9;
+        double gamma = 1.0;         // WA smoothing length
+    };
+
+    // What a gradient evaluation measures besides the gradient itself
+    struct Metrics {
+        double overflow = 0.0;      // Of the real cells
+        double wa = 0.0;            // Smoothed wirelength
+        double hpwl = 0.0;          // Exact HPWL of the unrounded positions
+        double wl_norm = 0.0;       // L1 norms of the two gradient terms,
+        double density_norm = 0.0;  // before weighting and preconditioning
+    };
+
+    // Buffers of gradient(), allocated once per placement
+    struct Workspace {
+        std::vector<double> px, py;          // Pin positions
+        std::vector<double> pgx, pgy;        // WA gradient per pin
+        std::vector<std::vector<double>> part_all, part_real;  // Density per chunk
+        std::vector<double> rho, real_area;
+        std::vector<double> psi, field_x, field_y;
+    };
+
+    // Preconditioned gradient of WA + lambda * energy at centers (x, y)
+    static Metrics gradient(const Placement& pl, const State& st, const PoissonSolver& poisson,
+                            const std::vector<double>& fixed_density, double lambda,
+                            const std::vector<double>& x, const std::vector<double>& y,
+                            std::vector<double>& gx, std::vector<double>& gy, ThreadPool& pool,
+                            Workspace& ws);
+};
+
+#endif // ELECTROSTATIC_PLACE_H
@@ -0,0 +1,158 @@
+#include "poisson.h"
+#include "../util/profiler.h"
+#include "../util/thread_pool.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+const double kPi = 3.14159265358979323846;
+
+// Lines per pool task
+const int kLinesPerTask = 16;
+
+}  // namespace
+
+Fft::Fft(int n) : n_(n), rev_(n), twiddle_(n / 2) {
+    int bits = 0;
+    while ((1 << bits) < n) bits++;
+    for (int i = 0; i < n; ++i) {
+        int r = 0;
+        for (int b = 0; b < bits; ++b) {
+            if (i & (1 << b)) r |= 1 << (bits - 1 - b);
+        }
+        rev_[i] = r;
+    }
+    for (int k = 0; k < n / 2; ++k) {
+        twiddle_[k] = std::polar(1.0, -2.0 * kPi * k / n);
+    }
+}
+
+void Fft::transform(std::complex<double>* a, bool inverse) const {
+    for (int i = 0; i < n_; ++i) {
+        if (i < rev_[i]) std::swap(a[i], a[rev_[i]]);
+    }
+    for (int len = 2; len <= n_; len <<= 1) {
+        const int half = len / 2;
+        const int step = n_ / len;
+        for (int start = 0; start < n_; start += len) {
+            for (int j = 0; j < half; ++j) {
+                std::complex<double> w = twiddle_[j * step];
+                if (inverse) w = std::conj(w);
+                std::complex<double> u = a[start + j];
+                std::complex<double> v = a[start + j + half] * w;
+                a[start + j] = u + v;
+                a[start + j + half] = u - v;
+            }
+        }
+    }
+}
+
+PoissonSolver::PoissonSolver(int bins, double width, double height)
+    : m_(bins), width_(width), height_(height), fft_(2 * bins), shift_(bins) {
+    for (int k = 0; k < m_; ++k) {
+        shift_[k] = std::polar(1.0, kPi * k / (2.0 * m_));
+    }
+}
+
+void PoissonSolver::dct(const double* x, double* X) const {
+    // cos(pi k (2n+1) / 2M) = Re(e^(-i pi k / 2M) e^(-2 pi i kn / 2M)):
+    // a zero-padded FFT of length 2M
+    std::vector<std::complex<double>> a(2 * m_);
+    for (int n = 0; n < m_; ++n) a[n] = x[n];
+    fft_.transform(a.data(), false);
+    for (int k = 0; k < m_; ++k) {
+        X[k] = (std::conj(shift_[k]) * a[k]).real();
+    }
+}
+
+void PoissonSolver::cosSinSums(const double* X, double* c, double* s) const {
+    // sum_k X[k] e^(i pi k (2n+1) / 2M) = sum_k (X[k] e^(i pi k / 2M)) e^(2 pi i kn / 2M);
+    // its real part is the cosine sum and its imaginary part the sine sum
+    std::vector<std::complex<double>> a(2 * m_);
+    for (int k = 0; k < m_; ++k) a[k] = X[k] * shift_[k];
+    fft_.transform(a.data(), true);
+    for (int n = 0; n < m_; ++n) {
+        if (c) c[n] = a[n].real();
+        if (s) s[n] = a[n].imag();
+    }
+}
+
+void PoissonSolver::forLines(int count, ThreadPool* pool, const std::function<void(int)>& fn) const {
+    const int tasks = (count + kLinesPerTask - 1) / kLinesPerTask;
+    auto run = [&](int t) {
+        for (int i = t * kLinesPerTask; i < std::min(count, (t + 1) * kLinesPerTask); ++i) fn(i);
+    };
+    if (pool && pool->size() > 1) {
+        pool->parallelFor(tasks, run);
+    } else {
+        for (int t = 0; t < tasks; ++t) run(t);
+    }
+}
+
+void PoissonSolver::solve(const std::vector<double>& rho, std::vector<double>& psi,
+                          std::vector<double>& field_x, std::vector<double>& field_y,
+                          ThreadPool* pool) const {
+    ProfileScope scope("poisson_solve");
+    const int m = m_;
+    const size_t cells = static_cast<size_t>(m) * m;
+    std::vector<double> a(cells), t(cells);
+
+    // Cosine coefficients: rows (along x), then columns (along y)
+    forLines(m, pool, [&](int y) { dct(&rho[static_cast<size_t>(y) * m], &t[static_cast<size_t>(y) * m]); });
+    forLines(m, pool, [&](int x) {
+        std::vector<double> col(m), out(m);
+        for (int y = 0; y < m; ++y) col[y] = t[static_cast<size_t>(y) * m + x];
+        dct(col.data(), out.data());
+        for (int v = 0; v < m; ++v) a[static_cast<size_t>(v) * m + x] = out[v];
+    });
+
+    // Normalise so that rho = sum a_uv cos cos, and divide by the squared
+    // frequency (in die units); the constant term carries no field
+    std::vector<double> wu(m), wv(m);
+    for (int k = 0; k < m; ++k) {
+        wu[k] = kPi * k / width_;
+        wv[k] = kPi * k / height_;
+    }
+    const double norm = 1.0 / (static_cast<double>(m) * m);
+    for (int v = 0; v < m; ++v) {
+        for (int u = 0; u < m; ++u) {
+            size_t i = static_cast<size_t>(v) * m + u;
+            double w2 = wu[u] * wu[u] + wv[v] * wv[v];
+            double scale = (u == 0 ? 1.0 : 2.0) * (v == 0 ? 1.0 : 2.0) * norm;
+            a[i] = w2 > 0.0 ? a[i] * scale / w2 : 0.0;
+        }
+    }
+
+    // Synthesis along x: cos sums of psi_uv and sin sums of w_u psi_uv
+    std::vector<double> cx(cells), sx(cells);
+    forLines(m, pool, [&](int v) {
+        std::vector<double> row(m);
+        const double* coef = &a[static_cast<size_t>(v) * m];
+        for (int u = 0; u < m; ++u) row[u] = wu[u] * coef[u];
+        cosSinSums(coef, &cx[static_cast<size_t>(v) * m], nullptr);
+        cosSinSums(row.data(), nullptr, &sx[static_cast<size_t>(v) * m]);
+    });
+
+    // Synthesis along y: psi = cos(cx), xi_x = cos(sx), xi_y = sin(w_v cx)
+    psi.assign(cells, 0.0);
+    field_x.assign(cells, 0.0);
+    field_y.assign(cells, 0.0);
+    forLines(m, pool, [&](int x) {
+        std::vector<double> c(m), s(m), cw(m), out_c(m), out_s(m), out_y(m);
+        for (int v = 0; v < m; ++v) {
+            c[v] = cx[static_cast<size_t>(v) * m + x];
+            s[v] = sx[static_cast<size_t>(v) * m + x];
+            cw[v] = wv[v] * c[v];
+        }
+        cosSinSums(c.data(), out_c.data(), nullptr);
+        cosSinSums(s.data(), out_s.data(), nullptr);
+        cosSinSums(cw.data(), nullptr, out_y.data());
+        for (int y = 0; y < m; ++y) {
+            size_t i = static_cast<size_t>(y) * m + x;
+            psi[i] = out_c[y];
+            field_x[i] = out_s[y];
+            field_y[i] = out_y[y];
+        }
+    });
+}
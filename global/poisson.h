@@ -0,0 +1,65 @@
+#ifndef POISSON_H
+#define POISSON_H
+
+#include <complex>
+#include <functional>
+#include <vector>
+
+class ThreadPool;
+
+// Spectral Poisson solver for the electrostatic placer.
+// The bin density rho on an M x M grid (M a power of two) is expanded in
+// cosines, rho = sum a_uv cos(w_u x) cos(w_v y), which satisfies the
+// Neumann (zero-field) boundary condition at the die edge. Then
+// laplacian(psi) = -rho gives psi_uv = a_uv / (w_u^2 + w_v^2), and the
+// field is xi = -grad(psi). Every transform is a cosine or sine sum
+// evaluated with a zero-padded radix-2 FFT, one independent line at a
+// time.
+
+// In-place radix-2 complex FFT of a fixed power-of-two size
+class Fft {
+public:
+    explicit Fft(int n);
+
+    int size() const { return n_; }
+
+    // a[k] = sum_j a[j] e^(-2 pi i jk / n), or e^(+...) when inverse
+    // (unnormalized)
+    void transform(std::complex<double>* a, bool inverse) const;
+
+private:
+    int n_;
+    std::vector<int> rev_;
+    std::vector<std::complex<double>> twiddle_;  // e^(-2 pi i k / n), k < n/2
+};
+
+class PoissonSolver {
+public:
+    // M x M bins (M a power of two) covering a width x height die
+    PoissonSolver(int bins, double width, double height);
+
+    int bins() const { return m_; }
+
+    // rho, psi, field_x and field_y are row-major M x M maps
+    // (index y * M + x). Lines are transformed on the pool when given.
+    void solve(const std::vector<double>& rho, std::vector<double>& psi,
+               std::vector<double>& field_x, std::vector<double>& field_y,
+               ThreadPool* pool = nullptr) const;
+
+    // X[k] = sum_n x[n] cos(pi k (2n + 1) / 2M)
+    void dct(const double* x, double* X) const;
+
+    // c[n] = sum_k X[k] cos(pi k (2n + 1) / 2M) and
+    // s[n] = sum_k X[k] sin(pi k (2n + 1) / 2M); either may be null
+    void cosSinSums(const double* X, double* c, double* s) const;
+
+private:
+    int m_;
+    double width_, height_;
+    Fft fft_;  // Size 2M: both transforms are zero-padded
+    std::vector<std::complex<double>> shift_;  // e^(i pi k / 2M), k < M
+
+    void forLines(int count, ThreadPool* pool, const std::function<void(int)>& fn) const;
+};
+
+#endif // POISSON_H
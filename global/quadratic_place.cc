@@ -0,0 +1,406 @@
+#include "quadratic_place.h"
+#include "sparse.h"
+#include "../cost/cost.h"
+#include "../util/profiler.h"
+#include "../util/thread_pool.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+namespace {
+
+// Shortest spring length in the B2B weights, in grid units
+const double kMinDistance = 1.0;
+
+// Pull of every cell toward the die center; keeps the system definite when
+// a group of cells has no path to a fixed cell
+const double kRegularization = 1e-6;
+
+// Spreading anchor weight per round, relative to a two-pin net
+const double kAnchorWeight = 0.2;
+
+// B2B reweighting solves before spreading starts
+const int kInitialSolves = 5;
+
+// Share of a bin's free area that spreading fills
+const double kTargetDensity = 0.9;
+
+// Bin utilisation (movable + fixed area over bin area), cells by center
+void binUtilisation(const Placement& pl, const std::vector<double>& cx, const std::vector<double>& cy,
+                    const std::vector<int>& cell_of, int bin_size, int nbx, int nby,
+                    std::vector<double>& movable, std::vector<double>& fixed_area) {
+    movable.assign(static_cast<size_t>(nbx) * nby, 0.0);
+    fixed_area.assign(static_cast<size_t>(nbx) * nby, 0.0);
+    for (size_t v = 0; v < cell_of.size(); ++v) {
+        const Cell& cell = pl.cells[cell_of[v]];
+        int bx = std::max(0, std::min(static_cast<int>(cx[v]) / bin_size, nbx - 1));
+        int by = std::max(0, std::min(static_cast<int>(cy[v]) / bin_size, nby - 1));
+        movable[by * nbx + bx] += static_cast<double>(cell.w) * cell.h;
+    }
+    for (const auto& cell : pl.cells) {
+        if (!cell.fixed) continue;
+        int x0 = std::max(cell.x, 0), x1 = std::min(cell.x + cell.w, pl.grid.W);
+        int y0 = std::max(cell.y, 0), y1 = std::min(cell.y + cell.h, pl.grid.H);
+        if (x0 >= x1 || y0 >= y1) continue;
+        for (int by = y0 / bin_size; by <= (y1 - 1) / bin_size; ++by) {
+            int oy = std::min(y1, (by + 1) * bin_size) - std::max(y0, by * bin_size);
+            for (int bx = x0 / bin_size; bx <= (x1 - 1) / bin_size; ++bx) {
+                int ox = std::min(x1, (bx + 1) * bin_size) - std::max(x0, bx * bin_size);
+                fixed_area[by * nbx + bx] += static_cast<double>(ox) * oy;
+            }
+        }
+    }
+}
+
+// Area of bin (bx, by), clipped to the grid
+double binArea(const Placement& pl, int bin_size, int bx, int by) {
+    int w = std::min((bx + 1) * bin_size, pl.grid.W) - bx * bin_size;
+    int h = std::min((by + 1) * bin_size, pl.grid.H) - by * bin_size;
+    return static_cast<double>(w) * h;
+}
+
+// Spread the cells of one strip of bins along its axis. Every run of bins
+// holding more cell area than it can take is widened toward the emptier
+// side until it fits (or spans the strip); the run's cells then keep their
+// order but are re-spaced so their cumulative area follows the run's
+// cumulative capacity. `center` is updated for the strip's cells.
+void spreadStrip(std::vector<int>& cells, std::vector<double>& center, const std::vector<double>& area,
+                 const std::vector<double>& capacity, int bin_size, int extent) {
+    const int nb = static_cast<int>(capacity.size());
+    auto binOf = [&](int v) {
+        return std::max(0, std::min(static_cast<int>(center[v]) / bin_size, nb - 1));
+    };
+
+    std::vector<double> usage(nb, 0.0);
+    for (int v : cells) usage[binOf(v)] += area[v];
+    std::vector<double> pu(nb + 1, 0.0), pc(nb + 1, 0.0);
+    for (int k = 0; k < nb; ++k) {
+        pu[k + 1] = pu[k] + usage[k];
+        pc[k + 1] = pc[k] + capacity[k];
+    }
+
+    // Overfull runs, merged where they overlap
+    std::vector<std::pair<int, int>> runs;
+    for (int k = 0; k < nb; ++k) {
+        if (usage[k] <= capacity[k]) continue;
+        int l = k, r = k;
+        for (;;) {
+            if (!runs.empty() && l <= runs.back().second) {
+                l = std::min(l, runs.back().first);
+                r = std::max(r, runs.back().second);
+                runs.pop_back();
+            }
+            if (pu[r + 1] - pu[l] <= pc[r + 1] - pc[l] || (l == 0 && r == nb - 1)) break;
+            double left = l > 0 ? capacity[l - 1] - usage[l - 1] : -1e300;
+            double right = r < nb - 1 ? capacity[r + 1] - usage[r + 1] : -1e300;
+            if (left >= right) {
+                --l;
+            } else {
+                ++r;
+            }
+        }
+        runs.push_back(std::make_pair(l, r));
+        k = r;
+    }
+    if (runs.empty()) return;
+
+    std::stable_sort(cells.begin(), cells.end(), [&](int a, int b) { return center[a] < center[b]; });
+    std::vector<int> run_cells;
+    for (const auto& run : runs) {
+        run_cells.clear();
+        for (int v : cells) {
+            int k = binOf(v);
+            if (k >= run.first && k <= run.second) run_cells.push_back(v);
+        }
+
+        // Capacity profile of the run; fully blocked runs use bin length
+        std::vector<double> cap(capacity.begin() + run.first, capacity.begin() + run.second + 1);
+        double total_cap = pc[run.second + 1] - pc[run.first];
+        if (total_cap <= 0.0) {
+            for (int k = run.first; k <= run.second; ++k) {
+                cap[k - run.first] = std::min((k + 1) * bin_size, extent) - k * bin_size;
+            }
+            total_cap = 0.0;
+            for (double c : cap) total_cap += c;
+        }
+        double total_area = pu[run.second + 1] - pu[run.first];
+        if (total_area <= 0.0 || total_cap <= 0.0) continue;
+
+        double acc = 0.0;
+        size_t k = 0;
+        double cap_before = 0.0;
+        for (int v : run_cells) {
+            double t = (acc + 0.5 * area[v]) / total_area * total_cap;
+            acc += area[v];
+            while (k + 1 < cap.size() && cap_before + cap[k] < t) {
+                cap_before += cap[k];
+                ++k;
+            }
+            int bin = run.first + static_cast<int>(k);
+            double lo = bin * bin_size;
+            double len = std::min((bin + 1) * bin_size, extent) - lo;
+            double frac = cap[k] > 0.0 ? (t - cap_before) / cap[k] : 0.5;
+            center[v] = lo + std::max(0.0, std::min(1.0, frac)) * len;
+        }
+    }
+}
+
+}  // namespace
+
+int QuadraticPlacer::defaultBinSize(const Placement& pl) {
+    double area = 0.0;
+    int movable = 0;
+    for (const auto& cell : pl.cells) {
+        if (cell.fixed) continue;
+        area += static_cast<double>(cell.w) * cell.h;
+        movable++;
+    }
+    if (movable == 0) return 1;
+    return std::max(1, static_cast<int>(std::ceil(4.0 * std::sqrt(area / movable))));
+}
+
+int QuadraticPlacer::solveAxis(const Placement& pl, Positions& pos, bool along_x,
+                               const std::vector<double>& anchor, double anchor_weight) {
+    ProfileScope scope("global_solve_axis");
+    const Netlist& nl = pl.netlist;
+    const int n = static_cast<int>(pos.cell.size());
+    std::vector<double>& coord = along_x ? pos.x : pos.y;
+    const std::vector<int>& offset = along_x ? nl.pin_dx : nl.pin_dy;
+    const double center = 0.5 * (along_x ? pl.grid.W : pl.grid.H);
+
+    std::vector<SparseEntry> entries;
+    std::vector<double> b(n, 0.0);
+
+    // Pin coordinate at the current positions
+    auto pinCoord = [&](int p) {
+        int c = nl.pin_cell[p];
+        int v = pos.var[c];
+        double base = v >= 0 ? coord[v] : (along_x ? pl.cells[c].x : pl.cells[c].y);
+        return base + offset[p];
+    };
+
+    // Spring between two pins: w * (pin_p - pin_q)^2
+    auto addSpring = [&](int p, int q, double w) {
+        int ci = nl.pin_cell[p], cj = nl.pin_cell[q];
+        if (ci == cj) return;
+        int vi = pos.var[ci], vj = pos.var[cj];
+        double di = offset[p], dj = offset[q];
+        if (vi >= 0 && vj >= 0) {
+            entries.push_back({vi, vi, w});
+            entries.push_back({vj, vj, w});
+            entries.push_back({vi, vj, -w});
+            entries.push_back({vj, vi, -w});
+            b[vi] += w * (dj - di);
+            b[vj] += w * (di - dj);
+        } else if (vi >= 0) {
+            entries.push_back({vi, vi, w});
+            b[vi] += w * (pinCoord(q) - di);
+        } else if (vj >= 0) {
+            entries.push_back({vj, vj, w});
+            b[vj] += w * (pinCoord(p) - dj);
+        }
+    };
+
+    std::vector<int> pins;
+    for (int net = 0; net < nl.numNets(); ++net) {
+        pins.clear();
+        for (int p = nl.net_pin_start[net]; p < nl.net_pin_start[net + 1]; ++p) {
+            if (nl.pin_cell[p] >= 0) pins.push_back(p);
+        }
+        const int count = static_cast<int>(pins.size());
+        if (count < 2) continue;
+
+        // Bound pins of the net
+        int lo = pins[0], hi = pins[0];
+        for (int p : pins) {
+            if (pinCoord(p) < pinCoord(lo)) lo = p;
+            if (pinCoord(p) > pinCoord(hi)) hi = p;
+        }
+        if (lo == hi) hi = pins[1];
+
+        const double base = 2.0 / (count - 1);
+        auto weight = [&](int p, int q) {
+            return base / std::max(kMinDistance, std::fabs(pinCoord(p) - pinCoord(q)));
+        };
+        for (int p : pins) {
+            if (p != lo) addSpring(lo, p, weight(lo, p));
+            if (p != lo && p != hi) addSpring(hi, p, weight(hi, p));
+        }
+    }
+
+    // Regularization and spreading anchors
+    for (int v = 0; v < n; ++v) {
+        const Cell& cell = pl.cells[pos.cell[v]];
+        double size = along_x ? cell.w : cell.h;
+        entries.push_back({v, v, kRegularization});
+        b[v] += kRegularization * (center - 0.5 * size);
+        if (!anchor.empty()) {
+            // Weighted like a B2B spring, so it pulls as hard at any distance
+            double w = anchor_weight / std::max(kMinDistance, std::fabs(coord[v] - anchor[v]));
+            entries.push_back({v, v, w});
+            b[v] += w * anchor[v];
+        }
+    }
+
+    SparseMatrix A = SparseMatrix::fromEntries(n, entries);
+    int iterations = SparseSolver::conjugateGradient(A, b, coord, 1e-6, 1000);
+
+    // Keep cells on the die
+    const int extent = along_x ? pl.grid.W : pl.grid.H;
+    for (int v = 0; v < n; ++v) {
+        const Cell& cell = pl.cells[pos.cell[v]];
+        double size = along_x ? cell.w : cell.h;
+        coord[v] = std::max(0.0, std::min(coord[v], extent - size));
+    }
+    return iterations;
+}
+
+void QuadraticPlacer::spreadTargets(const Placement& pl, const Positions& pos, int bin_size,
+                                    std::vector<double>& target_x, std::vector<double>& target_y) {
+    ProfileScope scope("global_spread");
+    const int n = static_cast<int>(pos.cell.size());
+    const int nbx = (pl.grid.W + bin_size - 1) / bin_size;
+    const int nby = (pl.grid.H + bin_size - 1) / bin_size;
+
+    std::vector<double> cx(n), cy(n), area(n);
+    for (int v = 0; v < n; ++v) {
+        const Cell& cell = pl.cells[pos.cell[v]];
+        cx[v] = pos.x[v] + 0.5 * cell.w;
+        cy[v] = pos.y[v] + 0.5 * cell.h;
+        area[v] = static_cast<double>(cell.w) * cell.h;
+    }
+
+    std::vector<double> movable, fixed_area;
+    binUtilisation(pl, cx, cy, pos.cell, bin_size, nbx, nby, movable, fixed_area);
+    auto capacity = [&](int i, int j) {
+        return kTargetDensity * std::max(0.0, binArea(pl, bin_size, i, j) - fixed_area[j * nbx + i]);
+    };
+
+    // Vertically within columns of bins, then horizontally within rows
+    std::vector<std::vector<int>> strips(nbx);
+    for (int v = 0; v < n; ++v) {
+        strips[std::max(0, std::min(static_cast<int>(cx[v]) / bin_size, nbx - 1))].push_back(v);
+    }
+    for (int i = 0; i < nbx; ++i) {
+        std::vector<double> cap(nby);
+        for (int j = 0; j < nby; ++j) cap[j] = capacity(i, j);
+        spreadStrip(strips[i], cy, area, cap, bin_size, pl.grid.H);
+    }
+
+    strips.assign(nby, std::vector<int>());
+    for (int v = 0; v < n; ++v) {
+        strips[std::max(0, std::min(static_cast<int>(cy[v]) / bin_size, nby - 1))].push_back(v);
+    }
+    for (int j = 0; j < nby; ++j) {
+        std::vector<double> cap(nbx);
+        for (int i = 0; i < nbx; ++i) cap[i] = capacity(i, j);
+        spreadStrip(strips[j], cx, area, cap, bin_size, pl.grid.W);
+    }
+
+    target_x.resize(n);
+    target_y.resize(n);
+    for (int v = 0; v < n; ++v) {
+        const Cell& cell = pl.cells[pos.cell[v]];
+        target_x[v] = std::max(0.0, std::min(cx[v] - 0.5 * cell.w, static_cast<double>(pl.grid.W - cell.w)));
+        target_y[v] = std::max(0.0, std::min(cy[v] - 0.5 * cell.h, static_cast<double>(pl.grid.H - cell.h)));
+    }
+}
+
+double QuadraticPlacer::overflow(const Placement& pl, const Positions& pos, int bin_size) {
+    const int n = static_cast<int>(pos.cell.size());
+    const int nbx = (pl.grid.W + bin_size - 1) / bin_size;
+    const int nby = (pl.grid.H + bin_size - 1) / bin_size;
+    if (n == 0 || nbx == 0 || nby == 0) return 0.0;
+
+    std::vector<double> cx(n), cy(n);
+    double total = 0.0;
+    for (int v = 0; v < n; ++v) {
+        const Cell& cell = pl.cells[pos.cell[v]];
+        cx[v] = pos.x[v] + 0.5 * cell.w;
+        cy[v] = pos.y[v] + 0.5 * cell.h;
+        total += static_cast<double>(cell.w) * cell.h;
+    }
+
+    std::vector<double> movable, fixed_area;
+    binUtilisation(pl, cx, cy, pos.cell, bin_size, nbx, nby, movable, fixed_area);
+    double over = 0.0;
+    for (int j = 0; j < nby; ++j) {
+        for (int i = 0; i < nbx; ++i) {
+            double capacity = std::max(0.0, binArea(pl, bin_size, i, j) - fixed_area[j * nbx + i]);
+            over += std::max(0.0, movable[j * nbx + i] - capacity);
+        }
+    }
+    return total > 0.0 ? over / total : 0.0;
+}
+
+double QuadraticPlacer::overflow(const Placement& pl, int bin_size) {
+    Positions pos;
+    for (size_t i = 0; i < pl.cells.size(); ++i) {
+        if (pl.cells[i].fixed) continue;
+        pos.cell.push_back(static_cast<int>(i));
+        pos.x.push_back(pl.cells[i].x);
+        pos.y.push_back(pl.cells[i].y);
+    }
+    return overflow(pl, pos, bin_size > 0 ? bin_size : defaultBinSize(pl));
+}
+
+void QuadraticPlacer::place(Placement& pl, const GlobalPlaceOptions& options) {
+    std::cout << "Quadratic global placement..." << std::endl;
+    if (!pl.hasIndex()) {
+        pl.buildIndex();
+    }
+
+    // Movable cells start stacked at the die center
+    Positions pos;
+    pos.var.assign(pl.cells.size(), -1);
+    for (size_t i = 0; i < pl.cells.size(); ++i) {
+        const Cell& cell = pl.cells[i];
+        if (cell.fixed) continue;
+        pos.var[i] = static_cast<int>(pos.cell.size());
+        pos.cell.push_back(static_cast<int>(i));
+        pos.x.push_back(0.5 * (pl.grid.W - cell.w));
+        pos.y.push_back(0.5 * (pl.grid.H - cell.h));
+    }
+    if (pos.cell.empty()) {
+        std::cout << "No movable cells to place" << std::endl;
+        return;
+    }
+
+    const int bin_size = options.bin_size > 0 ? options.bin_size : defaultBinSize(pl);
+    ThreadPool pool(std::min(2, options.num_threads > 0 ? options.num_threads : ThreadPool::defaultThreads()));
+
+    // Solve both axes (concurrently: they share nothing but the netlist)
+    int cg_iterations[2] = {0, 0};
+    auto solve = [&](const std::vector<double>& ax, const std::vector<double>& ay, double weight) {
+        pool.parallelFor(2, [&](int axis) {
+            cg_iterations[axis] += solveAxis(pl, pos, axis == 0, axis == 0 ? ax : ay, weight);
+        });
+    };
+
+    // Wirelength-only solves, re-linearising the B2B model each time
+    const std::vector<double> none;
+    for (int i = 0; i < kInitialSolves; ++i) {
+        solve(none, none, 0.0);
+    }
+
+    int rounds = 0;
+    double over = overflow(pl, pos, bin_size);
+    std::vector<double> target_x, target_y;
+    while (rounds < options.max_iterations && over > options.target_overflow) {
+        rounds++;
+        spreadTargets(pl, pos, bin_size, target_x, target_y);
+        solve(target_x, target_y, kAnchorWeight * rounds);
+        over = overflow(pl, pos, bin_size);
+    }
+
+    for (size_t v = 0; v < pos.cell.size(); ++v) {
+        Cell& cell = pl.cells[pos.cell[v]];
+        cell.x = std::max(0, std::min(static_cast<int>(std::lround(pos.x[v])), pl.grid.W - cell.w));
+        cell.y = std::max(0, std::min(static_cast<int>(std::lround(pos.y[v])), pl.grid.H - cell.h));
+    }
+    pl.updateGrid();
+
+    std::cout << "Global placement: " << rounds << " spreading rounds, "
+              << cg_iterations[0] + cg_iterations[1] << " CG iterations, overflow = "
+              << 100.0 * over << "%, HPWL = " << CostCalculator::calculateTotalHPWL(pl) << std::endl;
+}
@@ -0,0 +1,59 @@
+#ifndef QUADRATIC_PLACE_H
+#define QUADRATIC_PLACE_H
+
+#include "../model/placement.h"
+#include <vector>
+
+// Quadratic (analytical) global placement.
+// Every net is replaced by two-pin springs with the bound-to-bound (B2B)
+// net model: each pin connects to the net's leftmost and rightmost pins,
+// weighted 2 / ((p - 1) * distance), so the quadratic wirelength matches
+// HPWL at the current positions. Minimising it is a sparse symmetric
+// linear system per axis (the netlist Laplacian, with fixed cells as
+// anchors), solved with Jacobi-preconditioned conjugate gradients. The
+// solution clumps cells together, so each round is followed by cell
+// shifting (FastPlace style: bin boundaries are moved in proportion to
+// bin utilisation) and the shifted positions are fed back as spring
+// anchors of growing weight until the overflow target is met.
+
+struct GlobalPlaceOptions {
+    int max_iterations = 30;       // Spreading rounds after the first solve
+    double target_overflow = 0.1;  // Stop when overfull bins hold this share of movable area
+    int bin_size = 0;              // Spreading bin size; 0 = from average cell size
+    int num_threads = 0;           // x and y are solved concurrently; 0 = hardware concurrency
+};
+
+class QuadraticPlacer {
+public:
+    // Place all movable cells (rounded and clamped to the grid; overlaps
+    // are left to legalization) and rebuild the grid
+    static void place(Placement& pl, const GlobalPlaceOptions& options = GlobalPlaceOptions());
+
+    // Share of the movable cell area above bin capacity (bin area minus
+    // fixed cell area), with cells counted in the bin holding their center
+    static double overflow(const Placement& pl, int bin_size);
+
+    // Bin size used when none is given: about four average cells wide
+    static int defaultBinSize(const Placement& pl);
+
+private:
+    // Cell positions during placement (lower-left corner)
+    struct Positions {
+        std::vector<int> var;       // Cell index -> variable, -1 for fixed cells
+        std::vector<int> cell;      // Variable -> cell index
+        std::vector<double> x, y;   // Per variable
+    };
+
+    // Build and solve the system for one axis; anchor_* are optional
+    // spreading targets (empty for none)
+    static int solveAxis(const Placement& pl, Positions& pos, bool along_x,
+                         const std::vector<double>& anchor, double anchor_weight);
+
+    // Spreading targets for every variable
+    static void spreadTargets(const Placement& pl, const Positions& pos, int bin_size,
+                           std::vector<double>& target_x, std::vector<double>& target_y);
+
+    static double overflow(const Placement& pl, const Positions& pos, int bin_size);
+};
+
+#endif // QUADRATIC_PLACE_H
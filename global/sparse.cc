@@ -0,0 +1,94 @@
+#include "sparse.h"
+#include <algorithm>
+#include <cmath>
+
+SparseMatrix SparseMatrix::fromEntries(int n, std::vector<SparseEntry>& entries) {
+    std::sort(entries.begin(), entries.end(), [](const SparseEntry& a, const SparseEntry& b) {
+        return a.row != b.row ? a.row < b.row : a.col < b.col;
+    });
+
+    SparseMatrix m;
+    m.n = n;
+    m.row_start.assign(n + 1, 0);
+    for (size_t k = 0; k < entries.size(); ++k) {
+        const SparseEntry& e = entries[k];
+        if (!m.col.empty() && k > 0 && entries[k - 1].row == e.row && entries[k - 1].col == e.col) {
+            m.val.back() += e.value;
+            continue;
+        }
+        m.col.push_back(e.col);
+        m.val.push_back(e.value);
+        m.row_start[e.row + 1]++;
+    }
+    for (int r = 0; r < n; ++r) {
+        m.row_start[r + 1] += m.row_start[r];
+    }
+    return m;
+}
+
+void SparseMatrix::multiply(const std::vector<double>& x, std::vector<double>& y) const {
+    y.assign(n, 0.0);
+    for (int r = 0; r < n; ++r) {
+        double sum = 0.0;
+        for (int k = row_start[r]; k < row_start[r + 1]; ++k) {
+            sum += val[k] * x[col[k]];
+        }
+        y[r] = sum;
+    }
+}
+
+std::vector<double> SparseMatrix::diagonal() const {
+    std::vector<double> d(n, 0.0);
+    for (int r = 0; r < n; ++r) {
+        for (int k = row_start[r]; k < row_start[r + 1]; ++k) {
+            if (col[k] == r) d[r] += val[k];
+        }
+    }
+    return d;
+}
+
+static double dot(const std::vector<double>& a, const std::vector<double>& b) {
+    double sum = 0.0;
+    for (size_t i = 0; i < a.size(); ++i) sum += a[i] * b[i];
+    return sum;
+}
+
+int SparseSolver::conjugateGradient(const SparseMatrix& A, const std::vector<double>& b,
+                                    std::vector<double>& x, double tolerance, int max_iterations) {
+    const int n = A.n;
+    x.resize(n, 0.0);
+
+    // Jacobi preconditioner
+    std::vector<double> inv_diag = A.diagonal();
+    for (double& d : inv_diag) d = d > 0.0 ? 1.0 / d : 1.0;
+
+    std::vector<double> r(n), z(n), p(n), Ap;
+    A.multiply(x, Ap);
+    for (int i = 0; i < n; ++i) r[i] = b[i] - Ap[i];
+
+    const double limit = tolerance * std::sqrt(dot(b, b));
+    for (int i = 0; i < n; ++i) z[i] = inv_diag[i] * r[i];
+    p = z;
+    double rz = dot(r, z);
+
+    int iter = 0;
+    for (; iter < max_iterations; ++iter) {
+        if (std::sqrt(dot(r, r)) <= limit) break;
+
+        A.multiply(p, Ap);
+        double pAp = dot(p, Ap);
+        if (pAp <= 0.0) break;
+        double alpha = rz / pAp;
+        for (int i = 0; i < n; ++i) {
+            x[i] += alpha * p[i];
+            r[i] -= alpha * Ap[i];
+        }
+
+        for (int i = 0; i < n; ++i) z[i] = inv_diag[i] * r[i];
+        double rz_next = dot(r, z);
+        double beta = rz_next / rz;
+        rz = rz_next;
+        for (int i = 0; i < n; ++i) p[i] = z[i] + beta * p[i];
+    }
+    return iter;
+}
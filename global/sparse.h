@@ -0,0 +1,40 @@
+#ifndef SPARSE_H
+#define SPARSE_H
+
+#include <vector>
+
+// Sparse symmetric systems for the analytical placer: a CSR matrix
+// assembled from (row, col, value) entries and a Jacobi-preconditioned
+// conjugate-gradient solver.
+
+struct SparseEntry {
+    int row, col;
+    double value;
+};
+
+struct SparseMatrix {
+    int n = 0;
+    std::vector<int> row_start;  // Entries of row r are [row_start[r], row_start[r+1])
+    std::vector<int> col;
+    std::vector<double> val;
+
+    // Build an n x n matrix; duplicate (row, col) entries are summed
+    static SparseMatrix fromEntries(int n, std::vector<SparseEntry>& entries);
+
+    // y = A x
+    void multiply(const std::vector<double>& x, std::vector<double>& y) const;
+
+    std::vector<double> diagonal() const;
+};
+
+class SparseSolver {
+public:
+    // Solve A x = b for symmetric positive definite A, starting from the
+    // given x. Stops when ||r|| <= tolerance * ||b||; returns the number of
+    // iterations used.
+    static int conjugateGradient(const SparseMatrix& A, const std::vector<double>& b,
+                                 std::vector<double>& x, double tolerance = 1e-6,
+                                 int max_iterations = 1000);
+};
+
+#endif // SPARSE_H
@@ -0,0 +1,340 @@
+#include "bookshelf_reader.h"
+#include "mapped_file.h"
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+// One line of a Bookshelf file split into tokens; ':' is always a token
+// of its own, and '#' starts a comment
+struct Line {
+    size_t number = 0;
+    std::vector<std::string_view> tokens;
+};
+
+class LineReader {
+public:
+    LineReader(const MappedFile& file, const std::string& filename)
+        : p_(file.data()), end_(file.data() + file.size()), filename_(filename) {}
+
+    // Next line with at least one token, skipping the "UCLA ..." header
+    bool next(Line& line) {
+        while (p_ != end_) {
+            number_++;
+            const char* begin = p_;
+            const char* eol = static_cast<const char*>(std::memchr(p_, '\n', end_ - p_));
+            const char* stop = eol ? eol : end_;
+            p_ = eol ? eol + 1 : end_;
+
+            line.number = number_;
+            line.tokens.clear();
+            const char* q = begin;
+            while (q != stop && *q != '#') {
+                if (isSpace(*q)) {
+                    ++q;
+                } else if (*q == ':') {
+                    line.tokens.emplace_back(q, 1);
+                    ++q;
+                } else {
+                    const char* t = q;
+                    while (q != stop && !isSpace(*q) && *q != ':' && *q != '#') ++q;
+                    line.tokens.emplace_back(t, static_cast<size_t>(q - t));
+                }
+            }
+            if (line.tokens.empty() || line.tokens[0] == "UCLA") continue;
+            return true;
+        }
+        return false;
+    }
+
+    bool error(size_t line, const std::string& message) const {
+        std::cerr << "Error: " << filename_ << ":" << line << ": " << message << std::endl;
+        return false;
+    }
+
+private:
+    const char* p_;
+    const char* end_;
+    std::string filename_;
+    size_t number_ = 0;
+
+    static bool isSpace(char c) {
+        return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+    }
+};
+
+bool toNumber(std::string_view token, double& value) {
+    auto result = std::from_chars(token.data(), token.data() + token.size(), value);
+    return result.ec == std::errc() && result.ptr == token.data() + token.size();
+}
+
+bool toNumber(std::string_view token, long long& value) {
+    auto result = std::from_chars(token.data(), token.data() + token.size(), value);
+    return result.ec == std::errc() && result.ptr == token.data() + token.size();
+}
+
+// Value of a "Key : value" line
+bool keyValue(const Line& line, double& value) {
+    return line.tokens.size() >= 3 && line.tokens[1] == ":" && toNumber(line.tokens[2], value);
+}
+
+// Design in Bookshelf units while the files are read
+struct Design {
+    double x0 = 0.0, y0 = 0.0, x1 = 0.0, y1 = 0.0;  // Row bounding box
+    bool has_rows = false;
+    std::unordered_map<std::string_view, int> index;  // Views into the .nodes mapping
+    std::vector<double> w, h, x, y;
+    std::vector<char> fixed;
+};
+
+bool parseScl(const MappedFile& file, const std::string& filename, Design& d) {
+    LineReader reader(file, filename);
+    Line line;
+    double coordinate = 0.0, height = 0.0, spacing = 1.0, origin = 0.0, sites = 0.0;
+    while (reader.next(line)) {
+        const std::string_view key = line.tokens[0];
+        bool ok = true;
+        if (key == "Coordinate") {
+            ok = keyValue(line, coordinate);
+        } else if (key == "Height") {
+            ok = keyValue(line, height);
+        } else if (key == "Sitespacing") {
+            ok = keyValue(line, spacing);
+        } else if (key == "SubrowOrigin") {
+            // SubrowOrigin : x NumSites : n
+            ok = line.tokens.size() >= 6 && line.tokens[1] == ":" && toNumber(line.tokens[2], origin) &&
+                 line.tokens[3] == "NumSites" && line.tokens[4] == ":" && toNumber(line.tokens[5], sites);
+        } else if (key == "End") {
+            double right = origin + sites * spacing, top = coordinate + height;
+            if (!d.has_rows) {
+                d.x0 = origin;
+                d.y0 = coordinate;
+                d.x1 = right;
+                d.y1 = top;
+                d.has_rows = true;
+            } else {
+                d.x0 = std::min(d.x0, origin);
+                d.y0 = std::min(d.y0, coordinate);
+                d.x1 = std::max(d.x1, right);
+                d.y1 = std::max(d.y1, top);
+            }
+        }
+        if (!ok) return reader.error(line.number, "malformed " + std::string(key) + " line");
+    }
+    if (!d.has_rows || d.x1 <= d.x0 || d.y1 <= d.y0) return reader.error(line.number, "no placement rows");
+    return true;
+}
+
+bool parseNodes(const MappedFile& file, const std::string& filename, Design& d) {
+    LineReader reader(file, filename);
+    Line line;
+    while (reader.next(line)) {
+        const std::string_view key = line.tokens[0];
+        if (key == "NumNodes") {
+            double count = 0.0;
+            if (!keyValue(line, count)) return reader.error(line.number, "malformed NumNodes line");
+            d.index.reserve(static_cast<size_t>(count));
+            d.w.reserve(static_cast<size_t>(count));
+            d.h.reserve(static_cast<size_t>(count));
+            d.fixed.reserve(static_cast<size_t>(count));
+            continue;
+        }
+        if (key == "NumTerminals") continue;
+
+        // name width height [terminal | terminal_NI]
+        double w, h;
+        if (line.tokens.size() < 3 || !toNumber(line.tokens[1], w) || !toNumber(line.tokens[2], h)) {
+            return reader.error(line.number, "expected 'name width height [terminal]'");
+        }
+        bool terminal = false;
+        if (line.tokens.size() >= 4) {
+            terminal = line.tokens[3] == "terminal" || line.tokens[3] == "terminal_NI";
+            if (!terminal || line.tokens.size() > 4) {
+                return reader.error(line.number, "unexpected text after the node size");
+            }
+        }
+        if (!d.index.emplace(key, static_cast<int>(d.w.size())).second) {
+            return reader.error(line.number, "duplicate node '" + std::string(key) + "'");
+        }
+        d.w.push_back(w);
+        d.h.push_back(h);
+        d.fixed.push_back(terminal ? 1 : 0);
+    }
+    d.x.assign(d.w.size(), 0.0);
+    d.y.assign(d.w.size(), 0.0);
+    return true;
+}
+
+bool parsePl(const MappedFile& file, const std::string& filename, Design& d) {
+    LineReader reader(file, filename);
+    Line line;
+    while (reader.next(line)) {
+        // name x y : orientation [/FIXED | /FIXED_NI]
+        auto it = d.index.find(line.tokens[0]);
+        if (it == d.index.end()) {
+            return reader.error(line.number, "unknown node '" + std::string(line.tokens[0]) + "'");
+        }
+        double x, y;
+        if (line.tokens.size() < 3 || !toNumber(line.tokens[1], x) || !toNumber(line.tokens[2], y)) {
+            return reader.error(line.number, "expected 'name x y : orientation'");
+        }
+        d.x[it->second] = x;
+        d.y[it->second] = y;
+        for (size_t t = 3; t < line.tokens.size(); ++t) {
+            if (line.tokens[t] == "/FIXED" || line.tokens[t] == "/FIXED_NI") d.fixed[it->second] = 1;
+        }
+    }
+    return true;
+}
+
+bool parseNets(const MappedFile& file, const std::string& filename, const Design& d, double unit,
+               Placement& pl) {
+    LineReader reader(file, filename);
+    Line line;
+    long long remaining = 0;  // Pins still expected by the current net
+    size_t net_line = 0;
+    while (reader.next(line)) {
+        const std::string_view key = line.tokens[0];
+        if (key == "NumNets" || key == "NumPins") {
+            double count = 0.0;
+            if (!keyValue(line, count)) return reader.error(line.number, "malformed " + std::string(key) + " line");
+            if (key == "NumNets") pl.nets.reserve(static_cast<size_t>(count));
+            continue;
+        }
+        if (key == "NetDegree") {
+            // NetDegree : k [name]
+            if (remaining > 0) return reader.error(net_line, "net has fewer pins than its degree");
+            if (line.tokens.size() < 3 || line.tokens[1] != ":" || !toNumber(line.tokens[2], remaining) ||
+                remaining < 0) {
+                return reader.error(line.number, "malformed NetDegree line");
+            }
+            Net net(static_cast<int>(pl.nets.size()));
+            net.pins.reserve(static_cast<size_t>(remaining));
+            pl.nets.push_back(std::move(net));
+            net_line = line.number;
+            continue;
+        }
+
+        // name [direction] [: x_offset y_offset], offsets from the node center
+        if (remaining == 0) return reader.error(line.number, "pin outside a net");
+        auto it = d.index.find(key);
+        if (it == d.index.end()) {
+            return reader.error(line.number, "unknown node '" + std::string(key) + "'");
+        }
+        double ox = 0.0, oy = 0.0;
+        auto colon = std::find(line.tokens.begin(), line.tokens.end(), std::string_view(":"));
+        if (colon != line.tokens.end()) {
+            if (line.tokens.end() - colon != 3 || !toNumber(colon[1], ox) || !toNumber(colon[2], oy)) {
+                return reader.error(line.number, "malformed pin offsets");
+            }
+        }
+        const int c = it->second;
+        const Cell& cell = pl.cells[c];
+        int dx = static_cast<int>(std::lround((0.5 * d.w[c] + ox) / unit));
+        int dy = static_cast<int>(std::lround((0.5 * d.h[c] + oy) / unit));
+        dx = std::max(0, std::min(dx, cell.w - 1));
+        dy = std::max(0, std::min(dy, cell.h - 1));
+        pl.nets.back().pins.emplace_back(cell.id, dx, dy);
+        remaining--;
+    }
+    if (remaining > 0) return reader.error(net_line, "net has fewer pins than its degree");
+    return true;
+}
+
+}  // namespace
+
+bool BookshelfReader::isAuxFile(const std::string& filename) {
+    return filename.size() > 4 && filename.compare(filename.size() - 4, 4, ".aux") == 0;
+}
+
+Placement BookshelfReader::readFromAux(const std::string& aux_file, int grid_unit) {
+    MappedFile aux;
+    if (!aux.open(aux_file)) {
+        std::cerr << "Error: Cannot open file " << aux_file << std::endl;
+        return Placement();
+    }
+
+    // RowBasedPlacement : a.nodes a.nets a.wts a.pl a.scl, relative to
+    // the .aux directory
+    std::string dir;
+    size_t slash = aux_file.find_last_of("/\\");
+    if (slash != std::string::npos) dir = aux_file.substr(0, slash + 1);
+    std::string nodes_file, nets_file, pl_file, scl_file;
+    {
+        LineReader reader(aux, aux_file);
+        Line line;
+        while (reader.next(line)) {
+            for (std::string_view token : line.tokens) {
+                auto hasExt = [&](const char* ext) {
+                    std::string_view e(ext);
+                    return token.size() > e.size() && token.substr(token.size() - e.size()) == e;
+                };
+                std::string path = dir + std::string(token);
+                if (hasExt(".nodes")) nodes_file = path;
+                else if (hasExt(".nets")) nets_file = path;
+                else if (hasExt(".pl")) pl_file = path;
+                else if (hasExt(".scl")) scl_file = path;
+            }
+        }
+    }
+    if (nodes_file.empty() || nets_file.empty() || pl_file.empty() || scl_file.empty()) {
+        std::cerr << "Error: " << aux_file << " must name .nodes, .nets, .pl and .scl files" << std::endl;
+        return Placement();
+    }
+
+    MappedFile nodes, nets, pl_map, scl;
+    for (auto entry : {std::make_pair(&nodes, &nodes_file), std::make_pair(&nets, &nets_file),
+                       std::make_pair(&pl_map, &pl_file), std::make_pair(&scl, &scl_file)}) {
+        if (!entry.first->open(*entry.second)) {
+            std::cerr << "Error: Cannot open file " << *entry.second << std::endl;
+            return Placement();
+        }
+    }
+
+    Design d;
+    if (!parseScl(scl, scl_file, d) || !parseNodes(nodes, nodes_file, d) || !parsePl(pl_map, pl_file, d)) {
+        return Placement();
+    }
+
+    // Grid unit: the given one, or the smallest that keeps the grid small
+    const double die_w = d.x1 - d.x0, die_h = d.y1 - d.y0;
+    long long unit = grid_unit > 0 ? grid_unit : 1;
+    auto squares = [&](long long u) {
+        return static_cast<long long>(std::ceil(die_w / u)) * static_cast<long long>(std::ceil(die_h / u));
+    };
+    if (grid_unit <= 0) {
+        while (squares(unit) > kMaxGridSquares) unit++;
+    }
+    const int W = static_cast<int>(std::ceil(die_w / unit));
+    const int H = static_cast<int>(std::ceil(die_h / unit));
+
+    Placement pl;
+    pl.cells.reserve(d.w.size());
+    for (size_t i = 0; i < d.w.size(); ++i) {
+        int w = std::max(1, static_cast<int>(std::lround(d.w[i] / unit)));
+        int h = std::max(1, static_cast<int>(std::lround(d.h[i] / unit)));
+        int x = static_cast<int>(std::lround((d.x[i] - d.x0) / unit));
+        int y = static_cast<int>(std::lround((d.y[i] - d.y0) / unit));
+        const bool fixed = d.fixed[i] != 0;
+        if (!fixed) {
+            // Movable cells start on the die
+            x = std::max(0, std::min(x, W - w));
+            y = std::max(0, std::min(y, H - h));
+        }
+        pl.cells.emplace_back(static_cast<int>(i), x, y, w, h, fixed);
+    }
+    if (!parseNets(nets, nets_file, d, static_cast<double>(unit), pl)) return Placement();
+
+    std::cout << "Bookshelf design: " << pl.cells.size() << " nodes, " << pl.nets.size()
+              << " nets, grid unit " << unit << std::endl;
+    pl.grid = Grid(W, H);
+    pl.buildIndex();
+    pl.updateGrid();
+    return pl;
+}
@@ -0,0 +1,34 @@
+#ifndef BOOKSHELF_READER_H
+#define BOOKSHELF_READER_H
+
+#include "../model/placement.h"
+#include <string>
+
+// Reader for Bookshelf (ISPD contest) benchmarks: an .aux file naming the
+// .nodes, .nets, .pl and .scl files. Each file is memory-mapped and
+// parsed in one pass; node names stay views into the mapped .nodes file,
+// and cells get dense ids in .nodes order. Terminals and /FIXED nodes are
+// fixed. The die is the bounding box of the .scl rows, moved to the
+// origin. Pin offsets, which Bookshelf gives from the node center, are
+// converted to offsets from the lower-left corner.
+//
+// Coordinates are divided by a grid unit (sizes rounded, at least 1) so
+// the occupancy grid stays within kMaxGridSquares; contest designs are
+// tens of thousands of sites wide, so they usually load at a unit of a
+// few sites.
+
+class BookshelfReader {
+public:
+    // Largest grid (W * H) chosen automatically
+    static const long long kMaxGridSquares = 1LL << 26;
+
+    // Read the design named by `aux_file`; grid_unit 0 picks the smallest
+    // unit that fits kMaxGridSquares. Returns an empty Placement, after
+    // printing file:line errors to std::cerr, on missing or malformed files.
+    static Placement readFromAux(const std::string& aux_file, int grid_unit = 0);
+
+    // True if `filename` ends in .aux
+    static bool isAuxFile(const std::string& filename);
+};
+
+#endif // BOOKSHELF_READER_H
@@ -0,0 +1,264 @@
+#include "parallel_reader.h"
+#include "mapped_file.h"
+#include "../util/thread_pool.h"
+#include <charconv>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Tasks per thread, so uneven lines still balance
+const int kTasksPerThread = 4;
+
+// Errors printed before the rest are only counted
+const size_t kMaxReportedErrors = 20;
+
+struct LineError {
+    size_t line;  // 0-based
+    std::string message;
+};
+
+// Whitespace-separated tokens of one line
+class Tokens {
+public:
+    Tokens(const char* begin, const char* end) : p_(begin), end_(end) {}
+
+    bool nextInt(int& value) {
+        skipSpace();
+        auto result = std::from_chars(p_, end_, value);
+        if (result.ec != std::errc() || (result.ptr != end_ && !isSpace(*result.ptr))) return false;
+        p_ = result.ptr;
+        return true;
+    }
+
+    bool nextWord(const char*& begin, const char*& end) {
+        skipSpace();
+        if (p_ == end_) return false;
+        begin = p_;
+        while (p_ != end_ && !isSpace(*p_)) ++p_;
+        end = p_;
+        return true;
+    }
+
+    bool atEnd() {
+        skipSpace();
+        return p_ == end_;
+    }
+
+private:
+    const char* p_;
+    const char* end_;
+
+    static bool isSpace(char c) {
+        return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\v' || c == '\f';
+    }
+
+    void skipSpace() {
+        while (p_ != end_ && isSpace(*p_)) ++p_;
+    }
+};
+
+bool wordIs(const char* begin, const char* end, const char* word) {
+    size_t n = std::strlen(word);
+    return static_cast<size_t>(end - begin) == n && std::memcmp(begin, word, n) == 0;
+}
+
+// Start offset of every line, found in parallel byte chunks
+std::vector<size_t> findLines(const char* data, size_t size, ThreadPool& pool) {
+    const int tasks = kTasksPerThread * pool.size();
+    auto chunkBegin = [&](int t) { return size * static_cast<size_t>(t) / static_cast<size_t>(tasks); };
+
+    std::vector<size_t> counts(tasks + 1, 0);
+    pool.parallelFor(tasks, [&](int t) {
+        size_t count = 0;
+        const char* p = data + chunkBegin(t);
+        const char* end = data + chunkBegin(t + 1);
+        while ((p = static_cast<const char*>(std::memchr(p, '\n', end - p))) != nullptr) {
+            count++;
+            p++;
+        }
+        counts[t + 1] = count;
+    });
+    for (int t = 0; t < tasks; ++t) counts[t + 1] += counts[t];
+
+    // A line starts at 0 and after every newline except a final one
+    std::vector<size_t> starts(counts[tasks] + 1);
+    starts[0] = 0;
+    pool.parallelFor(tasks, [&](int t) {
+        size_t k = counts[t] + 1;
+        const char* p = data + chunkBegin(t);
+        const char* end = data + chunkBegin(t + 1);
+        while ((p = static_cast<const char*>(std::memchr(p, '\n', end - p))) != nullptr) {
+            starts[k++] = static_cast<size_t>(p - data) + 1;
+            p++;
+        }
+    });
+    if (starts.size() > 1 && starts.back() == size) starts.pop_back();
+    return starts;
+}
+
+// Run fn(line) for lines [first, first + count) in parallel chunks,
+// collecting errors in line order
+void parseLines(ThreadPool& pool, size_t first, size_t count,
+                const std::function<bool(size_t, std::string&)>& fn, std::vector<LineError>& errors) {
+    const int tasks = kTasksPerThread * pool.size();
+    std::vector<std::vector<LineError>> task_errors(tasks);
+    pool.parallelFor(tasks, [&](int t) {
+        size_t begin = count * static_cast<size_t>(t) / static_cast<size_t>(tasks);
+        size_t end = count * static_cast<size_t>(t + 1) / static_cast<size_t>(tasks);
+        std::string message;
+        for (size_t i = begin; i < end; ++i) {
+            if (!fn(i, message)) task_errors[t].push_back(LineError{first + i, message});
+        }
+    });
+    for (auto& errs : task_errors) {
+        errors.insert(errors.end(), errs.begin(), errs.end());
+    }
+}
+
+}  // namespace
+
+bool ParallelReader::parseCell(const char* begin, const char* end, Cell& cell, std::string& error) {
+    Tokens tokens(begin, end);
+    int id, x, y, w, h;
+    if (!tokens.nextInt(id) || !tokens.nextInt(x) || !tokens.nextInt(y) ||
+        !tokens.nextInt(w) || !tokens.nextInt(h)) {
+        error = "expected 'cell_id x y w h [fixed]'";
+        return false;
+    }
+    bool fixed = false;
+    const char* word_begin;
+    const char* word_end;
+    if (tokens.nextWord(word_begin, word_end)) {
+        if (wordIs(word_begin, word_end, "fixed") || wordIs(word_begin, word_end, "1") ||
+            wordIs(word_begin, word_end, "true")) {
+            fixed = true;
+        } else if (!wordIs(word_begin, word_end, "0") && !wordIs(word_begin, word_end, "false")) {
+            error = "unknown cell flag '" + std::string(word_begin, word_end) + "'";
+            return false;
+        }
+        if (!tokens.atEnd()) {
+            error = "unexpected text after the cell flag";
+            return false;
+        }
+    }
+    cell = Cell(id, x, y, w, h, fixed);
+    return true;
+}
+
+bool ParallelReader::parseNet(const char* begin, const char* end, Net& net, std::string& error) {
+    Tokens tokens(begin, end);
+    int net_id, num_pins;
+    if (!tokens.nextInt(net_id) || !tokens.nextInt(num_pins) || num_pins < 0) {
+        error = "expected 'net_id num_pins [cell_id offset_x offset_y]*'";
+        return false;
+    }
+    net = Net(net_id);
+    net.pins.reserve(num_pins);
+    for (int j = 0; j < num_pins; ++j) {
+        int cell_id, offset_x, offset_y;
+        if (!tokens.nextInt(cell_id) || !tokens.nextInt(offset_x) || !tokens.nextInt(offset_y)) {
+            error = "expected " + std::to_string(num_pins) + " pins, found " + std::to_string(j);
+            return false;
+        }
+        net.pins.emplace_back(cell_id, offset_x, offset_y);
+    }
+    if (!tokens.atEnd()) {
+        error = "more than " + std::to_string(num_pins) + " pins";
+        return false;
+    }
+    return true;
+}
+
+Placement ParallelReader::readFromFile(const std::string& filename, int num_threads) {
+    Placement pl;
+    MappedFile file;
+    if (!file.open(filename)) {
+        std::cerr << "Error: Cannot open file " << filename << std::endl;
+        return pl;
+    }
+
+    ThreadPool pool(num_threads);
+    const char* data = file.data();
+    const std::vector<size_t> starts = file.size() > 0 ? findLines(data, file.size(), pool)
+                                                       : std::vector<size_t>();
+    const size_t num_lines = starts.size();
+    auto lineBegin = [&](size_t i) { return data + starts[i]; };
+    auto lineEnd = [&](size_t i) { return data + (i + 1 < num_lines ? starts[i + 1] : file.size()); };
+
+    std::vector<LineError> errors;
+    auto fail = [&]() {
+        for (size_t i = 0; i < errors.size() && i < kMaxReportedErrors; ++i) {
+            std::cerr << "Error: " << filename << ":" << errors[i].line + 1 << ": "
+                      << errors[i].message << std::endl;
+        }
+        if (errors.size() > kMaxReportedErrors) {
+            std::cerr << "Error: " << filename << ": " << errors.size() - kMaxReportedErrors
+                      << " more malformed lines" << std::endl;
+        }
+        return Placement();
+    };
+    // Count line: a single non-negative integer
+    auto readCount = [&](size_t line, const char* what, int& count) {
+        if (line >= num_lines) {
+            errors.push_back(LineError{line, std::string("missing ") + what});
+            return false;
+        }
+        Tokens tokens(lineBegin(line), lineEnd(line));
+        if (!tokens.nextInt(count) || count < 0 || !tokens.atEnd()) {
+            errors.push_back(LineError{line, std::string("expected ") + what});
+            return false;
+        }
+        return true;
+    };
+
+    // Grid
+    int W = 0, H = 0;
+    {
+        Tokens tokens(num_lines > 0 ? lineBegin(0) : data, num_lines > 0 ? lineEnd(0) : data);
+        if (!tokens.nextInt(W) || !tokens.nextInt(H) || W < 0 || H < 0 || !tokens.atEnd()) {
+            errors.push_back(LineError{0, "expected 'grid_width grid_height'"});
+            return fail();
+        }
+    }
+
+    // Cells
+    int num_cells = 0;
+    if (!readCount(1, "the cell count", num_cells)) return fail();
+    const size_t first_cell = 2;
+    if (first_cell + num_cells > num_lines) {
+        errors.push_back(LineError{num_lines, "expected " + std::to_string(num_cells) + " cells, found " +
+                                              std::to_string(num_lines - first_cell)});
+        return fail();
+    }
+    pl.cells.resize(num_cells);
+    parseLines(pool, first_cell, num_cells, [&](size_t i, std::string& message) {
+        return parseCell(lineBegin(first_cell + i), lineEnd(first_cell + i), pl.cells[i], message);
+    }, errors);
+
+    // The net section is checked too, so one run reports every bad line
+
+    // Nets
+    int num_nets = 0;
+    const size_t count_line = first_cell + num_cells;
+    if (!readCount(count_line, "the net count", num_nets)) return fail();
+    const size_t first_net = count_line + 1;
+    if (first_net + num_nets > num_lines) {
+        errors.push_back(LineError{num_lines, "expected " + std::to_string(num_nets) + " nets, found " +
+                                              std::to_string(num_lines - first_net)});
+        return fail();
+    }
+    pl.nets.resize(num_nets);
+    parseLines(pool, first_net, num_nets, [&](size_t i, std::string& message) {
+        return parseNet(lineBegin(first_net + i), lineEnd(first_net + i), pl.nets[i], message);
+    }, errors);
+    if (!errors.empty()) return fail();
+
+    pl.grid = Grid(W, H);
+    pl.buildIndex();
+    pl.updateGrid();
+    return pl;
+}
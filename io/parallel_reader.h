@@ -0,0 +1,28 @@
+#ifndef PARALLEL_READER_H
+#define PARALLEL_READER_H
+
+#include "../model/placement.h"
+#include <string>
+
+// Multi-threaded reader for InputReader's text format.
+// The file is memory-mapped, line starts are found by scanning byte
+// chunks in parallel, and the cell and net sections are then parsed in
+// parallel line chunks with std::from_chars, each line straight into its
+// slot. Unlike InputReader, which skips lines it cannot parse, every
+// malformed line is reported with its line number and the read fails.
+// On valid input the result is the same as InputReader's.
+
+class ParallelReader {
+public:
+    // Read `filename` on num_threads threads (0 = hardware concurrency).
+    // Returns an empty Placement, after printing the errors to std::cerr,
+    // if the file cannot be read or is malformed.
+    static Placement readFromFile(const std::string& filename, int num_threads = 0);
+
+private:
+    // Parse one line; false with `error` set if it is malformed
+    static bool parseCell(const char* begin, const char* end, Cell& cell, std::string& error);
+    static bool parseNet(const char* begin, const char* end, Net& net, std::string& error);
+};
+
+#endif // PARALLEL_READER_H
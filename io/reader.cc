@@ -76,6 +76,7 @@ Placement InputReader::readFromFile(const std::string& filename) {
     }
     
     file.close();
+    pl.buildIndex();
     pl.updateGrid();
     return pl;
 }
@@ -0,0 +1,262 @@
+#include "snapshot.h"
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <vector>
+
+const char SnapshotHeader::kMagic[8] = {'P', 'L', 'C', 'S', 'N', 'A', 'P', '\0'};
+
+static_assert(sizeof(int) == 4, "Snapshot arrays are written straight from int vectors");
+static_assert(sizeof(SnapshotHeader) % 8 == 0, "Arrays after the header must stay aligned");
+
+namespace {
+
+const size_t kAlignment = 8;
+
+size_t alignUp(size_t n) {
+    return (n + kAlignment - 1) / kAlignment * kAlignment;
+}
+
+// Element size and count of every array
+void arrayLayout(const SnapshotHeader& h, size_t size[], size_t count[]) {
+    const size_t cells = static_cast<size_t>(h.num_cells);
+    const size_t nets = static_cast<size_t>(h.num_nets);
+    const size_t pins = static_cast<size_t>(h.num_pins);
+    for (int a = 0; a < SnapshotHeader::NUM_ARRAYS; ++a) size[a] = sizeof(int32_t);
+    size[SnapshotHeader::CELL_FIXED] = sizeof(uint8_t);
+
+    count[SnapshotHeader::CELL_ID] = cells;
+    count[SnapshotHeader::CELL_X] = cells;
+    count[SnapshotHeader::CELL_Y] = cells;
+    count[SnapshotHeader::CELL_W] = cells;
+    count[SnapshotHeader::CELL_H] = cells;
+    count[SnapshotHeader::CELL_FIXED] = cells;
+    count[SnapshotHeader::NET_ID] = nets;
+    count[SnapshotHeader::NET_PIN_START] = nets + 1;
+    count[SnapshotHeader::PIN_CELL_ID] = pins;
+    count[SnapshotHeader::PIN_CELL] = pins;
+    count[SnapshotHeader::PIN_DX] = pins;
+    count[SnapshotHeader::PIN_DY] = pins;
+    count[SnapshotHeader::PIN_NET] = pins;
+    count[SnapshotHeader::CELL_PIN_START] = cells + 1;
+    count[SnapshotHeader::CELL_PINS] = pins;
+    count[SnapshotHeader::CELL_NET_START] = cells + 1;
+    count[SnapshotHeader::CELL_NETS] = static_cast<size_t>(h.num_cell_nets);
+}
+
+// CSR start array: starts at 0, never decreases, ends at `total`
+bool validStarts(const ArrayView<int32_t>& start, size_t total) {
+    if (start[0] != 0 || static_cast<size_t>(start[start.size - 1]) != total) return false;
+    for (size_t i = 1; i < start.size; ++i) {
+        if (start[i] < start[i - 1]) return false;
+    }
+    return true;
+}
+
+bool validIndices(const ArrayView<int32_t>& index, int32_t lo, size_t hi) {
+    for (int32_t i : index) {
+        if (i < lo || (i >= 0 && static_cast<size_t>(i) >= hi)) return false;
+    }
+    return true;
+}
+
+void writeArray(std::ofstream& out, const void* data, size_t bytes) {
+    static const char zeros[kAlignment] = {};
+    if (bytes > 0) out.write(static_cast<const char*>(data), static_cast<std::streamsize>(bytes));
+    out.write(zeros, static_cast<std::streamsize>(alignUp(bytes) - bytes));
+}
+
+bool writeIndexed(const Placement& pl, const std::string& filename) {
+    const Netlist& nl = pl.netlist;
+    SnapshotHeader h;
+    std::memcpy(h.magic, SnapshotHeader::kMagic, sizeof(h.magic));
+    h.version = SnapshotHeader::kVersion;
+    h.byte_order = SnapshotHeader::kByteOrder;
+    h.grid_w = pl.grid.W;
+    h.grid_h = pl.grid.H;
+    h.num_cells = pl.cells.size();
+    h.num_nets = pl.nets.size();
+    h.num_pins = nl.pin_cell.size();
+    h.num_cell_nets = nl.cell_nets.size();
+
+    size_t size[SnapshotHeader::NUM_ARRAYS], count[SnapshotHeader::NUM_ARRAYS];
+    arrayLayout(h, size, count);
+    size_t offset = alignUp(sizeof(SnapshotHeader));
+    for (int a = 0; a < SnapshotHeader::NUM_ARRAYS; ++a) {
+        h.offset[a] = offset;
+        offset += alignUp(size[a] * count[a]);
+    }
+
+    // Cells and nets are AoS in the model: gather the columns
+    const size_t n = pl.cells.size();
+    std::vector<int32_t> id(n), x(n), y(n), w(n), hgt(n);
+    std::vector<uint8_t> fixed(n);
+    for (size_t i = 0; i < n; ++i) {
+        const Cell& cell = pl.cells[i];
+        id[i] = cell.id;
+        x[i] = cell.x;
+        y[i] = cell.y;
+        w[i] = cell.w;
+        hgt[i] = cell.h;
+        fixed[i] = cell.fixed ? 1 : 0;
+    }
+    std::vector<int32_t> net_id(pl.nets.size()), pin_cell_id;
+    pin_cell_id.reserve(nl.pin_cell.size());
+    for (size_t i = 0; i < pl.nets.size(); ++i) {
+        net_id[i] = pl.nets[i].id;
+        for (const auto& pin : pl.nets[i].pins) pin_cell_id.push_back(pin.cell_id);
+    }
+
+    std::ofstream out(filename, std::ios::binary);
+    if (!out.is_open()) {
+        std::cerr << "Error: Cannot open file " << filename << std::endl;
+        return false;
+    }
+    writeArray(out, &h, sizeof(h));
+    auto column = [&](const void* data, int a) { writeArray(out, data, size[a] * count[a]); };
+    column(id.data(), SnapshotHeader::CELL_ID);
+    column(x.data(), SnapshotHeader::CELL_X);
+    column(y.data(), SnapshotHeader::CELL_Y);
+    column(w.data(), SnapshotHeader::CELL_W);
+    column(hgt.data(), SnapshotHeader::CELL_H);
+    column(fixed.data(), SnapshotHeader::CELL_FIXED);
+    column(net_id.data(), SnapshotHeader::NET_ID);
+    column(nl.net_pin_start.data(), SnapshotHeader::NET_PIN_START);
+    column(pin_cell_id.data(), SnapshotHeader::PIN_CELL_ID);
+    column(nl.pin_cell.data(), SnapshotHeader::PIN_CELL);
+    column(nl.pin_dx.data(), SnapshotHeader::PIN_DX);
+    column(nl.pin_dy.data(), SnapshotHeader::PIN_DY);
+    column(nl.pin_net.data(), SnapshotHeader::PIN_NET);
+    column(nl.cell_pin_start.data(), SnapshotHeader::CELL_PIN_START);
+    column(nl.cell_pins.data(), SnapshotHeader::CELL_PINS);
+    column(nl.cell_net_start.data(), SnapshotHeader::CELL_NET_START);
+    column(nl.cell_nets.data(), SnapshotHeader::CELL_NETS);
+
+    out.close();
+    if (out.fail()) {
+        std::cerr << "Error: Failed writing " << filename << std::endl;
+        return false;
+    }
+    return true;
+}
+
+template <typename T>
+std::vector<int> toVector(const ArrayView<T>& view) {
+    return std::vector<int>(view.begin(), view.end());
+}
+
+}  // namespace
+
+bool SnapshotView::fail(const std::string& message) {
+    error_ = message;
+    header_ = nullptr;
+    file_.close();
+    return false;
+}
+
+bool SnapshotView::open(const std::string& filename) {
+    error_.clear();
+    if (!file_.open(filename)) return fail("cannot open file");
+    if (file_.size() < sizeof(SnapshotHeader)) return fail("not a placement snapshot");
+    header_ = reinterpret_cast<const SnapshotHeader*>(file_.data());
+
+    const SnapshotHeader& h = *header_;
+    if (std::memcmp(h.magic, SnapshotHeader::kMagic, sizeof(h.magic)) != 0) {
+        return fail("not a placement snapshot");
+    }
+    if (h.byte_order != SnapshotHeader::kByteOrder) return fail("snapshot has the wrong byte order");
+    if (h.version != SnapshotHeader::kVersion) {
+        return fail("unsupported snapshot version " + std::to_string(h.version));
+    }
+    const uint64_t kMaxCount = static_cast<uint64_t>(std::numeric_limits<int32_t>::max()) - 1;
+    if (h.grid_w < 0 || h.grid_h < 0 || h.num_cells > kMaxCount || h.num_nets > kMaxCount ||
+        h.num_pins > kMaxCount || h.num_cell_nets > kMaxCount) {
+        return fail("snapshot header is corrupt");
+    }
+
+    size_t size[SnapshotHeader::NUM_ARRAYS], count[SnapshotHeader::NUM_ARRAYS];
+    arrayLayout(h, size, count);
+    for (int a = 0; a < SnapshotHeader::NUM_ARRAYS; ++a) {
+        const uint64_t begin = h.offset[a];
+        if (begin % alignof(int32_t) != 0 || begin < sizeof(SnapshotHeader) || begin > file_.size() ||
+            size[a] * count[a] > file_.size() - begin) {
+            return fail("snapshot is truncated or corrupt");
+        }
+    }
+    return true;
+}
+
+bool Snapshot::write(const Placement& pl, const std::string& filename) {
+    if (pl.hasIndex()) return writeIndexed(pl, filename);
+    Placement copy = pl.copyWithoutOccupancy();
+    copy.buildIndex();
+    return writeIndexed(copy, filename);
+}
+
+Placement Snapshot::read(const std::string& filename) {
+    Placement pl;
+    SnapshotView view;
+    if (!view.open(filename)) {
+        std::cerr << "Error: " << filename << ": " << view.error() << std::endl;
+        return pl;
+    }
+    const SnapshotHeader& h = view.header();
+    const size_t n = static_cast<size_t>(h.num_cells);
+    const size_t m = static_cast<size_t>(h.num_nets);
+    const size_t p = static_cast<size_t>(h.num_pins);
+
+    // The CSR arrays are used as they are, so check they are consistent
+    if (!validStarts(view.netPinStart(), p) || !validStarts(view.cellPinStart(), p) ||
+        !validStarts(view.cellNetStart(), static_cast<size_t>(h.num_cell_nets)) ||
+        !validIndices(view.pinCell(), -1, n) || !validIndices(view.pinNet(), 0, m) ||
+        !validIndices(view.cellPins(), 0, p) || !validIndices(view.cellNets(), 0, m)) {
+        std::cerr << "Error: " << filename << ": snapshot netlist is inconsistent" << std::endl;
+        return pl;
+    }
+
+    ArrayView<int32_t> id = view.cellId(), x = view.cellX(), y = view.cellY();
+    ArrayView<int32_t> w = view.cellW(), hgt = view.cellH();
+    ArrayView<uint8_t> fixed = view.cellFixed();
+    pl.cells.reserve(n);
+    pl.id_to_index.reserve(n);
+    for (size_t i = 0; i < n; ++i) {
+        pl.cells.emplace_back(id[i], x[i], y[i], w[i], hgt[i], fixed[i] != 0);
+        pl.id_to_index.emplace(id[i], static_cast<int>(i));
+    }
+
+    ArrayView<int32_t> net_id = view.netId(), net_pin_start = view.netPinStart();
+    ArrayView<int32_t> pin_cell_id = view.pinCellId(), dx = view.pinDx(), dy = view.pinDy();
+    pl.nets.resize(m);
+    for (size_t i = 0; i < m; ++i) {
+        Net& net = pl.nets[i];
+        net.id = net_id[i];
+        net.pins.reserve(net_pin_start[i + 1] - net_pin_start[i]);
+        for (int32_t k = net_pin_start[i]; k < net_pin_start[i + 1]; ++k) {
+            net.pins.emplace_back(pin_cell_id[k], dx[k], dy[k]);
+        }
+    }
+
+    Netlist& nl = pl.netlist;
+    nl.net_pin_start = toVector(net_pin_start);
+    nl.pin_cell = toVector(view.pinCell());
+    nl.pin_dx = toVector(dx);
+    nl.pin_dy = toVector(dy);
+    nl.pin_net = toVector(view.pinNet());
+    nl.cell_pin_start = toVector(view.cellPinStart());
+    nl.cell_pins = toVector(view.cellPins());
+    nl.cell_net_start = toVector(view.cellNetStart());
+    nl.cell_nets = toVector(view.cellNets());
+    nl.groupByDegree();
+
+    pl.grid = Grid(h.grid_w, h.grid_h);
+    pl.updateGrid();
+    return pl;
+}
+
+bool Snapshot::isSnapshot(const std::string& filename) {
+    std::ifstream in(filename, std::ios::binary);
+    char magic[sizeof(SnapshotHeader::kMagic)];
+    if (!in.read(magic, sizeof(magic))) return false;
+    return std::memcmp(magic, SnapshotHeader::kMagic, sizeof(magic)) == 0;
+}
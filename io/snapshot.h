@@ -0,0 +1,114 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include "mapped_file.h"
+#include "../model/placement.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Binary placement snapshot.
+// A fixed header is followed by 8-byte aligned arrays: the cells as
+// structure of arrays (id, x, y, w, h, fixed), the nets (id and CSR pin
+// start) and the pins (cell id, offsets), then the rest of the dense CSR
+// Netlist, so loading needs no id lookups. The header records the format
+// version, the byte order, the element counts and the offset of every
+// array. Files are read through a memory map: SnapshotView exposes the
+// arrays in place, and Snapshot::read builds a Placement from them.
+
+struct SnapshotHeader {
+    enum Array {
+        CELL_ID, CELL_X, CELL_Y, CELL_W, CELL_H, CELL_FIXED,
+        NET_ID, NET_PIN_START,
+        PIN_CELL_ID, PIN_CELL, PIN_DX, PIN_DY, PIN_NET,
+        CELL_PIN_START, CELL_PINS, CELL_NET_START, CELL_NETS,
+        NUM_ARRAYS
+    };
+
+    char magic[8];           // kMagic
+    uint32_t version;        // kVersion
+    uint32_t byte_order;     // kByteOrder as written by the producer
+    int32_t grid_w, grid_h;
+    uint64_t num_cells, num_nets, num_pins;
+    uint64_t num_cell_nets;  // Length of CELL_NETS
+    uint64_t offset[NUM_ARRAYS];  // Byte offset of each array in the file
+
+    static const char kMagic[8];
+    static const uint32_t kVersion = 1;
+    static const uint32_t kByteOrder = 0x01020304;
+};
+
+// Typed pointer and length into a mapped array
+template <typename T>
+struct ArrayView {
+    const T* data = nullptr;
+    size_t size = 0;
+
+    const T& operator[](size_t i) const { return data[i]; }
+    const T* begin() const { return data; }
+    const T* end() const { return data + size; }
+};
+
+class SnapshotView {
+public:
+    // Map and validate a snapshot; on failure returns false and sets error()
+    bool open(const std::string& filename);
+
+    const std::string& error() const { return error_; }
+    const SnapshotHeader& header() const { return *header_; }
+
+    ArrayView<int32_t> cellId() const { return array<int32_t>(SnapshotHeader::CELL_ID, cells()); }
+    ArrayView<int32_t> cellX() const { return array<int32_t>(SnapshotHeader::CELL_X, cells()); }
+    ArrayView<int32_t> cellY() const { return array<int32_t>(SnapshotHeader::CELL_Y, cells()); }
+    ArrayView<int32_t> cellW() const { return array<int32_t>(SnapshotHeader::CELL_W, cells()); }
+    ArrayView<int32_t> cellH() const { return array<int32_t>(SnapshotHeader::CELL_H, cells()); }
+    ArrayView<uint8_t> cellFixed() const { return array<uint8_t>(SnapshotHeader::CELL_FIXED, cells()); }
+    ArrayView<int32_t> netId() const { return array<int32_t>(SnapshotHeader::NET_ID, nets()); }
+    ArrayView<int32_t> netPinStart() const { return array<int32_t>(SnapshotHeader::NET_PIN_START, nets() + 1); }
+    ArrayView<int32_t> pinCellId() const { return array<int32_t>(SnapshotHeader::PIN_CELL_ID, pins()); }
+    ArrayView<int32_t> pinCell() const { return array<int32_t>(SnapshotHeader::PIN_CELL, pins()); }
+    ArrayView<int32_t> pinDx() const { return array<int32_t>(SnapshotHeader::PIN_DX, pins()); }
+    ArrayView<int32_t> pinDy() const { return array<int32_t>(SnapshotHeader::PIN_DY, pins()); }
+    ArrayView<int32_t> pinNet() const { return array<int32_t>(SnapshotHeader::PIN_NET, pins()); }
+    ArrayView<int32_t> cellPinStart() const { return array<int32_t>(SnapshotHeader::CELL_PIN_START, cells() + 1); }
+    ArrayView<int32_t> cellPins() const { return array<int32_t>(SnapshotHeader::CELL_PINS, pins()); }
+    ArrayView<int32_t> cellNetStart() const { return array<int32_t>(SnapshotHeader::CELL_NET_START, cells() + 1); }
+    ArrayView<int32_t> cellNets() const {
+        return array<int32_t>(SnapshotHeader::CELL_NETS, static_cast<size_t>(header_->num_cell_nets));
+    }
+
+private:
+    MappedFile file_;
+    const SnapshotHeader* header_ = nullptr;
+    std::string error_;
+
+    size_t cells() const { return static_cast<size_t>(header_->num_cells); }
+    size_t nets() const { return static_cast<size_t>(header_->num_nets); }
+    size_t pins() const { return static_cast<size_t>(header_->num_pins); }
+
+    template <typename T>
+    ArrayView<T> array(int a, size_t size) const {
+        ArrayView<T> view;
+        view.data = reinterpret_cast<const T*>(file_.data() + header_->offset[a]);
+        view.size = size;
+        return view;
+    }
+
+    bool fail(const std::string& message);
+};
+
+class Snapshot {
+public:
+    // Write a placement (cells, nets and current positions); builds the
+    // dense index on a copy if `pl` has none. Returns false on I/O errors.
+    static bool write(const Placement& pl, const std::string& filename);
+
+    // Load a snapshot; an empty Placement (with an error on std::cerr) if
+    // the file is missing or not a valid snapshot
+    static Placement read(const std::string& filename);
+
+    // True if the file starts with the snapshot magic
+    static bool isSnapshot(const std::string& filename);
+};
+
+#endif // SNAPSHOT_H
@@ -0,0 +1,294 @@
+#include "abacus.h"
+#include "legalize.h"
+#include "../util/profiler.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+
+namespace {
+
+int roundPos(double x) {
+    return static_cast<int>(std::floor(x + 0.5));
+}
+
+// Lower bound on the y displacement to a row d rows from the nearest one
+double minRowDistance(int d, int row_h) {
+    return d == 0 ? 0.0 : (d - 0.5) * row_h;
+}
+
+double clampPos(double x, int lo, int hi) {
+    return std::max(static_cast<double>(lo), std::min(x, static_cast<double>(hi)));
+}
+
+// Intersection of two sorted lists of disjoint intervals
+std::vector<std::pair<int, int>> intersect(const std::vector<std::pair<int, int>>& a,
+                                           const std::vector<std::pair<int, int>>& b) {
+    std::vector<std::pair<int, int>> out;
+    size_t i = 0, j = 0;
+    while (i < a.size() && j < b.size()) {
+        int l = std::max(a[i].first, b[j].first);
+        int r = std::min(a[i].second, b[j].second);
+        if (l < r) out.push_back({l, r});
+        if (a[i].second < b[j].second) ++i; else ++j;
+    }
+    return out;
+}
+
+}  // namespace
+
+double AbacusLegalizer::trialCost(const Segment& seg, double target_x, int w, int& new_x) {
+    // Collapse a copy of the tail: the new cell starts as its own cluster
+    double e = 1.0;
+    double q = target_x;
+    int cw = w;
+    int idx = static_cast<int>(seg.clusters.size()) - 1;
+    double x = clampPos(q / e, seg.l, seg.r - cw);
+    while (idx >= 0 && seg.clusters[idx].x + seg.clusters[idx].w > x) {
+        const Cluster& prev = seg.clusters[idx];
+        q = prev.q + q - e * prev.w;
+        e += prev.e;
+        cw += prev.w;
+        --idx;
+        x = clampPos(q / e, seg.l, seg.r - cw);
+    }
+    new_x = roundPos(x) + cw - w;
+    return std::abs(new_x - target_x);
+}
+
+void AbacusLegalizer::append(Segment& seg, int cell_idx, double target_x, int w) {
+    Cluster c;
+    c.e = 1.0;
+    c.q = target_x;
+    c.w = w;
+    c.first = static_cast<int>(seg.cells.size());
+    c.x = clampPos(target_x, seg.l, seg.r - w);
+    seg.cells.push_back(cell_idx);
+    seg.used += w;
+
+    // Merge into the previous cluster while they overlap
+    while (!seg.clusters.empty() && seg.clusters.back().x + seg.clusters.back().w > c.x) {
+        Cluster prev = seg.clusters.back();
+        seg.clusters.pop_back();
+        prev.q += c.q - c.e * prev.w;
+        prev.e += c.e;
+        prev.w += c.w;
+        prev.x = clampPos(prev.q / prev.e, seg.l, seg.r - prev.w);
+        c = prev;
+    }
+    seg.clusters.push_back(c);
+}
+
+void AbacusLegalizer::block(Rows& rows, int r0, int r1, int x0, int x1) {
+    for (int r = std::max(0, r0); r < std::min(r1, static_cast<int>(rows.size())); ++r) {
+        std::vector<Segment> kept;
+        for (const Segment& seg : rows[r]) {
+            if (seg.r <= x0 || seg.l >= x1) {
+                kept.push_back(seg);
+                continue;
+            }
+            if (seg.l < x0) {
+                Segment left;
+                left.l = seg.l;
+                left.r = x0;
+                kept.push_back(left);
+            }
+            if (seg.r > x1) {
+                Segment right;
+                right.l = x1;
+                right.r = seg.r;
+                kept.push_back(right);
+            }
+        }
+        rows[r].swap(kept);
+    }
+}
+
+int AbacusLegalizer::rowHeight(const Placement& pl) {
+    int row_h = 0;
+    for (const auto& cell : pl.cells) {
+        if (!cell.fixed && (row_h == 0 || cell.h < row_h)) row_h = cell.h;
+    }
+    return row_h;
+}
+
+void AbacusLegalizer::placeInRegion(Placement& pl, const std::vector<int>& cells, int row_h,
+                                    int x0, int y0, int x1, int y1, std::vector<int>& failed) {
+    // Rows lying entirely inside the region; row r spans [r * row_h, (r + 1) * row_h)
+    const int row_lo = (std::max(0, y0) + row_h - 1) / row_h;
+    const int row_hi = std::min(y1, pl.grid.H) / row_h;
+    const int num_rows = std::max(0, row_hi - row_lo);
+    x0 = std::max(0, x0);
+    x1 = std::min(x1, pl.grid.W);
+
+    // Free segments: each row minus the fixed cells crossing it
+    Rows rows(num_rows);
+    for (int r = 0; r < num_rows && x0 < x1; ++r) {
+        Segment whole;
+        whole.l = x0;
+        whole.r = x1;
+        rows[r].push_back(whole);
+    }
+    for (const auto& cell : pl.cells) {
+        if (!cell.fixed) continue;
+        int r0 = std::max(0, cell.y) / row_h - row_lo;
+        int r1 = (std::max(0, cell.y + cell.h) + row_h - 1) / row_h - row_lo;
+        block(rows, r0, r1, cell.x, cell.x + cell.w);
+    }
+
+    std::vector<int> multi_row, single_row;
+    for (int i : cells) {
+        (pl.cells[i].h > row_h ? multi_row : single_row).push_back(i);
+    }
+    auto by_x = [&pl](int a, int b) {
+        if (pl.cells[a].x != pl.cells[b].x) return pl.cells[a].x < pl.cells[b].x;
+        return a < b;
+    };
+    std::sort(multi_row.begin(), multi_row.end(), by_x);
+    std::sort(single_row.begin(), single_row.end(), by_x);
+
+    // Rows below are local to the region
+    auto row_y = [&](int r) { return (row_lo + r) * row_h; };
+    auto nearest_row = [&](const Cell& cell, int span) {
+        int r = roundPos(static_cast<double>(cell.y) / row_h) - row_lo;
+        return std::max(0, std::min(num_rows - span, r));
+    };
+
+    const double inf = std::numeric_limits<double>::infinity();
+    uint64_t steps = 0;  // Candidate spots and segment trials
+
+    // Multi-row cells: nearest spot free in every spanned row
+    for (int idx : multi_row) {
+        Cell& cell = pl.cells[idx];
+        const int span = (cell.h + row_h - 1) / row_h;
+        const int r_target = nearest_row(cell, span);
+        double best = inf;
+        int best_r = -1, best_x = 0;
+
+        for (int d = 0; d < num_rows && minRowDistance(d, row_h) < best; ++d) {
+            for (int side = 0; side < (d == 0 ? 1 : 2); ++side) {
+                int r = side == 0 ? r_target - d : r_target + d;
+                if (r < 0 || r + span > num_rows) continue;
+                std::vector<std::pair<int, int>> free;
+                for (const Segment& seg : rows[r]) free.push_back({seg.l, seg.r});
+                for (int k = 1; k < span && !free.empty(); ++k) {
+                    std::vector<std::pair<int, int>> next;
+                    for (const Segment& seg : rows[r + k]) next.push_back({seg.l, seg.r});
+                    free = intersect(free, next);
+                }
+                for (const auto& iv : free) {
+                    steps++;
+                    if (iv.second - iv.first < cell.w) continue;
+                    int x = std::max(iv.first, std::min(cell.x, iv.second - cell.w));
+                    double c = std::abs(x - cell.x) + std::abs(row_y(r) - cell.y);
+                    if (c < best) {
+                        best = c;
+                        best_r = r;
+                        best_x = x;
+                    }
+                }
+            }
+        }
+
+        if (best_r < 0) {
+            failed.push_back(idx);
+            continue;
+        }
+        cell.x = best_x;
+        cell.y = row_y(best_r);
+        block(rows, best_r, best_r + span, cell.x, cell.x + cell.w);
+    }
+
+    // Single-row cells: Abacus, row by row outwards from the target row
+    for (int idx : single_row) {
+        const Cell& cell = pl.cells[idx];
+        const int r_target = nearest_row(cell, 1);
+        double best = inf;
+        int best_r = -1, best_s = -1;
+
+        for (int d = 0; d < num_rows && minRowDistance(d, row_h) < best; ++d) {
+            for (int side = 0; side < (d == 0 ? 1 : 2); ++side) {
+                int r = side == 0 ? r_target - d : r_target + d;
+                if (r < 0 || r >= num_rows) continue;
+                const std::vector<Segment>& segs = rows[r];
+                double dy = std::abs(row_y(r) - cell.y);
+
+                // Segment containing the target, then the nearest with room on each side
+                int s0 = static_cast<int>(std::upper_bound(segs.begin(), segs.end(), cell.x,
+                    [](int x, const Segment& seg) { return x < seg.l; }) - segs.begin()) - 1;
+                auto fits = [&](int s) { return segs[s].r - segs[s].l - segs[s].used >= cell.w; };
+                int left = s0, right = s0 + 1;
+                while (left >= 0 && !fits(left)) --left;
+                while (right < static_cast<int>(segs.size()) && !fits(right)) ++right;
+
+                for (int s : {left, right}) {
+                    if (s < 0 || s >= static_cast<int>(segs.size())) continue;
+                    int x;
+                    steps++;
+                    double c = trialCost(segs[s], cell.x, cell.w, x) + dy;
+                    if (c < best) {
+                        best = c;
+                        best_r = r;
+                        best_s = s;
+                    }
+                }
+            }
+        }
+
+        if (best_r < 0) {
+            failed.push_back(idx);
+            continue;
+        }
+        append(rows[best_r][best_s], idx, cell.x, cell.w);
+        pl.cells[idx].y = row_y(best_r);
+    }
+
+    // Write cluster positions back; cells of a cluster abut left to right
+    for (auto& row : rows) {
+        for (const Segment& seg : row) {
+            for (size_t c = 0; c < seg.clusters.size(); ++c) {
+                const Cluster& cl = seg.clusters[c];
+                int end = c + 1 < seg.clusters.size()
+                    ? seg.clusters[c + 1].first : static_cast<int>(seg.cells.size());
+                int x = roundPos(cl.x);
+                for (int k = cl.first; k < end; ++k) {
+                    Cell& cell = pl.cells[seg.cells[k]];
+                    cell.x = x;
+                    x += cell.w;
+                }
+            }
+        }
+    }
+    Profiler::count(Profiler::LEGAL_SEARCH_STEPS, steps);
+}
+
+void AbacusLegalizer::legalize(Placement& pl) {
+    std::cout << "Legalizing placement (Abacus)..." << std::endl;
+
+    const std::vector<Cell> before = pl.cells;
+    const int row_h = rowHeight(pl);
+    if (row_h <= 0) {
+        std::cout << "No movable cells to legalize" << std::endl;
+        return;
+    }
+
+    std::vector<int> cells;
+    for (size_t i = 0; i < pl.cells.size(); ++i) {
+        if (!pl.cells[i].fixed) cells.push_back(static_cast<int>(i));
+    }
+    std::vector<int> failed;
+    placeInRegion(pl, cells, row_h, 0, 0, pl.grid.W, pl.grid.H, failed);
+
+    // Anything that did not fit a row goes to the nearest free spot
+    Legalizer::paintGridExcept(pl, failed);
+    int fallback = Legalizer::placeRemaining(pl, failed);
+
+    std::cout << "Legalized " << cells.size() - failed.size() + fallback
+              << " cells in " << pl.grid.H / row_h << " rows of height " << row_h;
+    if (!failed.empty()) {
+        std::cout << " (" << fallback << " of " << failed.size() << " unplaced cells by fallback)";
+    }
+    std::cout << std::endl;
+    Legalizer::reportDisplacement(before, pl);
+}
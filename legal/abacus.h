@@ -0,0 +1,64 @@
+#ifndef ABACUS_H
+#define ABACUS_H
+
+#include "../model/placement.h"
+#include <vector>
+
+// Row-based legalization (Abacus with Tetris for multi-row cells).
+// The grid is cut into rows of the smallest movable cell height, and each
+// row into free intervals (segments) between fixed cells. Multi-row cells
+// are placed first, greedily in x order at the nearest position that is
+// free in every row they span, and then split the segments they cover.
+// Single-row cells are then placed in x order with Abacus: each cell is
+// appended to the segment that minimises its displacement, and clusters of
+// abutting cells collapse to the position minimising the total squared
+// displacement of their cells. Cells that do not fit anywhere fall back to
+// Legalizer::findFreePosition.
+
+class AbacusLegalizer {
+public:
+    static void legalize(Placement& pl);
+
+    // Row height: smallest movable cell height (0 without movable cells)
+    static int rowHeight(const Placement& pl);
+
+    // Place `cells` (dense indices) in the rows lying inside [x0, x1) x
+    // [y0, y1), with rows of height row_h starting at y = 0. Only the given
+    // cells are written and the grid is not touched, so disjoint regions can
+    // be placed concurrently. Cells that fit nowhere keep their position and
+    // are appended to `failed`.
+    static void placeInRegion(Placement& pl, const std::vector<int>& cells, int row_h,
+                              int x0, int y0, int x1, int y1, std::vector<int>& failed);
+
+private:
+    // Run of abutting cells placed as one block
+    struct Cluster {
+        double e;   // Total weight (number of cells)
+        double q;   // Weighted sum of target positions, relative to the cluster start
+        int w;      // Total width
+        int first;  // First cell of the cluster in Segment::cells
+        double x;   // Optimal (real-valued) position
+    };
+
+    // Free interval [l, r) of a row with the cells placed in it
+    struct Segment {
+        int l, r;
+        int used = 0;                  // Total width of placed cells
+        std::vector<int> cells;        // Placed cells, left to right
+        std::vector<Cluster> clusters;
+    };
+
+    typedef std::vector<std::vector<Segment>> Rows;
+
+    // x displacement of appending a cell (target x, width w) to a segment,
+    // without changing it; new_x receives the cell's position
+    static double trialCost(const Segment& seg, double target_x, int w, int& new_x);
+
+    // Append a cell to a segment and collapse its clusters
+    static void append(Segment& seg, int cell_idx, double target_x, int w);
+
+    // Remove [x0, x1) from rows [r0, r1)
+    static void block(Rows& rows, int r0, int r1, int x0, int x1);
+};
+
+#endif // ABACUS_H
@@ -1,20 +1,36 @@
 #include "legalize.h"
+#include "../model/spatial_index.h"
+#include "../util/profiler.h"
 #include <algorithm>
 #include <cmath>
 #include <iostream>
 
-void Legalizer::clearCellFromGrid(Placement& pl, int cell_id) {
-    for (int y = 0; y < pl.grid.H; ++y) {
-        for (int x = 0; x < pl.grid.W; ++x) {
-            if (pl.grid.occ[y][x] == cell_id) {
-                pl.grid.occ[y][x] = -1;
-            }
+bool Legalizer::canPlace(const Placement& pl, const Cell& cell, int x, int y) {
+    return canPlaceIn(pl, cell, x, y, 0, 0, pl.grid.W, pl.grid.H);
+}
+
+void Legalizer::Pending::add(const Cell& cell, int delta) {
+    int cx0 = std::max(cell.x, x0), cx1 = std::min(cell.x + cell.w, x0 + w);
+    int cy0 = std::max(cell.y, y0), cy1 = std::min(cell.y + cell.h, y0 + h);
+    for (int y = cy0; y < cy1; ++y) {
+        for (int x = cx0; x < cx1; ++x) {
+            cover[static_cast<size_t>(y - y0) * w + (x - x0)] += delta;
         }
     }
 }
 
-bool Legalizer::canPlace(const Placement& pl, const Cell& cell, int x, int y) {
+bool Legalizer::Pending::blocks(int x, int y, const Cell& self) const {
+    if (x >= self.x && x < self.x + self.w && y >= self.y && y < self.y + self.h) return false;
+    if (x < x0 || x >= x0 + w || y < y0 || y >= y0 + h) return false;
+    return cover[static_cast<size_t>(y - y0) * w + (x - x0)] != 0;
+}
+
+bool Legalizer::canPlaceIn(const Placement& pl, const Cell& cell, int x, int y,
+                           int x0, int y0, int x1, int y1, const Pending* pending) {
     // Check bounds
+    if (x < x0 || y < y0 || x + cell.w > x1 || y + cell.h > y1) {
+        return false;
+    }
     if (x < 0 || y < 0 || x + cell.w > pl.grid.W || y + cell.h > pl.grid.H) {
         return false;
     }
@@ -26,11 +42,12 @@ bool Legalizer::canPlace(const Placement& pl, const Cell& cell, int x, int y) {
             int gy = y + dy;
             
             if (pl.grid.isOccupied(gx, gy)) {
-                int occupied_id = pl.grid.occ[gy][gx];
+                int occupied_id = pl.grid.cellAt(gx, gy);
                 if (occupied_id != cell.id && occupied_id != -1) {
                     return false;
                 }
             }
+            if (pending && pending->blocks(gx, gy, cell)) return false;
         }
     }
     
@@ -38,16 +55,32 @@ bool Legalizer::canPlace(const Placement& pl, const Cell& cell, int x, int y) {
 }
 
 bool Legalizer::findFreePosition(const Placement& pl, const Cell& cell, int& new_x, int& new_y) {
+    return findFreePosition(pl, cell, new_x, new_y, 0, 0, pl.grid.W, pl.grid.H);
+}
+
+bool Legalizer::findFreePosition(const Placement& pl, const Cell& cell, int& new_x, int& new_y,
+                                 int x0, int y0, int x1, int y1, int search_radius) {
+    return searchFree(pl, cell, new_x, new_y, x0, y0, x1, y1, search_radius, nullptr);
+}
+
+bool Legalizer::searchFree(const Placement& pl, const Cell& cell, int& new_x, int& new_y,
+                           int x0, int y0, int x1, int y1, int search_radius,
+                           const Pending* pending) {
     // Try current position first
-    if (canPlace(pl, cell, cell.x, cell.y)) {
+    if (canPlaceIn(pl, cell, cell.x, cell.y, x0, y0, x1, y1, pending)) {
         new_x = cell.x;
         new_y = cell.y;
+        Profiler::count(Profiler::LEGAL_SEARCH_STEPS);
         return true;
     }
     
-    // Search in expanding spiral from current position
-    int max_radius = std::max(pl.grid.W, pl.grid.H);
+    // Search in expanding spiral from current position until the square
+    // covers the whole search area
+    int max_radius = std::max(std::max(std::abs(cell.x - x0), std::abs(x1 - cell.x)),
+                              std::max(std::abs(cell.y - y0), std::abs(y1 - cell.y)));
+    if (search_radius > 0) max_radius = std::min(max_radius, search_radius + 1);
     
+    uint64_t steps = 1;
     for (int radius = 1; radius < max_radius; ++radius) {
         // Try positions in a square around current position
         for (int dy = -radius; dy <= radius; ++dy) {
@@ -58,64 +91,172 @@ bool Legalizer::findFreePosition(const Placement& pl, const Cell& cell, int& new
                 int x = cell.x + dx;
                 int y = cell.y + dy;
                 
-                if (canPlace(pl, cell, x, y)) {
+                steps++;
+                if (canPlaceIn(pl, cell, x, y, x0, y0, x1, y1, pending)) {
                     new_x = x;
                     new_y = y;
+                    Profiler::count(Profiler::LEGAL_SEARCH_STEPS, steps);
                     return true;
                 }
             }
         }
     }
     
+    Profiler::count(Profiler::LEGAL_SEARCH_STEPS, steps);
     return false;
 }
 
-void Legalizer::legalize(Placement& pl) {
-    std::cout << "Legalizing placement..." << std::endl;
+std::vector<int> Legalizer::illegalCells(const Placement& pl) {
+    SpatialIndex index;
+    index.build(pl);
     
-    // Sort cells by area (larger cells first) for better legalization
-    std::vector<Cell*> cell_ptrs;
-    for (auto& cell : pl.cells) {
-        if (!cell.fixed) {
-            cell_ptrs.push_back(&cell);
+    std::vector<int> cells;
+    for (size_t i = 0; i < pl.cells.size(); ++i) {
+        const Cell& cell = pl.cells[i];
+        if (cell.fixed) continue;
+        
+        bool legal = cell.x >= 0 && cell.y >= 0 &&
+                     cell.x + cell.w <= pl.grid.W && cell.y + cell.h <= pl.grid.H;
+        if (legal) {
+            index.query(cell.x, cell.y, cell.x + cell.w, cell.y + cell.h, [&](int j) {
+                if (j != static_cast<int>(i)) legal = false;
+            });
+        }
+        
+        if (!legal) {
+            cells.push_back(static_cast<int>(i));
         }
     }
+    return cells;
+}
+
+int Legalizer::legalizeInRegion(Placement& pl, std::vector<int> cells,
+                                int x0, int y0, int x1, int y1, std::vector<int>& failed,
+                                int search_radius) {
+    // Sort cells by area (larger cells first) for better legalization
+    std::stable_sort(cells.begin(), cells.end(),
+                     [&pl](int a, int b) {
+                         const Cell& ca = pl.cells[a];
+                         const Cell& cb = pl.cells[b];
+                         return (ca.w * ca.h) > (cb.w * cb.h);
+                     });
     
-    std::sort(cell_ptrs.begin(), cell_ptrs.end(),
-              [](const Cell* a, const Cell* b) {
-                  return (a->w * a->h) > (b->w * b->h);
-              });
+    // Lift `cells` off the grid inside the region. Until its turn, a cell
+    // still blocks the others except where they overlapped it
+    Pending pending;
+    pending.x0 = std::max(x0, 0);
+    pending.y0 = std::max(y0, 0);
+    pending.w = std::max(std::min(x1, pl.grid.W) - pending.x0, 0);
+    pending.h = std::max(std::min(y1, pl.grid.H) - pending.y0, 0);
+    pending.cover.assign(static_cast<size_t>(pending.w) * pending.h, 0);
+    std::vector<Cell> inside(cells.size());
+    for (size_t i = 0; i < cells.size(); ++i) {
+        const Cell& cell = pl.cells[cells[i]];
+        inside[i] = cell;
+        inside[i].x = std::max(cell.x, x0);
+        inside[i].y = std::max(cell.y, y0);
+        inside[i].w = std::min(cell.x + cell.w, x1) - inside[i].x;
+        inside[i].h = std::min(cell.y + cell.h, y1) - inside[i].y;
+        if (inside[i].w > 0 && inside[i].h > 0) {
+            pl.grid.erase(inside[i]);
+            pending.add(inside[i], 1);
+        }
+    }
     
-    // Clear grid
-    pl.updateGrid();
+    // Free squares in the region; a cell larger than what is left cannot
+    // fit and skips the search
+    long long free_area = 0;
+    for (int y = pending.y0; y < pending.y0 + pending.h; ++y) {
+        for (int x = pending.x0; x < pending.x0 + pending.w; ++x) {
+            if (!pl.grid.isOccupied(x, y)) free_area++;
+        }
+    }
     
-    // Legalize each cell
     int legalized = 0;
-    for (Cell* cell : cell_ptrs) {
-        // Temporarily remove cell from grid
-        clearCellFromGrid(pl, cell->id);
+    for (size_t i = 0; i < cells.size(); ++i) {
+        const int idx = cells[i];
+        Cell& cell = pl.cells[idx];
+        if (inside[i].w > 0 && inside[i].h > 0) pending.add(inside[i], -1);
         
         int new_x, new_y;
-        if (findFreePosition(pl, *cell, new_x, new_y)) {
-            cell->x = new_x;
-            cell->y = new_y;
+        if (static_cast<long long>(cell.w) * cell.h <= free_area &&
+            searchFree(pl, cell, new_x, new_y, x0, y0, x1, y1, search_radius, &pending)) {
+            cell.x = new_x;
+            cell.y = new_y;
+            pl.insertCell(idx);
+            free_area -= static_cast<long long>(cell.w) * cell.h;
             legalized++;
         } else {
-            std::cerr << "Warning: Could not legalize cell " << cell->id << std::endl;
-        }
-        
-        // Update grid with new position
-        for (int dy = 0; dy < cell->h; ++dy) {
-            for (int dx = 0; dx < cell->w; ++dx) {
-                int gx = cell->x + dx;
-                int gy = cell->y + dy;
-                if (pl.grid.isValid(gx, gy)) {
-                    pl.grid.setOccupied(gx, gy, cell->id);
-                }
-            }
+            failed.push_back(idx);
         }
     }
+    return legalized;
+}
+
+void Legalizer::paintGridExcept(Placement& pl, const std::vector<int>& cells) {
+    if (!pl.grid.hasOccupancy()) return;
     
-    std::cout << "Legalized " << legalized << " cells" << std::endl;
+    std::vector<char> skip(pl.cells.size(), 0);
+    for (int idx : cells) skip[idx] = 1;
+    pl.grid.clear();
+    for (size_t i = 0; i < pl.cells.size(); ++i) {
+        if (!skip[i]) pl.grid.paint(pl.cells[i]);
+    }
 }
 
+int Legalizer::placeRemaining(Placement& pl, const std::vector<int>& cells) {
+    int placed = 0;
+    for (int idx : cells) {
+        Cell& cell = pl.cells[idx];
+        int new_x, new_y;
+        if (findFreePosition(pl, cell, new_x, new_y)) {
+            cell.x = new_x;
+            cell.y = new_y;
+            placed++;
+        } else {
+            std::cerr << "Warning: Could not legalize cell " << cell.id << std::endl;
+        }
+        pl.insertCell(idx);
+    }
+    return placed;
+}
+
+void Legalizer::reportDisplacement(const std::vector<Cell>& before, const Placement& pl) {
+    long long total = 0;
+    int max_disp = 0;
+    for (size_t i = 0; i < pl.cells.size() && i < before.size(); ++i) {
+        int d = std::abs(pl.cells[i].x - before[i].x) + std::abs(pl.cells[i].y - before[i].y);
+        total += d;
+        max_disp = std::max(max_disp, d);
+    }
+    std::cout << "Displacement: total = " << total << ", max = " << max_disp << std::endl;
+}
+
+void Legalizer::legalize(Placement& pl) {
+    std::cout << "Legalizing placement..." << std::endl;
+    const std::vector<Cell> before = pl.cells;
+    
+    // Cells that are inside the grid and overlap nothing are already legal;
+    // they keep their spot and only the rest is re-placed
+    std::vector<int> order = illegalCells(pl);
+    int movable = 0;
+    for (const auto& cell : pl.cells) {
+        if (!cell.fixed) movable++;
+    }
+    int already_legal = movable - static_cast<int>(order.size());
+    
+    // Clear grid
+    pl.updateGrid();
+    
+    // Legalize each cell; the rest stay where they are
+    std::vector<int> failed;
+    int legalized = legalizeInRegion(pl, order, 0, 0, pl.grid.W, pl.grid.H, failed);
+    for (int idx : failed) {
+        std::cerr << "Warning: Could not legalize cell " << pl.cells[idx].id << std::endl;
+        pl.insertCell(idx);
+    }
+    
+    std::cout << "Legalized " << legalized << " cells ("
+              << already_legal << " already legal)" << std::endl;
+    reportDisplacement(before, pl);
+}
@@ -2,6 +2,7 @@
 #define LEGALIZE_H
 
 #include "../model/placement.h"
+#include <vector>
 
 // Legalization: remove overlaps by snapping cells to free grid positions
 
@@ -13,12 +14,57 @@ public:
     // Find nearest free position for a cell
     static bool findFreePosition(const Placement& pl, const Cell& cell, int& new_x, int& new_y);
     
+    // Same, with the cell kept inside [x0, x1) x [y0, y1) and, if
+    // search_radius > 0, at most that far from its position on either axis
+    static bool findFreePosition(const Placement& pl, const Cell& cell, int& new_x, int& new_y,
+                                 int x0, int y0, int x1, int y1, int search_radius = 0);
+    
     // Check if a cell can be placed at a position without overlap
     static bool canPlace(const Placement& pl, const Cell& cell, int x, int y);
     
+    // Movable cells that are outside the grid or overlap another cell
+    static std::vector<int> illegalCells(const Placement& pl);
+    
+    // Legalize `cells` (dense indices) in area order inside [x0, x1) x
+    // [y0, y1) against the grid and paint them at their new spots. A cell
+    // waiting for its turn blocks the others except where they overlapped
+    // it. Cells with no free spot there are left off the grid and appended to
+    // `failed`, as are cells searched for beyond search_radius (if > 0) and
+    // cells larger than the free area left. Only grid squares inside the
+    // rectangle are read or written, so disjoint rectangles can be
+    // legalized concurrently. Returns the number of cells placed.
+    static int legalizeInRegion(Placement& pl, std::vector<int> cells,
+                                int x0, int y0, int x1, int y1, std::vector<int>& failed,
+                                int search_radius = 0);
+    
+    // Rebuild the grid from every cell except `cells`
+    static void paintGridExcept(Placement& pl, const std::vector<int>& cells);
+    
+    // Place cells that are not on the grid at the nearest free spot, in
+    // order; returns the number placed
+    static int placeRemaining(Placement& pl, const std::vector<int>& cells);
+    
+    // Print total and maximum Manhattan displacement from `before`
+    static void reportDisplacement(const std::vector<Cell>& before, const Placement& pl);
+    
 private:
-    // Helper to clear cell from grid
-    static void clearCellFromGrid(Placement& pl, int cell_id);
+    // Cells legalizeInRegion has lifted off the grid but not placed yet:
+    // cover counts over the region [x0, x0 + w) x [y0, y0 + h). They block
+    // the cell being placed everywhere except on its own old footprint.
+    struct Pending {
+        int x0, y0, w, h;
+        std::vector<int> cover;
+        
+        void add(const Cell& cell, int delta);
+        bool blocks(int x, int y, const Cell& self) const;
+    };
+    
+    static bool canPlaceIn(const Placement& pl, const Cell& cell, int x, int y,
+                           int x0, int y0, int x1, int y1, const Pending* pending = nullptr);
+    
+    static bool searchFree(const Placement& pl, const Cell& cell, int& new_x, int& new_y,
+                           int x0, int y0, int x1, int y1, int search_radius,
+                           const Pending* pending);
 };
 
 #endif // LEGALIZE_H
@@ -0,0 +1,218 @@
+#include "parallel_legalize.h"
+#include "abacus.h"
+#include "legalize.h"
+#include "../util/profiler.h"
+#include "../util/thread_pool.h"
+#include <algorithm>
+#include <iostream>
+
+namespace {
+
+// Upper bound on regions chosen automatically, and cells per region
+const int kMaxAutoRegions = 64;
+const int kCellsPerRegion = 4096;
+
+int floorPow2(int n) {
+    int p = 1;
+    while (p * 2 <= n) p *= 2;
+    return p;
+}
+
+int center(const Placement& pl, int idx, bool along_x) {
+    const Cell& cell = pl.cells[idx];
+    int c = along_x ? cell.x + cell.w / 2 : cell.y + cell.h / 2;
+    int extent = along_x ? pl.grid.W : pl.grid.H;
+    return std::max(0, std::min(c, extent - 1));
+}
+
+void bisect(const Placement& pl, LegalRegion region, int levels, int align_y,
+            std::vector<LegalRegion>& out) {
+    const int width = region.x1 - region.x0;
+    const int height = region.y1 - region.y0;
+    // Horizontal cuts stay on row boundaries with a row on each side
+    const int y_lo = (region.y0 + align_y - 1) / align_y * align_y + align_y;
+    const int y_hi = region.y1 / align_y * align_y - align_y;
+    const bool can_x = width >= 2;
+    const bool can_y = y_lo <= y_hi;
+    if (levels == 0 || region.cells.empty() || (!can_x && !can_y)) {
+        out.push_back(region);
+        return;
+    }
+
+    // Cut the longer side where half of the cell area lies on each side
+    const bool along_x = can_x && (!can_y || width >= height);
+    std::vector<int> sorted = region.cells;
+    std::stable_sort(sorted.begin(), sorted.end(), [&](int a, int b) {
+        return center(pl, a, along_x) < center(pl, b, along_x);
+    });
+    long long total = 0;
+    for (int idx : sorted) total += static_cast<long long>(pl.cells[idx].w) * pl.cells[idx].h;
+    long long acc = 0;
+    int cut = 0;
+    for (int idx : sorted) {
+        acc += static_cast<long long>(pl.cells[idx].w) * pl.cells[idx].h;
+        if (2 * acc >= total) {
+            cut = center(pl, idx, along_x);
+            break;
+        }
+    }
+    if (along_x) {
+        cut = std::max(region.x0 + 1, std::min(cut, region.x1 - 1));
+    } else {
+        cut = (cut + align_y / 2) / align_y * align_y;
+        cut = std::max(y_lo, std::min(cut, y_hi));
+    }
+
+    LegalRegion low = region, high = region;
+    low.cells.clear();
+    high.cells.clear();
+    if (along_x) {
+        low.x1 = cut;
+        high.x0 = cut;
+    } else {
+        low.y1 = cut;
+        high.y0 = cut;
+    }
+    for (int idx : region.cells) {
+        (center(pl, idx, along_x) < cut ? low : high).cells.push_back(idx);
+    }
+    bisect(pl, low, levels - 1, align_y, out);
+    bisect(pl, high, levels - 1, align_y, out);
+}
+
+}  // namespace
+
+std::vector<LegalRegion> ParallelLegalizer::splitRegions(const Placement& pl, const std::vector<int>& cells,
+                                                         int num_regions, int align_y) {
+    int levels = 0;
+    while ((1 << (levels + 1)) <= num_regions) levels++;
+
+    LegalRegion whole;
+    whole.x0 = 0;
+    whole.y0 = 0;
+    whole.x1 = pl.grid.W;
+    whole.y1 = pl.grid.H;
+    whole.cells = cells;
+
+    std::vector<LegalRegion> regions;
+    bisect(pl, whole, levels, std::max(1, align_y), regions);
+    return regions;
+}
+
+void ParallelLegalizer::legalize(Placement& pl, const ParallelLegalOptions& options) {
+    const bool abacus = options.algorithm == "abacus";
+    std::cout << "Legalizing placement (" << (abacus ? "Abacus" : "greedy")
+              << ", region-parallel)..." << std::endl;
+
+    const std::vector<Cell> before = pl.cells;
+    int movable = 0;
+    for (const auto& cell : pl.cells) {
+        if (!cell.fixed) movable++;
+    }
+
+    // Greedy keeps legal cells in place; Abacus re-packs every movable cell
+    std::vector<int> cells;
+    int row_h = 1;
+    if (abacus) {
+        row_h = AbacusLegalizer::rowHeight(pl);
+        if (row_h <= 0) {
+            std::cout << "No movable cells to legalize" << std::endl;
+            return;
+        }
+        for (size_t i = 0; i < pl.cells.size(); ++i) {
+            if (!pl.cells[i].fixed) cells.push_back(static_cast<int>(i));
+        }
+    } else {
+        cells = Legalizer::illegalCells(pl);
+    }
+
+    int num_regions = options.num_regions > 0
+        ? options.num_regions : std::max(1, std::min(kMaxAutoRegions, movable / kCellsPerRegion));
+    std::vector<LegalRegion> regions = splitRegions(pl, cells, floorPow2(num_regions), row_h);
+    const int count = static_cast<int>(regions.size());
+
+    int num_threads = options.num_threads > 0 ? options.num_threads : ThreadPool::defaultThreads();
+    ThreadPool pool(std::min(num_threads, count));
+
+    // As in the serial greedy pass, cells not yet legalized keep their
+    // squares until their turn; each region only lifts its own cells
+    if (!abacus) {
+        pl.updateGrid();
+    }
+
+    std::vector<std::vector<int>> region_failed(count);
+    pool.parallelFor(count, [&](int i) {
+        ProfileScope scope("legalize_region");
+        const LegalRegion& r = regions[i];
+        if (abacus) {
+            AbacusLegalizer::placeInRegion(pl, r.cells, row_h, r.x0, r.y0, r.x1, r.y1, region_failed[i]);
+        } else {
+            // Past half the shorter side most of the search square lies
+            // outside the region; cells needing more go to cleanup
+            int radius = std::max(1, std::min(r.x1 - r.x0, r.y1 - r.y0) / 2);
+            Legalizer::legalizeInRegion(pl, r.cells, r.x0, r.y0, r.x1, r.y1, region_failed[i], radius);
+        }
+    });
+
+    // Deterministic merge: leftovers in region order
+    std::vector<int> first_failed;
+    for (const auto& f : region_failed) {
+        first_failed.insert(first_failed.end(), f.begin(), f.end());
+    }
+
+    // Second round: neighbouring regions that tile a rectangle are merged
+    // in pairs and their leftovers searched without a radius cap, so only
+    // cells that fit neither region reach the serial cleanup. Groups are
+    // disjoint, and the grid is rebuilt first so every cell, leftover or
+    // not, covers exactly its current squares.
+    std::vector<LegalRegion> groups;
+    for (int i = 0; i < count;) {
+        LegalRegion group = regions[i];
+        group.cells = region_failed[i++];
+        if (i < count) {
+            const LegalRegion& b = regions[i];
+            const bool side = group.y0 == b.y0 && group.y1 == b.y1 && group.x1 == b.x0;
+            const bool stacked = group.x0 == b.x0 && group.x1 == b.x1 && group.y1 == b.y0;
+            if (side || stacked) {
+                group.x1 = b.x1;
+                group.y1 = b.y1;
+                group.cells.insert(group.cells.end(), region_failed[i].begin(),
+                                   region_failed[i].end());
+                i++;
+            }
+        }
+        if (!group.cells.empty()) groups.push_back(group);
+    }
+
+    std::vector<std::vector<int>> group_failed(groups.size());
+    if (!groups.empty()) {
+        pl.updateGrid();
+        pool.parallelFor(static_cast<int>(groups.size()), [&](int i) {
+            ProfileScope scope("legalize_region_pair");
+            const LegalRegion& g = groups[i];
+            Legalizer::legalizeInRegion(pl, g.cells, g.x0, g.y0, g.x1, g.y1, group_failed[i]);
+        });
+    }
+    std::vector<int> failed;
+    for (const auto& f : group_failed) {
+        failed.insert(failed.end(), f.begin(), f.end());
+    }
+
+    // Serial cleanup on the whole grid, from which the leftovers and any
+    // squares they left painted in other regions are cleared first
+    Legalizer::paintGridExcept(pl, failed);
+    int cleaned = Legalizer::placeRemaining(pl, failed);
+
+    const int paired = static_cast<int>(first_failed.size() - failed.size());
+    std::cout << "Legalized " << cells.size() - failed.size() + cleaned << " cells in "
+              << count << " regions on " << pool.size() << " threads ("
+              << first_failed.size() << " leftovers, "
+              << (cells.empty() ? 0.0 : 100.0 * first_failed.size() / cells.size())
+              << "% of the cells; " << paired << " placed in merged regions, "
+              << cleaned << " of " << failed.size() << " by cleanup";
+    if (!abacus) {
+        std::cout << "; " << movable - static_cast<int>(cells.size()) << " already legal";
+    }
+    std::cout << ")" << std::endl;
+    Legalizer::reportDisplacement(before, pl);
+}
@@ -0,0 +1,43 @@
+#ifndef PARALLEL_LEGALIZE_H
+#define PARALLEL_LEGALIZE_H
+
+#include "../model/placement.h"
+#include <string>
+#include <vector>
+
+// Region-parallel legalization.
+// The die is split by recursive bisection into regions holding equal
+// movable cell area, each cell going to the region containing its center.
+// Every region is legalized on its own thread inside its own rectangle,
+// with the greedy or the Abacus legalizer. Cells that do not fit their
+// region, or that the greedy search does not place within half the
+// region's shorter side, get a second parallel round in which neighbouring
+// regions are merged in pairs and searched without a radius cap; what is
+// left after that is placed by a serial cleanup pass (nearest free spot
+// on the whole grid). Regions only touch their own
+// cells and grid squares and are merged in region order, so the result is
+// the same for any thread count.
+
+struct ParallelLegalOptions {
+    std::string algorithm = "greedy";  // greedy | abacus
+    int num_regions = 0;               // Rounded down to a power of two; 0 = from cell count
+    int num_threads = 0;               // 0 = hardware concurrency
+};
+
+struct LegalRegion {
+    int x0, y0, x1, y1;
+    std::vector<int> cells;  // Dense indices of the cells to legalize
+};
+
+class ParallelLegalizer {
+public:
+    static void legalize(Placement& pl, const ParallelLegalOptions& options);
+
+    // Split [0, W) x [0, H) into `num_regions` (a power of two) rectangles
+    // of roughly equal area of `cells`; horizontal cuts are multiples of
+    // align_y
+    static std::vector<LegalRegion> splitRegions(const Placement& pl, const std::vector<int>& cells,
+                                                 int num_regions, int align_y);
+};
+
+#endif // PARALLEL_LEGALIZE_H
@@ -1,23 +1,259 @@
-#include "io/reader.h"
+#include "io/parallel_reader.h"
+#include "io/snapshot.h"
+#include "io/bookshelf_reader.h"
 #include "opt/anneal.h"
+#include "opt/checkpoint.h"
+#include "opt/multistart.h"
+#include "opt/tempering.h"
+#include "opt/partition_anneal.h"
+#include "opt/multilevel.h"
+#include "global/quadratic_place.h"
+#include "global/electrostatic_place.h"
 #include "legal/legalize.h"
+#include "legal/abacus.h"
+#include "legal/parallel_legalize.h"
 #include "detail/detail_place.h"
 #include "viz/write_json.h"
 #include "cost/cost.h"
+#include "util/profiler.h"
+#include <chrono>
+#include <cstdlib>
 #include <iostream>
+#include <sstream>
 #include <string>
+#include <vector>
 
-int main(int argc, char* argv[]) {
+// Starting temperature when annealing refines a global placement
+static const double kGlobalInitT0 = 10.0;
+
+// Adaptive schedule from a global placement: accept few uphill moves and
+// keep them short, so the placement is refined rather than scrambled
+static const double kGlobalInitAcceptance = 0.2;
+static const int kGlobalInitWindow = 8;
+
+// Safety limit on epochs; the adaptive schedule stops by temperature
+static const int kAdaptiveMaxEpochs = 1000;
+
+// Command line options: two positional files plus --name=value flags
+struct Options {
     std::string input_file = "input.txt";
     std::string output_file = "placement.json";
-    
-    // Parse command line arguments
-    if (argc > 1) {
-        input_file = argv[1];
+    std::string anneal = "sa";      // sa | multistart | tempering | partition | multilevel
+    std::string global = "none";    // none | init | only
+    std::string global_engine = "quadratic";  // quadratic | electrostatic
+    std::string schedule = "adaptive";  // adaptive | fixed (--anneal=sa)
+    double effort = 0.2;            // Adaptive moves per epoch = effort * N^(4/3)
+    bool has_schedule = false;      // --schedule or --effort given
+    bool has_seed = false;
+    unsigned seed = 1;
+    std::vector<unsigned> seeds;    // Explicit multi-start seed list
+    int chains = 4;
+    int replicas = 8;
+    int regions = 0;                // 0 = automatic
+    int threads = 0;                // 0 = hardware concurrency
+    int restart_interval = 0;
+    std::string legalizer = "greedy";  // greedy | abacus
+    bool parallel_legal = false;
+    int legal_regions = 0;          // 0 = automatic
+    std::string convert_file;       // Write the input as a snapshot and stop
+    std::string snapshot_file;      // Snapshot of the final placement
+    int grid_unit = 0;              // Bookshelf coordinate unit; 0 = automatic
+    std::string json = "pretty";    // pretty | compact
+    bool json_nets = true;
+    std::string sidecar_file;       // Binary cell/net arrays for viz/plot.py
+    std::string checkpoint_file;    // Annealing checkpoints
+    int checkpoint_epochs = 0;      // 0 = by time only
+    double checkpoint_seconds = 60.0;
+    std::string resume_file;        // Continue annealing from this checkpoint
+    bool profile = false;           // Print the stage profile at the end
+    std::string trace_file;         // Chrome trace of the run
+};
+
+static void printUsage(const char* prog) {
+    std::cout << "Usage: " << prog << " [options] [input.txt] [output.json]\n"
+              << "  --anneal=sa|multistart|tempering|partition|multilevel\n"
+              << "                           Annealing mode (default sa)\n"
+              << "  --global=none|init|only  Global placement: none, as the initial\n"
+              << "                           placement for annealing, or instead of it\n"
+              << "  --global-engine=quadratic|electrostatic\n"
+              << "                           Global placer (default quadratic)\n"
+              << "  --schedule=adaptive|fixed\n"
+              << "                           Annealing schedule for --anneal=sa (default adaptive)\n"
+              << "  --effort=X               Adaptive moves per epoch, X * cells^(4/3) (default 0.2;\n"
+              << "                           --anneal=sa only)\n"
+              << "  --seed=N                 RNG seed (base seed for multi-start)\n"
+              << "  --seeds=a,b,...          Explicit multi-start seed list\n"
+              << "  --chains=N               Multi-start chains (default 4)\n"
+              << "  --replicas=N             Parallel tempering replicas (default 8)\n"
+              << "  --regions=N              Partitioned annealing stripes (default: auto)\n"
+              << "  --threads=N              Worker threads (default: all cores)\n"
+              << "  --restart-interval=E     Restart weak chains every E epochs\n"
+              << "  --legalizer=greedy|abacus\n"
+              << "                           Legalization algorithm (default greedy)\n"
+              << "  --parallel-legal         Legalize regions of the die in parallel\n"
+              << "  --legal-regions=N        Regions for parallel legalization (default: auto)\n"
+              << "  --grid-unit=N            Bookshelf sites per grid square (default: auto)\n"
+              << "  --json=pretty|compact    JSON layout (default pretty)\n"
+              << "  --no-nets                Leave the nets out of the output files\n"
+              << "  --sidecar=FILE           Also write a binary file for viz/plot.py\n"
+              << "  --checkpoint=FILE        Save annealing checkpoints to FILE\n"
+              << "  --checkpoint-epochs=N    Checkpoint every N epochs (default: by time only)\n"
+              << "  --checkpoint-seconds=S   Checkpoint every S seconds (default 60)\n"
+              << "  --resume=FILE            Continue annealing from a checkpoint\n"
+              << "  --convert=FILE           Write the input as a binary snapshot and exit\n"
+              << "  --write-snapshot=FILE    Write the final placement as a binary snapshot\n"
+              << "  --profile                Print time per stage and event counters\n"
+              << "  --trace=FILE             Write a Chrome trace of the run (implies --profile)\n";
+}
+
+static bool parseArgs(int argc, char* argv[], Options& opt) {
+    int positional = 0;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg.compare(0, 2, "--") != 0) {
+            if (positional == 0) opt.input_file = arg;
+            else if (positional == 1) opt.output_file = arg;
+            positional++;
+            continue;
+        }
+        
+        std::string name = arg.substr(2);
+        std::string value;
+        size_t eq = name.find('=');
+        if (eq != std::string::npos) {
+            value = name.substr(eq + 1);
+            name = name.substr(0, eq);
+        }
+        
+        if (name == "help") {
+            printUsage(argv[0]);
+            std::exit(0);
+        } else if (name == "anneal") {
+            opt.anneal = value;
+        } else if (name == "global") {
+            opt.global = value;
+        } else if (name == "global-engine") {
+            opt.global_engine = value;
+        } else if (name == "schedule") {
+            opt.has_schedule = true;
+            opt.schedule = value;
+        } else if (name == "effort") {
+            opt.has_schedule = true;
+            opt.effort = std::stod(value);
+        } else if (name == "seed") {
+            opt.has_seed = true;
+            opt.seed = static_cast<unsigned>(std::stoul(value));
+        } else if (name == "seeds") {
+            std::istringstream iss(value);
+            std::string item;
+            while (std::getline(iss, item, ',')) {
+                opt.seeds.push_back(static_cast<unsigned>(std::stoul(item)));
+            }
+        } else if (name == "chains") {
+            opt.chains = std::stoi(value);
+        } else if (name == "replicas") {
+            opt.replicas = std::stoi(value);
+        } else if (name == "regions") {
+            opt.regions = std::stoi(value);
+        } else if (name == "threads") {
+            opt.threads = std::stoi(value);
+        } else if (name == "legalizer") {
+            opt.legalizer = value;
+        } else if (name == "parallel-legal") {
+            opt.parallel_legal = true;
+        } else if (name == "legal-regions") {
+            opt.parallel_legal = true;
+            opt.legal_regions = std::stoi(value);
+        } else if (name == "grid-unit") {
+            opt.grid_unit = std::stoi(value);
+        } else if (name == "json") {
+            opt.json = value;
+        } else if (name == "no-nets") {
+            opt.json_nets = false;
+        } else if (name == "sidecar") {
+            opt.sidecar_file = value;
+        } else if (name == "checkpoint") {
+            opt.checkpoint_file = value;
+        } else if (name == "checkpoint-epochs") {
+            opt.checkpoint_epochs = std::stoi(value);
+        } else if (name == "checkpoint-seconds") {
+            opt.checkpoint_seconds = std::stod(value);
+        } else if (name == "resume") {
+            opt.resume_file = value;
+        } else if (name == "convert") {
+            opt.convert_file = value;
+        } else if (name == "write-snapshot") {
+            opt.snapshot_file = value;
+        } else if (name == "profile") {
+            opt.profile = true;
+        } else if (name == "trace") {
+            opt.profile = true;
+            opt.trace_file = value;
+        } else if (name == "restart-interval") {
+            opt.restart_interval = std::stoi(value);
+        } else {
+            std::cerr << "Error: Unknown option --" << name << std::endl;
+            printUsage(argv[0]);
+            return false;
+        }
+    }
+    if (opt.anneal != "sa" && opt.anneal != "multistart" && opt.anneal != "tempering" &&
+        opt.anneal != "partition" && opt.anneal != "multilevel") {
+        std::cerr << "Error: --anneal must be sa, multistart, tempering, partition or multilevel" << std::endl;
+        return false;
+    }
+    if (opt.global != "none" && opt.global != "init" && opt.global != "only") {
+        std::cerr << "Error: --global must be none, init or only" << std::endl;
+        return false;
     }
-    if (argc > 2) {
-        output_file = argv[2];
+    if (opt.global_engine != "quadratic" && opt.global_engine != "electrostatic") {
+        std::cerr << "Error: --global-engine must be quadratic or electrostatic" << std::endl;
+        return false;
     }
+    if ((!opt.checkpoint_file.empty() || !opt.resume_file.empty()) &&
+        (opt.anneal != "sa" || opt.global == "only")) {
+        std::cerr << "Error: --checkpoint and --resume need --anneal=sa" << std::endl;
+        return false;
+    }
+    // The other modes run their own schedules
+    if (opt.has_schedule && (opt.anneal != "sa" || opt.global == "only")) {
+        std::cerr << "Error: --schedule and --effort need --anneal=sa" << std::endl;
+        return false;
+    }
+    if (opt.legalizer != "greedy" && opt.legalizer != "abacus") {
+        std::cerr << "Error: --legalizer must be greedy or abacus" << std::endl;
+        return false;
+    }
+    if (opt.schedule != "adaptive" && opt.schedule != "fixed") {
+        std::cerr << "Error: --schedule must be adaptive or fixed" << std::endl;
+        return false;
+    }
+    if (opt.effort <= 0) {
+        std::cerr << "Error: --effort must be positive" << std::endl;
+        return false;
+    }
+    if (opt.json != "pretty" && opt.json != "compact") {
+        std::cerr << "Error: --json must be pretty or compact" << std::endl;
+        return false;
+    }
+    if (opt.global == "init" && opt.anneal != "sa") {
+        std::cerr << "Error: --global=init needs --anneal=sa" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    Options opt;
+    try {
+        if (!parseArgs(argc, argv, opt)) return 1;
+    } catch (const std::exception&) {
+        std::cerr << "Error: Invalid option value" << std::endl;
+        return 1;
+    }
+    if (opt.profile) Profiler::enable();
+    const std::string& input_file = opt.input_file;
+    const std::string& output_file = opt.output_file;
     
     std::cout << "Basic Placement Simulator" << std::endl;
     std::cout << "=========================" << std::endl;
@@ -27,7 +263,19 @@ int main(int argc, char* argv[]) {
     
     // Step 1: Read input
     std::cout << "Step 1: Reading input..." << std::endl;
-    Placement pl = InputReader::readFromFile(input_file);
+    auto load_start = std::chrono::steady_clock::now();
+    Placement pl;
+    {
+        ProfileScope scope("read_input");
+        if (BookshelfReader::isAuxFile(input_file)) {
+            pl = BookshelfReader::readFromAux(input_file, opt.grid_unit);
+        } else if (Snapshot::isSnapshot(input_file)) {
+            pl = Snapshot::read(input_file);
+        } else {
+            pl = ParallelReader::readFromFile(input_file, opt.threads);
+        }
+    }
+    std::chrono::duration<double> load_time = std::chrono::steady_clock::now() - load_start;
     
     if (pl.cells.empty()) {
         std::cerr << "Error: No cells loaded. Check input file format." << std::endl;
@@ -37,47 +285,195 @@ int main(int argc, char* argv[]) {
     std::cout << "Loaded " << pl.cells.size() << " cells, " 
               << pl.nets.size() << " nets" << std::endl;
     std::cout << "Grid size: " << pl.grid.W << " x " << pl.grid.H << std::endl;
+    std::cout << "Load time: " << load_time.count() << " s" << std::endl;
     std::cout << std::endl;
     
+    if (!opt.convert_file.empty()) {
+        if (!Snapshot::write(pl, opt.convert_file)) return 1;
+        std::cout << "Snapshot written to " << opt.convert_file << std::endl;
+        return 0;
+    }
+    
+    // A resumed run takes its positions and annealing state from the checkpoint
+    const bool resuming = !opt.resume_file.empty();
+    AnnealCheckpoint resume_state;
+    if (resuming && !Checkpoint::read(opt.resume_file, pl, resume_state)) return 1;
+    if (resuming && resume_state.adaptive != (opt.schedule == "adaptive")) {
+        std::cerr << "Error: " << opt.resume_file << " was written with --schedule="
+                  << (resume_state.adaptive ? "adaptive" : "fixed") << std::endl;
+        return 1;
+    }
+    
     // Step 2: Initial placement (random)
     std::cout << "Step 2: Initial placement..." << std::endl;
-    double initial_cost = CostCalculator::calculateTotalCost(pl);
+    CostBreakdown initial = CostCalculator::calculateCostBreakdown(pl);
+    double initial_cost = initial.total;
     std::cout << "Initial cost: " << initial_cost << std::endl;
-    std::cout << "  HPWL: " << CostCalculator::calculateTotalHPWL(pl) << std::endl;
-    std::cout << "  Overlap: " << CostCalculator::calculateOverlapPenalty(pl) << std::endl;
+    std::cout << "  HPWL: " << initial.hpwl << std::endl;
+    std::cout << "  Overlap: " << initial.overlap << std::endl;
     std::cout << std::endl;
     
-    // Step 3: Simulated annealing optimization
-    std::cout << "Step 3: Simulated annealing optimization..." << std::endl;
-    SimulatedAnnealing sa(1000.0, 0.90, 1.0, 0.1);  // T0=1000, alpha=0.90
-    sa.optimize(pl, 100, 0);  // 100 epochs, auto moves_per_epoch
+    // Step 3: Global placement and/or simulated annealing optimization
+    auto place_start = std::chrono::steady_clock::now();
+    if (resuming) {
+        std::cout << "Step 3: Resuming simulated annealing from " << opt.resume_file << "..." << std::endl;
+    } else if (opt.global != "none") {
+        std::cout << "Step 3: Global placement..." << std::endl;
+        ProfileScope scope("global_place");
+        if (opt.global_engine == "electrostatic") {
+            ElectrostaticOptions ep;
+            ep.seed = opt.seed;
+            ep.num_threads = opt.threads;
+            ElectrostaticPlacer::place(pl, ep);
+        } else {
+            GlobalPlaceOptions gp;
+            gp.num_threads = opt.threads;
+            QuadraticPlacer::place(pl, gp);
+        }
+        if (opt.global == "init") {
+            std::cout << std::endl << "Simulated annealing from the global placement..." << std::endl;
+        }
+    } else {
+        std::cout << "Step 3: Simulated annealing optimization..." << std::endl;
+    }
+    // Schedule and checkpoints of the single-chain annealer
+    const bool adaptive = opt.schedule == "adaptive";
+    const int sa_epochs = adaptive ? kAdaptiveMaxEpochs : 100;
+    auto setupAnnealer = [&](SimulatedAnnealing& sa, bool from_global) {
+        if (adaptive) {
+            AdaptiveOptions ao;
+            ao.effort = opt.effort;
+            if (from_global) {
+                ao.initial_acceptance = kGlobalInitAcceptance;
+                ao.initial_window = kGlobalInitWindow;
+            }
+            sa.setAdaptive(ao);
+        }
+        if (!opt.checkpoint_file.empty()) {
+            sa.setCheckpoint(opt.checkpoint_file, opt.checkpoint_epochs, opt.checkpoint_seconds);
+        }
+        if (resuming) sa.resumeFrom(resume_state);
+    };
+    ProfileScope anneal_scope(opt.global == "only" ? nullptr : "anneal");
+    if (opt.global == "only") {
+        // Annealing is replaced by the global placement
+    } else if (opt.global == "init") {
+        // Cool start: a hot one would scramble the global placement
+        SimulatedAnnealing sa(kGlobalInitT0, 0.90, 1.0, 0.1);
+        if (opt.has_seed) sa.setSeed(opt.seed);
+        sa.setRandomStart(false);
+        setupAnnealer(sa, true);
+        sa.optimize(pl, sa_epochs, 0);
+    } else if (opt.anneal == "multistart") {
+        MultiStartOptions ms;
+        ms.seeds = opt.seeds.empty() ? MultiStartAnnealer::makeSeeds(opt.seed, opt.chains) : opt.seeds;
+        ms.num_threads = opt.threads;
+        ms.max_epochs = 100;
+        ms.restart_interval = opt.restart_interval;
+        MultiStartAnnealer msa(1000.0, 0.90, 1.0, 0.1);
+        msa.optimize(pl, ms);
+    } else if (opt.anneal == "tempering") {
+        TemperingOptions pt;
+        pt.seed = opt.seed;
+        pt.num_replicas = opt.replicas;
+        pt.num_threads = opt.threads;
+        pt.rounds = 100;
+        ParallelTempering tempering(1000.0, 0.90, 1.0, 0.1);
+        tempering.optimize(pl, pt);
+    } else if (opt.anneal == "partition") {
+        PartitionOptions po;
+        po.seed = opt.seed;
+        po.num_regions = opt.regions;
+        po.num_threads = opt.threads;
+        po.max_epochs = 100;
+        PartitionedAnnealer pa(1000.0, 0.90, 1.0, 0.1);
+        pa.optimize(pl, po);
+    } else if (opt.anneal == "multilevel") {
+        MultilevelOptions mo;
+        mo.seed = opt.seed;
+        mo.num_threads = opt.threads;
+        MultilevelAnnealer ml(1000.0, 0.90, 1.0, 0.1);
+        ml.optimize(pl, mo);
+    } else {
+        SimulatedAnnealing sa(1000.0, 0.90, 1.0, 0.1);  // T0=1000, alpha=0.90
+        if (opt.has_seed) sa.setSeed(opt.seed);
+        setupAnnealer(sa, false);
+        sa.optimize(pl, sa_epochs, 0);  // Auto moves_per_epoch
+    }
+    anneal_scope.stop();
+    std::chrono::duration<double> place_time = std::chrono::steady_clock::now() - place_start;
+    std::cout << "Placement time: " << place_time.count() << " s" << std::endl;
     std::cout << std::endl;
     
     // Step 4: Legalization
     std::cout << "Step 4: Legalization..." << std::endl;
-    Legalizer::legalize(pl);
+    auto legal_start = std::chrono::steady_clock::now();
+    ProfileScope legal_scope("legalize");
+    if (opt.parallel_legal) {
+        ParallelLegalOptions lo;
+        lo.algorithm = opt.legalizer;
+        lo.num_regions = opt.legal_regions;
+        lo.num_threads = opt.threads;
+        ParallelLegalizer::legalize(pl, lo);
+    } else if (opt.legalizer == "abacus") {
+        AbacusLegalizer::legalize(pl);
+    } else {
+        Legalizer::legalize(pl);
+    }
+    legal_scope.stop();
+    std::chrono::duration<double> legal_time = std::chrono::steady_clock::now() - legal_start;
+    std::cout << "Legalization time: " << legal_time.count() << " s" << std::endl;
     double after_legal_cost = CostCalculator::calculateTotalCost(pl);
     std::cout << "Cost after legalization: " << after_legal_cost << std::endl;
     std::cout << std::endl;
     
     // Step 5: Detailed placement
     std::cout << "Step 5: Detailed placement..." << std::endl;
-    DetailedPlacer::detailedPlace(pl, 5, 10);
+    {
+        ProfileScope scope("detailed_place");
+        DetailedPlacer dp;
+        if (opt.has_seed) dp.setSeed(opt.seed);
+        dp.setThreads(opt.threads);
+        dp.detailedPlace(pl, 5, 10);
+    }
     std::cout << std::endl;
     
     // Step 6: Final results
     std::cout << "Step 6: Final results..." << std::endl;
-    double final_cost = CostCalculator::calculateTotalCost(pl);
+    CostBreakdown final_terms = CostCalculator::calculateCostBreakdown(pl);
+    double final_cost = final_terms.total;
     std::cout << "Final cost: " << final_cost << std::endl;
-    std::cout << "  HPWL: " << CostCalculator::calculateTotalHPWL(pl) << std::endl;
-    std::cout << "  Overlap: " << CostCalculator::calculateOverlapPenalty(pl) << std::endl;
+    std::cout << "  HPWL: " << final_terms.hpwl << std::endl;
+    std::cout << "  Overlap: " << final_terms.overlap << std::endl;
     std::cout << "  Improvement: " << ((initial_cost - final_cost) / initial_cost * 100.0) 
               << "%" << std::endl;
     std::cout << std::endl;
     
     // Step 7: Write output
     std::cout << "Step 7: Writing output..." << std::endl;
-    JsonWriter::writePlacement(pl, output_file);
+    ProfileScope output_scope("write_output");
+    JsonOptions json_options;
+    json_options.compact = opt.json == "compact";
+    json_options.include_nets = opt.json_nets;
+    JsonWriter::writePlacement(pl, output_file, json_options);
+    if (!opt.sidecar_file.empty()) {
+        if (!JsonWriter::writeSidecar(pl, opt.sidecar_file, opt.json_nets)) return 1;
+        std::cout << "Sidecar written to " << opt.sidecar_file << std::endl;
+    }
+    if (!opt.snapshot_file.empty()) {
+        if (!Snapshot::write(pl, opt.snapshot_file)) return 1;
+        std::cout << "Snapshot written to " << opt.snapshot_file << std::endl;
+    }
+    output_scope.stop();
+    
+    if (opt.profile) {
+        std::cout << std::endl;
+        Profiler::writeSummary(std::cout);
+    }
+    if (!opt.trace_file.empty()) {
+        if (!Profiler::writeTrace(opt.trace_file)) return 1;
+        std::cout << "Trace written to " << opt.trace_file << std::endl;
+    }
     
     std::cout << std::endl;
     std::cout << "Placement complete!" << std::endl;
@@ -0,0 +1,54 @@
+#ifndef CELL_STORE_H
+#define CELL_STORE_H
+
+#include "placement.h"
+#include <cstdint>
+#include <vector>
+
+// Structure-of-arrays copy of the cell geometry.
+// `Placement::cells` stays the editable array-of-structs model; streaming
+// kernels (see CostKernels) read this contiguous per-field layout instead.
+// Indices match Placement::cells.
+
+struct CellStore {
+    std::vector<int32_t> x, y, w, h;
+    std::vector<uint64_t> fixed_bits;  // Bit i set if cell i is fixed
+
+    int size() const { return static_cast<int>(x.size()); }
+
+    bool isFixed(int i) const {
+        return (fixed_bits[i >> 6] >> (i & 63)) & 1u;
+    }
+
+    // Copy all cell fields
+    void assign(const std::vector<Cell>& cells) {
+        const size_t n = cells.size();
+        x.resize(n);
+        y.resize(n);
+        w.resize(n);
+        h.resize(n);
+        fixed_bits.assign((n + 63) / 64, 0);
+        for (size_t i = 0; i < n; ++i) {
+            const Cell& c = cells[i];
+            x[i] = c.x;
+            y[i] = c.y;
+            w[i] = c.w;
+            h[i] = c.h;
+            if (c.fixed) fixed_bits[i >> 6] |= uint64_t(1) << (i & 63);
+        }
+    }
+
+    // Refresh positions only (sizes and fixed flags do not change)
+    void syncPositions(const std::vector<Cell>& cells) {
+        if (cells.size() != x.size()) {
+            assign(cells);
+            return;
+        }
+        for (size_t i = 0; i < cells.size(); ++i) {
+            x[i] = cells[i].x;
+            y[i] = cells[i].y;
+        }
+    }
+};
+
+#endif // CELL_STORE_H
@@ -0,0 +1,93 @@
+#include "netlist.h"
+#include "placement.h"
+#include <algorithm>
+
+void Netlist::build(const std::vector<Cell>& cells, const std::vector<Net>& nets,
+                    const std::unordered_map<int, int>& id_to_index) {
+    const int num_cells = static_cast<int>(cells.size());
+    const int num_nets = static_cast<int>(nets.size());
+
+    // net -> pins
+    size_t num_pins = 0;
+    for (const auto& net : nets) num_pins += net.pins.size();
+
+    net_pin_start.assign(1, 0);
+    net_pin_start.reserve(num_nets + 1);
+    pin_cell.clear();
+    pin_dx.clear();
+    pin_dy.clear();
+    pin_net.clear();
+    pin_cell.reserve(num_pins);
+    pin_dx.reserve(num_pins);
+    pin_dy.reserve(num_pins);
+    pin_net.reserve(num_pins);
+
+    for (int n = 0; n < num_nets; ++n) {
+        for (const auto& pin : nets[n].pins) {
+            auto it = id_to_index.find(pin.cell_id);
+            pin_cell.push_back(it == id_to_index.end() ? -1 : it->second);
+            pin_dx.push_back(pin.offset_x);
+            pin_dy.push_back(pin.offset_y);
+            pin_net.push_back(n);
+        }
+        net_pin_start.push_back(static_cast<int>(pin_cell.size()));
+    }
+
+    buildAdjacency(num_cells);
+}
+
+void Netlist::buildAdjacency(int num_cells) {
+    // cell -> pins, counting sort on pin_cell
+    cell_pin_start.assign(num_cells + 1, 0);
+    for (int c : pin_cell) {
+        if (c >= 0) cell_pin_start[c + 1]++;
+    }
+    for (int c = 0; c < num_cells; ++c) {
+        cell_pin_start[c + 1] += cell_pin_start[c];
+    }
+    cell_pins.assign(cell_pin_start[num_cells], 0);
+    std::vector<int> fill(cell_pin_start.begin(), cell_pin_start.end() - 1);
+    for (int p = 0; p < static_cast<int>(pin_cell.size()); ++p) {
+        int c = pin_cell[p];
+        if (c >= 0) cell_pins[fill[c]++] = p;
+    }
+
+    // cell -> distinct nets; pins of a cell are already in net order
+    cell_net_start.assign(num_cells + 1, 0);
+    cell_nets.clear();
+    cell_nets.reserve(cell_pins.size());
+    for (int c = 0; c < num_cells; ++c) {
+        int last = -1;
+        for (int k = cell_pin_start[c]; k < cell_pin_start[c + 1]; ++k) {
+            int n = pin_net[cell_pins[k]];
+            if (n != last) {
+                cell_nets.push_back(n);
+                last = n;
+            }
+        }
+        cell_net_start[c + 1] = static_cast<int>(cell_nets.size());
+    }
+
+    groupByDegree();
+}
+
+void Netlist::groupByDegree() {
+    // degree -> nets, counting sort on pin count
+    const int num_nets = numNets();
+    int max_degree = 0;
+    for (int n = 0; n < num_nets; ++n) {
+        max_degree = std::max(max_degree, net_pin_start[n + 1] - net_pin_start[n]);
+    }
+    degree_start.assign(max_degree + 2, 0);
+    for (int n = 0; n < num_nets; ++n) {
+        degree_start[net_pin_start[n + 1] - net_pin_start[n] + 1]++;
+    }
+    for (int d = 0; d <= max_degree; ++d) {
+        degree_start[d + 1] += degree_start[d];
+    }
+    net_by_degree.assign(num_nets, 0);
+    std::vector<int> next(degree_start.begin(), degree_start.end() - 1);
+    for (int n = 0; n < num_nets; ++n) {
+        net_by_degree[next[net_pin_start[n + 1] - net_pin_start[n]]++] = n;
+    }
+}
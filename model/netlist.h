@@ -0,0 +1,53 @@
+#ifndef NETLIST_H
+#define NETLIST_H
+
+#include <unordered_map>
+#include <vector>
+
+struct Cell;
+struct Net;
+
+// Compressed sparse row (CSR) netlist over dense cell indices.
+// Built once at load time so every stage can walk pins without looking
+// cells up by id. Pins of net n are [net_pin_start[n], net_pin_start[n+1]).
+
+struct Netlist {
+    // net -> pins
+    std::vector<int> net_pin_start;
+    std::vector<int> pin_cell;   // Dense cell index (-1 if the id is unknown)
+    std::vector<int> pin_dx;     // Offset from cell's bottom-left corner
+    std::vector<int> pin_dy;
+    std::vector<int> pin_net;
+
+    // cell -> pins (indices into the pin arrays)
+    std::vector<int> cell_pin_start;
+    std::vector<int> cell_pins;
+
+    // cell -> distinct nets
+    std::vector<int> cell_net_start;
+    std::vector<int> cell_nets;
+
+    // Nets grouped by pin count: nets with d pins are
+    // [degree_start[d], degree_start[d+1]) in net_by_degree, in net order
+    std::vector<int> degree_start;
+    std::vector<int> net_by_degree;
+
+    int numNets() const { return net_pin_start.empty() ? 0 : static_cast<int>(net_pin_start.size()) - 1; }
+    int numCells() const { return cell_pin_start.empty() ? 0 : static_cast<int>(cell_pin_start.size()) - 1; }
+    int numPins() const { return static_cast<int>(pin_cell.size()); }
+
+    // Build from the model's cells/nets and the id -> index map
+    void build(const std::vector<Cell>& cells, const std::vector<Net>& nets,
+               const std::unordered_map<int, int>& id_to_index);
+
+    // Fill the cell -> pins and cell -> nets arrays and the degree groups
+    // from the net -> pin arrays (build does this; for netlists whose pin
+    // arrays are assembled directly)
+    void buildAdjacency(int num_cells);
+
+    // Fill degree_start and net_by_degree from net_pin_start (build does
+    // this; for netlists whose CSR arrays are loaded directly)
+    void groupByDegree();
+};
+
+#endif // NETLIST_H
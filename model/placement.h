@@ -1,8 +1,12 @@
 #ifndef PLACEMENT_H
 #define PLACEMENT_H
 
+#include "netlist.h"
+#include "../util/profiler.h"
+#include <algorithm>
 #include <vector>
 #include <string>
+#include <unordered_map>
 
 // Core data structures for the placement simulator
 
@@ -34,33 +38,80 @@ struct Net {
     Net(int id) : id(id) {}
 };
 
+// Occupancy grid. Each square counts the cells covering it and keeps the
+// (wrapping) sum of their ids, so a square covered by one cell knows which
+// one. paint and erase are exact inverses: moving a cell with
+// removeCell/insertCell leaves the grid as updateGrid would build it, also
+// where cells overlap. Erase only footprints that were painted.
 struct Grid {
     int W, H;  // Width and height of the grid
-    std::vector<std::vector<int>> occ;  // Occupation map (cell_id or -1 for empty)
+    std::vector<int> cover;        // Row-major: cells covering square y * W + x
+    std::vector<unsigned> id_sum;  // Row-major: sum of the ids of those cells
+    
+    // cellAt result for a square covered by more than one cell
+    static constexpr int kShared = -2;
     
     Grid() : W(0), H(0) {}
     Grid(int W, int H) : W(W), H(H) {
-        occ.resize(H, std::vector<int>(W, -1));
+        cover.assign(static_cast<size_t>(W) * H, 0);
+        id_sum.assign(static_cast<size_t>(W) * H, 0);
+    }
+    
+    // False for grids created without an occupancy map (see
+    // Placement::copyWithoutOccupancy)
+    bool hasOccupancy() const {
+        return !cover.empty();
     }
     
     bool isValid(int x, int y) const {
         return x >= 0 && x < W && y >= 0 && y < H;
     }
     
+    // Id of the cell covering (x, y), -1 if empty or outside the grid, or
+    // kShared if several cells cover it
+    int cellAt(int x, int y) const {
+        if (!isValid(x, y)) return -1;
+        size_t i = static_cast<size_t>(y) * W + x;
+        if (cover[i] == 0) return -1;
+        return cover[i] == 1 ? static_cast<int>(id_sum[i]) : kShared;
+    }
+    
     bool isOccupied(int x, int y) const {
         if (!isValid(x, y)) return true;
-        return occ[y][x] != -1;
+        return cover[static_cast<size_t>(y) * W + x] != 0;
+    }
+    
+    // Empty every square
+    void clear() {
+        std::fill(cover.begin(), cover.end(), 0);
+        std::fill(id_sum.begin(), id_sum.end(), 0u);
     }
     
-    void setOccupied(int x, int y, int cell_id) {
-        if (isValid(x, y)) {
-            occ[y][x] = cell_id;
+    // Add a cell's footprint (clipped to the grid)
+    void paint(const Cell& cell) {
+        int x0 = std::max(cell.x, 0), x1 = std::min(cell.x + cell.w, W);
+        int y0 = std::max(cell.y, 0), y1 = std::min(cell.y + cell.h, H);
+        const unsigned id = static_cast<unsigned>(cell.id);
+        for (int y = y0; y < y1; ++y) {
+            size_t row = static_cast<size_t>(y) * W;
+            for (int x = x0; x < x1; ++x) {
+                ++cover[row + x];
+                id_sum[row + x] += id;
+            }
         }
     }
     
-    void clearOccupied(int x, int y) {
-        if (isValid(x, y)) {
-            occ[y][x] = -1;
+    // Remove a cell's footprint; the cell must have been painted there
+    void erase(const Cell& cell) {
+        int x0 = std::max(cell.x, 0), x1 = std::min(cell.x + cell.w, W);
+        int y0 = std::max(cell.y, 0), y1 = std::min(cell.y + cell.h, H);
+        const unsigned id = static_cast<unsigned>(cell.id);
+        for (int y = y0; y < y1; ++y) {
+            size_t row = static_cast<size_t>(y) * W;
+            for (int x = x0; x < x1; ++x) {
+                --cover[row + x];
+                id_sum[row + x] -= id;
+            }
         }
     }
 };
@@ -70,42 +121,81 @@ struct Placement {
     std::vector<Net> nets;
     Grid grid;
     
+    // Dense index: external cell id -> position in `cells`, plus the CSR
+    // netlist over those indices. Rebuild with buildIndex() whenever cells
+    // or nets are added or removed.
+    std::unordered_map<int, int> id_to_index;
+    Netlist netlist;
+    
+    void buildIndex() {
+        id_to_index.clear();
+        id_to_index.reserve(cells.size());
+        for (size_t i = 0; i < cells.size(); ++i) {
+            id_to_index.emplace(cells[i].id, static_cast<int>(i));
+        }
+        netlist.build(cells, nets, id_to_index);
+    }
+    
+    bool hasIndex() const {
+        return netlist.numCells() == static_cast<int>(cells.size()) &&
+               netlist.numNets() == static_cast<int>(nets.size());
+    }
+    
+    // Dense index of a cell id, or -1 if unknown
+    int cellIndex(int id) const {
+        if (hasIndex()) {
+            auto it = id_to_index.find(id);
+            return it == id_to_index.end() ? -1 : it->second;
+        }
+        for (size_t i = 0; i < cells.size(); ++i) {
+            if (cells[i].id == id) return static_cast<int>(i);
+        }
+        return -1;
+    }
+    
     // Find cell by ID
     Cell* findCell(int id) {
-        for (auto& cell : cells) {
-            if (cell.id == id) return &cell;
-        }
-        return nullptr;
+        int idx = cellIndex(id);
+        return idx < 0 ? nullptr : &cells[idx];
     }
     
     const Cell* findCell(int id) const {
-        for (const auto& cell : cells) {
-            if (cell.id == id) return &cell;
-        }
-        return nullptr;
+        int idx = cellIndex(id);
+        return idx < 0 ? nullptr : &cells[idx];
+    }
+    
+    // Copy of cells, nets and index with a grid of the same size but no
+    // occupancy map; for optimizers that only work on cell positions
+    Placement copyWithoutOccupancy() const {
+        Placement copy;
+        copy.cells = cells;
+        copy.nets = nets;
+        copy.grid.W = grid.W;
+        copy.grid.H = grid.H;
+        copy.id_to_index = id_to_index;
+        copy.netlist = netlist;
+        return copy;
     }
     
-    // Update grid occupation based on current cell positions
+    // Footprint updates for one cell (by index) at its current position.
+    // Move a cell by removing it, changing its position and inserting it
+    // again.
+    void removeCell(int idx) {
+        if (grid.hasOccupancy()) grid.erase(cells[idx]);
+    }
+    
+    void insertCell(int idx) {
+        if (grid.hasOccupancy()) grid.paint(cells[idx]);
+    }
+    
+    // Rebuild grid occupation from all cell positions; for stages that
+    // move many cells at once without maintaining the grid
     void updateGrid() {
-        // Clear grid
-        for (int y = 0; y < grid.H; ++y) {
-            for (int x = 0; x < grid.W; ++x) {
-                grid.occ[y][x] = -1;
-            }
-        }
+        if (!grid.hasOccupancy()) return;
+        Profiler::count(Profiler::GRID_UPDATES);
         
-        // Place cells
-        for (const auto& cell : cells) {
-            for (int dy = 0; dy < cell.h; ++dy) {
-                for (int dx = 0; dx < cell.w; ++dx) {
-                    int gx = cell.x + dx;
-                    int gy = cell.y + dy;
-                    if (grid.isValid(gx, gy)) {
-                        grid.setOccupied(gx, gy, cell.id);
-                    }
-                }
-            }
-        }
+        grid.clear();
+        for (const auto& cell : cells) grid.paint(cell);
     }
 };
 
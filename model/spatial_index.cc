@@ -0,0 +1,60 @@
+#include "spatial_index.h"
+#include <cmath>
+
+void SpatialIndex::build(const Placement& pl, int bin_size) {
+    if (bin_size <= 0) {
+        // About two average cells per bin side keeps bins short but still
+        // lets most cells live in a single bin
+        double sum = 0.0;
+        for (const auto& cell : pl.cells) {
+            sum += std::max(cell.w, cell.h);
+        }
+        double avg = pl.cells.empty() ? 1.0 : sum / pl.cells.size();
+        bin_size = std::max(1, static_cast<int>(std::ceil(2.0 * avg)));
+    }
+
+    bin_size_ = bin_size;
+    nbx_ = pl.grid.W > 0 ? (pl.grid.W + bin_size_ - 1) / bin_size_ : 0;
+    nby_ = pl.grid.H > 0 ? (pl.grid.H + bin_size_ - 1) / bin_size_ : 0;
+    if (nbx_ == 0 || nby_ == 0) {
+        nbx_ = nby_ = 0;
+    }
+
+    bins_.assign(static_cast<size_t>(nbx_) * nby_, std::vector<int>());
+    rects_.assign(pl.cells.size(), Rect{0, 0, 0, 0});
+    for (size_t i = 0; i < pl.cells.size(); ++i) {
+        const Cell& c = pl.cells[i];
+        insert(static_cast<int>(i), c.x, c.y, c.w, c.h);
+    }
+}
+
+void SpatialIndex::insert(int idx, int x, int y, int w, int h) {
+    rects_[idx] = Rect{x, y, x + w, y + h};
+    if (nbx_ == 0) return;
+
+    int bx0 = binX(x), bx1 = binX(std::max(x, x + w - 1));
+    int by0 = binY(y), by1 = binY(std::max(y, y + h - 1));
+    for (int by = by0; by <= by1; ++by) {
+        for (int bx = bx0; bx <= bx1; ++bx) {
+            bins_[by * nbx_ + bx].push_back(idx);
+        }
+    }
+}
+
+void SpatialIndex::remove(int idx) {
+    if (nbx_ == 0) return;
+
+    const Rect& r = rects_[idx];
+    int bx0 = binX(r.x0), bx1 = binX(std::max(r.x0, r.x1 - 1));
+    int by0 = binY(r.y0), by1 = binY(std::max(r.y0, r.y1 - 1));
+    for (int by = by0; by <= by1; ++by) {
+        for (int bx = bx0; bx <= bx1; ++bx) {
+            std::vector<int>& bin = bins_[by * nbx_ + bx];
+            auto it = std::find(bin.begin(), bin.end(), idx);
+            if (it != bin.end()) {
+                *it = bin.back();
+                bin.pop_back();
+            }
+        }
+    }
+}
@@ -0,0 +1,67 @@
+#ifndef SPATIAL_INDEX_H
+#define SPATIAL_INDEX_H
+
+#include "placement.h"
+#include <algorithm>
+#include <vector>
+
+// Uniform-bin spatial index over cell rectangles.
+// Every cell is registered in each bin its footprint touches, so overlap and
+// neighbourhood queries only look at the cells in the bins a rectangle
+// covers. Cells are addressed by dense index and the index must be told
+// about moves via remove()/insert() (or update()).
+
+class SpatialIndex {
+public:
+    SpatialIndex() : bin_size_(1), nbx_(0), nby_(0) {}
+
+    // Index all cells of the placement. bin_size <= 0 derives a bin size
+    // from the average cell dimensions.
+    void build(const Placement& pl, int bin_size = 0);
+
+    // Register / unregister a cell at the given rectangle
+    void insert(int idx, int x, int y, int w, int h);
+    void remove(int idx);
+
+    // Re-register a cell at its new rectangle
+    void update(int idx, int x, int y, int w, int h) {
+        remove(idx);
+        insert(idx, x, y, w, h);
+    }
+
+    // Call fn(idx) once for every cell whose rectangle intersects
+    // [x0, x1) x [y0, y1). Const and stateless, so safe to call from
+    // several threads while nobody modifies the index.
+    template <typename Fn>
+    void query(int x0, int y0, int x1, int y1, Fn fn) const {
+        if (nbx_ == 0 || x1 <= x0 || y1 <= y0) return;
+        int bx0 = binX(x0), bx1 = binX(x1 - 1);
+        int by0 = binY(y0), by1 = binY(y1 - 1);
+        for (int by = by0; by <= by1; ++by) {
+            for (int bx = bx0; bx <= bx1; ++bx) {
+                for (int idx : bins_[by * nbx_ + bx]) {
+                    const Rect& r = rects_[idx];
+                    if (r.x1 <= x0 || x1 <= r.x0 || r.y1 <= y0 || y1 <= r.y0) continue;
+                    // Report each cell only from the first bin both share
+                    if (bx != std::max(bx0, binX(r.x0)) || by != std::max(by0, binY(r.y0))) continue;
+                    fn(idx);
+                }
+            }
+        }
+    }
+
+    int binSize() const { return bin_size_; }
+
+private:
+    struct Rect { int x0, y0, x1, y1; };
+
+    int bin_size_;
+    int nbx_, nby_;
+    std::vector<std::vector<int>> bins_;
+    std::vector<Rect> rects_;
+
+    int binX(int x) const { return std::min(std::max(x / bin_size_, 0), nbx_ - 1); }
+    int binY(int y) const { return std::min(std::max(y / bin_size_, 0), nby_ - 1); }
+};
+
+#endif // SPATIAL_INDEX_H
@@ -1,7 +1,11 @@
 #include "anneal.h"
+#include "../util/profiler.h"
 #include <algorithm>
+#include <chrono>
+#include <climits>
 #include <cmath>
 #include <iostream>
+#include <memory>
 
 void SimulatedAnnealing::randomInitialPlacement(Placement& pl) {
     for (auto& cell : pl.cells) {
@@ -26,6 +30,15 @@ void SimulatedAnnealing::randomInitialPlacement(Placement& pl) {
     pl.updateGrid();
 }
 
+void SimulatedAnnealing::prepare(const Placement& pl) {
+    movable_.clear();
+    for (size_t i = 0; i < pl.cells.size(); ++i) {
+        if (!pl.cells[i].fixed) {
+            movable_.push_back(static_cast<int>(i));
+        }
+    }
+}
+
 Move SimulatedAnnealing::proposeMove(const Placement& pl) {
     Move move;
     
@@ -34,78 +47,118 @@ Move SimulatedAnnealing::proposeMove(const Placement& pl) {
         // Shift move
         move.type = Move::SHIFT;
         
-        // Find a movable cell
-        std::vector<int> movable_cells;
-        for (const auto& cell : pl.cells) {
-            if (!cell.fixed) {
-                movable_cells.push_back(cell.id);
-            }
+        if (movable_.empty()) {
+            move.cell_idx1 = -1;
+            return move;
         }
         
-        if (movable_cells.empty()) {
-            move.cell_id1 = -1;
+        move.cell_idx1 = movable_[randInt(0, movable_.size() - 1)];
+        const Cell& cell = pl.cells[move.cell_idx1];
+        
+        int x0, y0, x1, y1;
+        moveArea(pl, x0, y0, x1, y1);
+        int max_x = std::max(x0, x1 - cell.w);
+        int max_y = std::max(y0, y1 - cell.h);
+        
+        if (window_ > 0) {
+            // Range limiter: stay within the window around the cell
+            const int r = static_cast<int>(window_);
+            const int cx = std::max(x0, std::min(cell.x, max_x));
+            const int cy = std::max(y0, std::min(cell.y, max_y));
+            x0 = std::max(x0, cx - r);
+            y0 = std::max(y0, cy - r);
+            max_x = std::min(max_x, cx + r);
+            max_y = std::min(max_y, cy + r);
+        }
+        move.new_x = randInt(x0, max_x);
+        move.new_y = randInt(y0, max_y);
+    } else if (window_ > 0) {
+        // Windowed swap: exchange with the cell at a random point near the
+        // cell, or move there if the point is empty
+        if (movable_.size() < 2) {
+            move.cell_idx1 = -1;
             return move;
         }
         
-        move.cell_id1 = movable_cells[randInt(0, movable_cells.size() - 1)];
-        const Cell* cell = pl.findCell(move.cell_id1);
+        const int idx1 = movable_[randInt(0, movable_.size() - 1)];
+        const Cell& cell = pl.cells[idx1];
+        int x0, y0, x1, y1;
+        moveArea(pl, x0, y0, x1, y1);
+        const int r = static_cast<int>(window_);
+        const int cx = std::max(x0, std::min(cell.x, x1 - 1));
+        const int cy = std::max(y0, std::min(cell.y, y1 - 1));
+        const int px = randInt(std::max(x0, cx - r), std::min(x1 - 1, cx + r));
+        const int py = randInt(std::max(y0, cy - r), std::min(y1 - 1, cy + r));
         
-        if (cell) {
-            int max_x = std::max(0, pl.grid.W - cell->w);
-            int max_y = std::max(0, pl.grid.H - cell->h);
-            
-            move.new_x = randInt(0, max_x);
-            move.new_y = randInt(0, max_y);
+        // Lowest index among the cells there, so the choice does not depend
+        // on the order of the index bins (which differs after a resume)
+        int partner = -1;
+        if (index_) {
+            index_->query(px, py, px + 1, py + 1, [&](int idx) {
+                if (idx != idx1 && !pl.cells[idx].fixed && (partner < 0 || idx < partner)) partner = idx;
+            });
+        }
+        move.cell_idx1 = idx1;
+        if (partner >= 0) {
+            move.type = Move::SWAP;
+            move.cell_idx2 = partner;
+        } else {
+            move.type = Move::SHIFT;
+            move.new_x = std::min(px, std::max(x0, x1 - cell.w));
+            move.new_y = std::min(py, std::max(y0, y1 - cell.h));
         }
     } else {
         // Swap move
         move.type = Move::SWAP;
         
-        std::vector<int> movable_cells;
-        for (const auto& cell : pl.cells) {
-            if (!cell.fixed) {
-                movable_cells.push_back(cell.id);
-            }
-        }
-        
-        if (movable_cells.size() < 2) {
-            move.cell_id1 = -1;
+        if (movable_.size() < 2) {
+            move.cell_idx1 = -1;
             return move;
         }
         
-        int idx1 = randInt(0, movable_cells.size() - 1);
-        int idx2 = randInt(0, movable_cells.size() - 1);
-        while (idx2 == idx1 && movable_cells.size() > 1) {
-            idx2 = randInt(0, movable_cells.size() - 1);
+        int idx1 = randInt(0, movable_.size() - 1);
+        int idx2 = randInt(0, movable_.size() - 1);
+        while (idx2 == idx1) {
+            idx2 = randInt(0, movable_.size() - 1);
         }
         
-        move.cell_id1 = movable_cells[idx1];
-        move.cell_id2 = movable_cells[idx2];
+        move.cell_idx1 = movable_[idx1];
+        move.cell_idx2 = movable_[idx2];
     }
     
     return move;
 }
 
 bool SimulatedAnnealing::isValidMove(const Placement& pl, const Move& move) {
-    if (move.cell_id1 == -1) return false;
+    const int num_cells = static_cast<int>(pl.cells.size());
+    if (move.cell_idx1 < 0 || move.cell_idx1 >= num_cells) return false;
+    
+    int x0, y0, x1, y1;
+    moveArea(pl, x0, y0, x1, y1);
     
     if (move.type == Move::SHIFT) {
-        const Cell* cell = pl.findCell(move.cell_id1);
-        if (!cell) return false;
-        if (cell->fixed) return false;
+        const Cell& cell = pl.cells[move.cell_idx1];
+        if (cell.fixed) return false;
         
         // Check bounds
-        if (move.new_x < 0 || move.new_y < 0) return false;
-        if (move.new_x + cell->w > pl.grid.W) return false;
-        if (move.new_y + cell->h > pl.grid.H) return false;
+        if (move.new_x < x0 || move.new_y < y0) return false;
+        if (move.new_x + cell.w > x1) return false;
+        if (move.new_y + cell.h > y1) return false;
         
         return true;
     } else {  // SWAP
-        const Cell* cell1 = pl.findCell(move.cell_id1);
-        const Cell* cell2 = pl.findCell(move.cell_id2);
+        if (move.cell_idx2 < 0 || move.cell_idx2 >= num_cells) return false;
+        if (move.cell_idx1 == move.cell_idx2) return false;
         
-        if (!cell1 || !cell2) return false;
-        if (cell1->fixed || cell2->fixed) return false;
+        const Cell& cell1 = pl.cells[move.cell_idx1];
+        const Cell& cell2 = pl.cells[move.cell_idx2];
+        if (cell1.fixed || cell2.fixed) return false;
+        
+        // Each cell must fit at the other's position
+        if (bounded_) {
+            if (cell2.x + cell1.w > x1 || cell2.y + cell1.h > y1) return false;
+            if (cell1.x + cell2.w > x1 || cell1.y + cell2.h > y1) return false;
+        }
         
         return true;
     }
@@ -113,92 +166,278 @@ bool SimulatedAnnealing::isValidMove(const Placement& pl, const Move& move) {
 
 void SimulatedAnnealing::applyMove(Placement& pl, const Move& move) {
     if (move.type == Move::SHIFT) {
-        Cell* cell = pl.findCell(move.cell_id1);
-        if (cell) {
-            cell->x = move.new_x;
-            cell->y = move.new_y;
-        }
+        pl.removeCell(move.cell_idx1);
+        Cell& cell = pl.cells[move.cell_idx1];
+        cell.x = move.new_x;
+        cell.y = move.new_y;
+        pl.insertCell(move.cell_idx1);
     } else {  // SWAP
-        Cell* cell1 = pl.findCell(move.cell_id1);
-        Cell* cell2 = pl.findCell(move.cell_id2);
+        pl.removeCell(move.cell_idx1);
+        pl.removeCell(move.cell_idx2);
+        Cell& cell1 = pl.cells[move.cell_idx1];
+        Cell& cell2 = pl.cells[move.cell_idx2];
+        std::swap(cell1.x, cell2.x);
+        std::swap(cell1.y, cell2.y);
+        pl.insertCell(move.cell_idx1);
+        pl.insertCell(move.cell_idx2);
+    }
+}
+
+double SimulatedAnnealing::evaluateMove(IncrementalCost& cost, const Move& move) {
+    if (move.type == Move::SHIFT) {
+        return cost.evaluateShift(move.cell_idx1, move.new_x, move.new_y);
+    }
+    return cost.evaluateSwap(move.cell_idx1, move.cell_idx2);
+}
+
+int SimulatedAnnealing::sweep(Placement& pl, IncrementalCost& cost, int moves, double T) {
+    ProfileScope scope("anneal_sweep");
+    index_ = &cost.spatialIndex();
+    int accepted_moves = 0;
+    
+    for (int it = 0; it < moves; ++it) {
+        Move move = proposeMove(pl);
+        
+        if (!isValidMove(pl, move)) continue;
+        
+        double delta_cost = evaluateMove(cost, move);
         
-        if (cell1 && cell2) {
-            std::swap(cell1->x, cell2->x);
-            std::swap(cell1->y, cell2->y);
+        // Accept or reject
+        bool accept = false;
+        if (delta_cost <= 0) {
+            accept = true;
+        } else {
+            double prob = std::exp(-delta_cost / T);
+            if (rand01() < prob) {
+                accept = true;
+            }
+        }
+        
+        if (accept) {
+            cost.commit();
+            accepted_moves++;
+        } else {
+            cost.rollback();
         }
     }
-    pl.updateGrid();
+    
+    index_ = nullptr;
+    Profiler::count(Profiler::MOVES_PROPOSED, moves);
+    Profiler::count(Profiler::MOVES_ACCEPTED, accepted_moves);
+    return accepted_moves;
+}
+
+int SimulatedAnnealing::adaptiveMovesPerEpoch(int movable, double effort) {
+    // At least one move per cell, for tiny designs
+    double moves = std::max(static_cast<double>(movable),
+                            effort * std::pow(static_cast<double>(movable), 4.0 / 3.0));
+    return static_cast<int>(std::max(1.0, std::min(moves, static_cast<double>(INT_MAX / 2))));
+}
+
+double SimulatedAnnealing::sampleTemperature(Placement& pl, IncrementalCost& cost, int samples,
+                                             double acceptance) {
+    index_ = &cost.spatialIndex();
+    double uphill = 0.0;
+    int count = 0;
+    for (int s = 0; s < samples; ++s) {
+        Move move = proposeMove(pl);
+        if (!isValidMove(pl, move)) continue;
+        double delta = evaluateMove(cost, move);
+        cost.rollback();
+        if (delta > 0) {
+            uphill += delta;
+            count++;
+        }
+    }
+    index_ = nullptr;
+    if (count == 0) return 0.0;
+    
+    // exp(-mean / T) = acceptance
+    acceptance = std::max(0.01, std::min(0.99, acceptance));
+    return -(uphill / count) / std::log(acceptance);
+}
+
+void SimulatedAnnealing::adapt(const Placement& pl, double acceptance) {
+    int x0, y0, x1, y1;
+    moveArea(pl, x0, y0, x1, y1);
+    const double max_window = std::max(1, std::max(x1 - x0, y1 - y0));
+    window_ *= 1.0 - adaptive_options_.target_acceptance + acceptance;
+    window_ = std::max(1.0, std::min(window_, max_window));
+    
+    // Cool fast at the hot and cold ends, slowly in between
+    double alpha;
+    if (acceptance > 0.96) {
+        alpha = 0.5;
+    } else if (acceptance > 0.8) {
+        alpha = 0.9;
+    } else if (acceptance > 0.15 || window_ > 1.0) {
+        alpha = 0.95;
+    } else {
+        alpha = 0.8;
+    }
+    T_ *= alpha;
 }
 
 void SimulatedAnnealing::optimize(Placement& pl, int max_epochs, int moves_per_epoch) {
-    // Initialize random placement if needed
-    randomInitialPlacement(pl);
+    // A resumed run starts from the checkpointed positions
+    const bool resuming = resuming_;
+    resuming_ = false;
+    if (resuming) {
+        resume_.restorePositions(pl);
+    } else if (random_start_) {
+        randomInitialPlacement(pl);
+    }
+    prepare(pl);
     
     T_ = T0_;
+    window_ = 0.0;
     
-    // Default moves per epoch: 10 × number of cells
     if (moves_per_epoch == 0) {
-        moves_per_epoch = 10 * pl.cells.size();
+        moves_per_epoch = adaptive_
+            ? adaptiveMovesPerEpoch(static_cast<int>(movable_.size()), adaptive_options_.effort)
+            : defaultMovesPerEpoch(pl);
     }
     
+    // Moves are scored incrementally; the engine owns the cached cost terms
+    IncrementalCost cost(pl, lambda_overlap_, lambda_density_, density_bin_size_);
+    
+    // Adaptive schedule: T0 from the uphill moves at the starting window
+    if (adaptive_ && !resuming) {
+        int x0, y0, x1, y1;
+        moveArea(pl, x0, y0, x1, y1);
+        const int initial_window = adaptive_options_.initial_window;
+        window_ = initial_window > 0 ? initial_window : 0.0;
+        const int samples = static_cast<int>(std::max<size_t>(100, std::min<size_t>(movable_.size(), 10000)));
+        const double T0 = sampleTemperature(pl, cost, samples, adaptive_options_.initial_acceptance);
+        if (T0 > 0) T_ = T0;
+        window_ = initial_window > 0 ? initial_window : std::max(1, std::max(x1 - x0, y1 - y0));
+        if (verbose_) {
+            std::cout << "Adaptive schedule: T0 = " << T_ << " from " << samples << " sampled moves, window = "
+                      << window_ << ", " << moves_per_epoch << " moves per epoch" << std::endl;
+        }
+    }
+    const double num_nets = std::max<double>(1.0, static_cast<double>(pl.nets.size()));
+    
     std::vector<double> cost_history;
-    double current_cost = CostCalculator::calculateTotalCost(pl, lambda_overlap_, lambda_density_);
-    cost_history.push_back(current_cost);
-    
-    std::cout << "Initial cost: " << current_cost << std::endl;
-    
-    for (int epoch = 0; epoch < max_epochs; ++epoch) {
-        int accepted_moves = 0;
-        
-        for (int it = 0; it < moves_per_epoch; ++it) {
-            Move move = proposeMove(pl);
-            
-            if (!isValidMove(pl, move)) continue;
-            
-            // Create a copy to evaluate the move
-            Placement test_pl = pl;
-            applyMove(test_pl, move);
-            
-            double new_cost = CostCalculator::calculateTotalCost(test_pl, lambda_overlap_, lambda_density_);
-            double delta_cost = new_cost - current_cost;
-            
-            // Accept or reject
-            bool accept = false;
-            if (delta_cost <= 0) {
-                accept = true;
-            } else {
-                double prob = std::exp(-delta_cost / T_);
-                if (rand01() < prob) {
-                    accept = true;
-                }
-            }
-            
-            if (accept) {
-                applyMove(pl, move);
-                current_cost = new_cost;
-                accepted_moves++;
-            }
+    double current_cost = cost.totalCost();
+    int first_epoch = 0;
+    double best_cost = current_cost;
+    int best_epoch = 0;
+    bool finished = false;
+    
+    if (resuming) {
+        T_ = resume_.T;
+        window_ = resume_.window;
+        rng_ = resume_.rng;
+        moves_per_epoch = resume_.moves_per_epoch;
+        cost_history = std::move(resume_.cost_history);
+        first_epoch = resume_.epoch;
+        best_cost = resume_.best_cost;
+        best_epoch = resume_.best_epoch;
+        finished = resume_.finished;
+        resume_ = AnnealCheckpoint();
+        if (verbose_) {
+            std::cout << "Resumed at epoch " << first_epoch << ": cost = " << current_cost
+                      << ", T = " << T_ << (finished ? " (annealing had finished)" : "") << std::endl;
         }
+    } else {
+        cost_history.push_back(current_cost);
+        if (verbose_) std::cout << "Initial cost: " << current_cost << std::endl;
+    }
+    
+    // Checkpoints copy the state here and are written in the background
+    std::unique_ptr<CheckpointWriter> writer;
+    if (!checkpoint_file_.empty()) writer.reset(new CheckpointWriter(checkpoint_file_));
+    const uint64_t design = writer ? AnnealCheckpoint::fingerprint(pl) : 0;
+    int epochs_done = first_epoch;
+    int last_checkpoint_epoch = first_epoch;
+    auto last_checkpoint_time = std::chrono::steady_clock::now();
+    auto checkpoint = [&]() {
+        AnnealCheckpoint state;
+        state.design = design;
+        state.epoch = epochs_done;
+        state.moves_per_epoch = moves_per_epoch;
+        state.finished = finished;
+        state.T = T_;
+        state.adaptive = adaptive_;
+        state.window = window_;
+        state.best_cost = best_cost;
+        state.best_epoch = best_epoch;
+        state.rng = rng_;
+        state.cost_history = cost_history;
+        state.savePositions(pl);
+        writer->submit(std::move(state));
+        last_checkpoint_epoch = epochs_done;
+        last_checkpoint_time = std::chrono::steady_clock::now();
+    };
+    
+    for (int epoch = first_epoch; epoch < max_epochs && !finished; ++epoch) {
+        int accepted_moves = sweep(pl, cost, moves_per_epoch, T_);
         
+        current_cost = cost.totalCost();
         cost_history.push_back(current_cost);
+        epochs_done = epoch + 1;
+        if (current_cost < best_cost) {
+            best_cost = current_cost;
+            best_epoch = epochs_done;
+        }
         
         // Cool down
-        T_ *= alpha_;
+        if (adaptive_) {
+            adapt(pl, static_cast<double>(accepted_moves) / moves_per_epoch);
+        } else {
+            cool();
+        }
         
         // Print progress
-        if (epoch % 10 == 0 || epoch == max_epochs - 1) {
+        if (verbose_ && (epoch % 10 == 0 || epoch == max_epochs - 1)) {
             std::cout << "Epoch " << epoch << ": cost = " << current_cost 
                       << ", T = " << T_ << ", accepted = " << accepted_moves 
-                      << "/" << moves_per_epoch << std::endl;
+                      << "/" << moves_per_epoch;
+            if (adaptive_) std::cout << ", window = " << window_;
+            std::cout << std::endl;
         }
         
-        // Check for convergence
-        if (hasStalled(cost_history)) {
-            std::cout << "Converged at epoch " << epoch << std::endl;
+        // Check for convergence: the adaptive schedule stops once uphill
+        // moves of a small fraction of a net are no longer accepted
+        if (adaptive_ ? T_ < adaptive_options_.exit_ratio * current_cost / num_nets
+                      : hasStalled(cost_history)) {
+            if (verbose_) std::cout << "Converged at epoch " << epoch << std::endl;
             break;
         }
+        
+        if (writer && epochs_done < max_epochs) {
+            std::chrono::duration<double> since = std::chrono::steady_clock::now() - last_checkpoint_time;
+            if ((checkpoint_epochs_ > 0 && epochs_done - last_checkpoint_epoch >= checkpoint_epochs_) ||
+                (checkpoint_seconds_ > 0 && since.count() >= checkpoint_seconds_)) {
+                checkpoint();
+            }
+        }
     }
     
-    std::cout << "Final cost: " << current_cost << std::endl;
+    // Greedy quench at the final window
+    if (adaptive_ && !finished) {
+        sweep(pl, cost, moves_per_epoch, 0.0);
+        current_cost = cost.totalCost();
+        cost_history.push_back(current_cost);
+        if (current_cost < best_cost) {
+            best_cost = current_cost;
+            best_epoch = epochs_done;
+        }
+        if (verbose_) std::cout << "Quench: cost = " << current_cost << std::endl;
+    }
+    finished = true;
+    
+    // The final checkpoint lets a resumed job skip annealing altogether
+    if (writer) {
+        checkpoint();
+        if (writer->wait() && verbose_) {
+            std::cout << "Checkpoint written to " << checkpoint_file_ << std::endl;
+        }
+    }
+    
+    // Cell positions were updated in place by the engine
+    pl.updateGrid();
+    
+    if (verbose_) std::cout << "Final cost: " << current_cost << std::endl;
 }
-
@@ -3,31 +3,99 @@
 
 #include "../model/placement.h"
 #include "../cost/cost.h"
+#include "../cost/incremental_cost.h"
+#include "checkpoint.h"
+#include "../model/spatial_index.h"
 #include <random>
+#include <string>
 
 // Simulated annealing optimizer for placement
 
 struct Move {
     enum Type { SHIFT, SWAP };
     Type type;
-    int cell_id1;
-    int cell_id2;  // For swap moves
+    int cell_idx1;     // Dense cell index (see Placement::cellIndex)
+    int cell_idx2;     // For swap moves
     int new_x, new_y;  // For shift moves
     
-    Move() : type(SHIFT), cell_id1(-1), cell_id2(-1), new_x(0), new_y(0) {}
+    Move() : type(SHIFT), cell_idx1(-1), cell_idx2(-1), new_x(0), new_y(0) {}
+};
+
+// Adaptive schedule for SimulatedAnnealing::optimize() (see setAdaptive).
+// T0 is set so that a given share of sampled uphill moves would be
+// accepted. After every epoch a range limiter scales the move window by
+// (1 - target + acceptance), which holds acceptance near the target (Lam's
+// 44%) by shrinking the window as the temperature falls, and the
+// temperature is cooled by a factor chosen from the acceptance: fast while
+// nearly everything is accepted, slowly in the productive middle range.
+// Annealing stops when T falls below `exit_ratio` times the cost per net,
+// followed by one greedy sweep at the smallest window.
+struct AdaptiveOptions {
+    double initial_acceptance = 0.9;  // Uphill acceptance at T0
+    int initial_window = 0;           // Move window at T0 (0 = whole area)
+    double target_acceptance = 0.44;
+    double effort = 0.2;              // Moves per epoch = effort * N^(4/3), at least N
+    double exit_ratio = 0.005;
 };
 
 class SimulatedAnnealing {
 public:
     SimulatedAnnealing(double T0 = 1000.0, double alpha = 0.90, 
-                      double lambda_overlap = 1.0, double lambda_density = 0.1)
+                      double lambda_overlap = 1.0, double lambda_density = 0.1,
+                      int density_bin_size = 0)
         : T0_(T0), alpha_(alpha), lambda_overlap_(lambda_overlap),
-          lambda_density_(lambda_density), rng_(std::random_device{}()) {}
+          lambda_density_(lambda_density), density_bin_size_(density_bin_size),
+          T_(T0), rng_(std::random_device{}()) {}
+    
+    // Seed the move generator; without a seed runs are not reproducible
+    void setSeed(unsigned seed) { rng_.seed(seed); }
+    
+    // Enable or disable progress output
+    void setVerbose(bool verbose) { verbose_ = verbose; }
     
     // Perform initial random placement
     void randomInitialPlacement(Placement& pl);
     
-    // Propose a random move
+    // Start optimize() from a random placement (default) or from the
+    // current positions, e.g. after global placement
+    void setRandomStart(bool random_start) { random_start_ = random_start; }
+    
+    // Replace the fixed geometric schedule (T0, alpha, convergence test) of
+    // optimize() with the adaptive one
+    void setAdaptive(const AdaptiveOptions& options) {
+        adaptive_ = true;
+        adaptive_options_ = options;
+    }
+    bool adaptive() const { return adaptive_; }
+    
+    // Write a checkpoint to `filename` during optimize() every `every_epochs`
+    // epochs or `every_seconds` seconds, whichever comes first (0 = never),
+    // and once more when annealing ends. Writes run in the background.
+    void setCheckpoint(const std::string& filename, int every_epochs, double every_seconds) {
+        checkpoint_file_ = filename;
+        checkpoint_epochs_ = every_epochs;
+        checkpoint_seconds_ = every_seconds;
+    }
+    
+    // Make the next optimize() continue from a checkpoint (see
+    // Checkpoint::read) instead of starting over
+    void resumeFrom(const AnnealCheckpoint& state) {
+        resume_ = state;
+        resuming_ = true;
+    }
+    
+    // Keep moves inside [x0, x1) x [y0, y1): shifted and swapped cells must
+    // fit entirely in the rectangle. Without bounds the whole grid is used.
+    void setBounds(int x0, int y0, int x1, int y1) {
+        bounded_ = true;
+        bx0_ = x0; by0_ = y0; bx1_ = x1; by1_ = y1;
+    }
+    void clearBounds() { bounded_ = false; }
+    
+    // Collect the movable cells that proposeMove() draws from
+    void prepare(const Placement& pl);
+    
+    // Propose a random move (call prepare() first)
     Move proposeMove(const Placement& pl);
     
     // Check if a move is valid
@@ -36,34 +104,50 @@ public:
     // Apply a move to placement
     void applyMove(Placement& pl, const Move& move);
     
+    // Score a move with the incremental engine; the move stays pending
+    // until the caller commits or rolls it back
+    double evaluateMove(IncrementalCost& cost, const Move& move);
+    
+    // Run `moves` proposals at temperature T against an engine bound to
+    // `pl` (call prepare() first); returns the number of accepted moves
+    int sweep(Placement& pl, IncrementalCost& cost, int moves, double T);
+    
     // Run simulated annealing optimization
     void optimize(Placement& pl, int max_epochs = 100, int moves_per_epoch = 0);
     
-    // Get current temperature
+    // Temperature control for drivers that run epochs themselves
     double getTemperature() const { return T_; }
+    void setTemperature(double T) { T_ = T; }
+    void cool() { T_ *= alpha_; }
+    double initialTemperature() const { return T0_; }
     
-private:
-    double T0_;  // Initial temperature
-    double alpha_;  // Cooling factor
-    double lambda_overlap_;
-    double lambda_density_;
-    double T_;  // Current temperature
-    std::mt19937 rng_;
+    // Cost weights used for the incremental engine
+    double lambdaOverlap() const { return lambda_overlap_; }
+    double lambdaDensity() const { return lambda_density_; }
+    int densityBinSize() const { return density_bin_size_; }
     
-    // Random number generators
-    double rand01() {
-        std::uniform_real_distribution<double> dist(0.0, 1.0);
-        return dist(rng_);
+    // Default moves per epoch: 10 × number of cells
+    static int defaultMovesPerEpoch(const Placement& pl) {
+        return static_cast<int>(10 * pl.cells.size());
     }
     
-    int randInt(int min, int max) {
-        std::uniform_int_distribution<int> dist(min, max);
-        return dist(rng_);
-    }
+    // Moves per epoch of the adaptive schedule for `movable` cells
+    static int adaptiveMovesPerEpoch(int movable, double effort);
+    
+    // Temperature at which a share `acceptance` of the uphill moves among
+    // `samples` random proposals would be accepted (call prepare() first).
+    // The placement is left unchanged; returns 0 if no move went uphill.
+    double sampleTemperature(Placement& pl, IncrementalCost& cost, int samples, double acceptance);
+    
+    // Range limit for proposeMove(): cells move at most `window` squares
+    // per axis and swap with a cell around the target (0 = no limit)
+    void setWindow(double window) { window_ = window; }
+    double window() const { return window_; }
     
     // Check if placement has stalled (cost not improving)
-    bool hasStalled(const std::vector<double>& cost_history, size_t window = 10) {
-        if (cost_history.size() < window) return false;
+    static bool hasStalled(const std::vector<double>& cost_history, size_t window = 10) {
+        // Needs two full windows before the latest entry
+        if (cost_history.size() < 2 * window + 1) return false;
         double recent_avg = 0.0;
         double older_avg = 0.0;
         
@@ -77,6 +161,53 @@ private:
         // Stalled if improvement is less than 1%
         return (older_avg - recent_avg) / older_avg < 0.01;
     }
+    
+private:
+    double T0_;  // Initial temperature
+    double alpha_;  // Cooling factor
+    double lambda_overlap_;
+    double lambda_density_;
+    int density_bin_size_;  // Density map bin size (0 = default binning)
+    double T_;  // Current temperature
+    bool verbose_ = true;
+    bool random_start_ = true;
+    std::mt19937 rng_;
+    std::vector<int> movable_;  // Indices of movable cells
+    std::string checkpoint_file_;  // Checkpoints (see setCheckpoint)
+    int checkpoint_epochs_ = 0;
+    double checkpoint_seconds_ = 0.0;
+    AnnealCheckpoint resume_;      // State for the next optimize()
+    bool resuming_ = false;
+    bool bounded_ = false;      // Move bounds (see setBounds)
+    int bx0_ = 0, by0_ = 0, bx1_ = 0, by1_ = 0;
+    bool adaptive_ = false;     // Adaptive schedule (see setAdaptive)
+    AdaptiveOptions adaptive_options_;
+    double window_ = 0.0;       // Range limit (see setWindow)
+    const SpatialIndex* index_ = nullptr;  // Swap partners; set during sweep()
+    
+    // Adaptive schedule step after an epoch with the given acceptance:
+    // range limiter, then cooling
+    void adapt(const Placement& pl, double acceptance);
+    
+    // Move area for the current placement: bounds or the whole grid
+    void moveArea(const Placement& pl, int& x0, int& y0, int& x1, int& y1) const {
+        if (bounded_) {
+            x0 = bx0_; y0 = by0_; x1 = bx1_; y1 = by1_;
+        } else {
+            x0 = 0; y0 = 0; x1 = pl.grid.W; y1 = pl.grid.H;
+        }
+    }
+    
+    // Random number generators
+    double rand01() {
+        std::uniform_real_distribution<double> dist(0.0, 1.0);
+        return dist(rng_);
+    }
+    
+    int randInt(int min, int max) {
+        std::uniform_int_distribution<int> dist(min, max);
+        return dist(rng_);
+    }
 };
 
 #endif // ANNEAL_H
@@ -0,0 +1,205 @@
+#include "checkpoint.h"
+#include "../util/profiler.h"
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+namespace {
+
+struct CheckpointHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint64_t design;
+    int32_t epoch, moves_per_epoch, finished, best_epoch, adaptive, unused;
+    double T, best_cost, window;
+    uint64_t num_cells;     // Length of the x and y arrays (int32)
+    uint64_t num_history;   // Length of the cost history (double)
+    uint64_t rng_size;      // Bytes of the move generator state (text)
+};
+
+const char kMagic[8] = {'P', 'L', 'C', 'C', 'K', 'P', 'T', '\0'};
+const uint32_t kVersion = 2;
+const uint32_t kByteOrder = 0x01020304;
+
+static_assert(sizeof(int) == 4, "Positions are written straight from int vectors");
+
+// FNV-1a over 32-bit words
+void hashWord(uint64_t& h, uint32_t word) {
+    for (int b = 0; b < 4; ++b) {
+        h ^= (word >> (8 * b)) & 0xff;
+        h *= 1099511628211ULL;
+    }
+}
+
+bool writeAll(std::FILE* file, const void* data, size_t bytes) {
+    return bytes == 0 || std::fwrite(data, 1, bytes, file) == bytes;
+}
+
+}  // namespace
+
+uint64_t AnnealCheckpoint::fingerprint(const Placement& pl) {
+    uint64_t h = 14695981039346656037ULL;
+    hashWord(h, static_cast<uint32_t>(pl.grid.W));
+    hashWord(h, static_cast<uint32_t>(pl.grid.H));
+    for (const auto& cell : pl.cells) {
+        hashWord(h, static_cast<uint32_t>(cell.id));
+        hashWord(h, static_cast<uint32_t>(cell.w));
+        hashWord(h, static_cast<uint32_t>(cell.h));
+        hashWord(h, cell.fixed ? 1 : 0);
+    }
+    return h;
+}
+
+void AnnealCheckpoint::savePositions(const Placement& pl) {
+    const size_t n = pl.cells.size();
+    x.resize(n);
+    y.resize(n);
+    for (size_t i = 0; i < n; ++i) {
+        x[i] = pl.cells[i].x;
+        y[i] = pl.cells[i].y;
+    }
+}
+
+void AnnealCheckpoint::restorePositions(Placement& pl) const {
+    for (size_t i = 0; i < pl.cells.size() && i < x.size(); ++i) {
+        pl.cells[i].x = x[i];
+        pl.cells[i].y = y[i];
+    }
+    pl.updateGrid();
+}
+
+bool Checkpoint::write(const AnnealCheckpoint& state, const std::string& filename) {
+    ProfileScope scope("checkpoint_write");
+    std::ostringstream rng_text;
+    rng_text << state.rng;
+    const std::string rng = rng_text.str();
+
+    CheckpointHeader h;
+    std::memset(&h, 0, sizeof(h));
+    std::memcpy(h.magic, kMagic, sizeof(h.magic));
+    h.version = kVersion;
+    h.byte_order = kByteOrder;
+    h.design = state.design;
+    h.epoch = state.epoch;
+    h.moves_per_epoch = state.moves_per_epoch;
+    h.finished = state.finished ? 1 : 0;
+    h.best_epoch = state.best_epoch;
+    h.adaptive = state.adaptive ? 1 : 0;
+    h.T = state.T;
+    h.best_cost = state.best_cost;
+    h.window = state.window;
+    h.num_cells = state.x.size();
+    h.num_history = state.cost_history.size();
+    h.rng_size = rng.size();
+
+    const std::string tmp = filename + ".tmp";
+    std::FILE* file = std::fopen(tmp.c_str(), "wb");
+    if (!file) {
+        std::cerr << "Error: Cannot open file " << tmp << " for writing" << std::endl;
+        return false;
+    }
+    bool ok = writeAll(file, &h, sizeof(h)) &&
+              writeAll(file, state.x.data(), state.x.size() * sizeof(int)) &&
+              writeAll(file, state.y.data(), state.y.size() * sizeof(int)) &&
+              writeAll(file, state.cost_history.data(), state.cost_history.size() * sizeof(double)) &&
+              writeAll(file, rng.data(), rng.size());
+    ok = std::fflush(file) == 0 && ok;
+#ifndef _WIN32
+    // The data must be on disk before the rename makes it the checkpoint
+    ok = fsync(fileno(file)) == 0 && ok;
+#endif
+    ok = std::fclose(file) == 0 && ok;
+    if (!ok) {
+        std::cerr << "Error: Failed writing " << tmp << std::endl;
+        std::remove(tmp.c_str());
+        return false;
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(tmp, filename, ec);
+    if (ec) {
+        std::cerr << "Error: Cannot rename " << tmp << " to " << filename << ": " << ec.message() << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool Checkpoint::read(const std::string& filename, const Placement& pl, AnnealCheckpoint& state) {
+    std::ifstream in(filename, std::ios::binary);
+    if (!in.is_open()) {
+        std::cerr << "Error: Cannot open file " << filename << std::endl;
+        return false;
+    }
+    auto fail = [&](const std::string& message) {
+        std::cerr << "Error: " << filename << ": " << message << std::endl;
+        return false;
+    };
+
+    CheckpointHeader h;
+    if (!in.read(reinterpret_cast<char*>(&h), sizeof(h)) ||
+        std::memcmp(h.magic, kMagic, sizeof(h.magic)) != 0) {
+        return fail("not a placement checkpoint");
+    }
+    if (h.byte_order != kByteOrder) return fail("checkpoint has the wrong byte order");
+    if (h.version != kVersion) return fail("unsupported checkpoint version " + std::to_string(h.version));
+    if (h.num_cells != pl.cells.size() || h.design != AnnealCheckpoint::fingerprint(pl)) {
+        return fail("checkpoint was written for a different design");
+    }
+    // Sizes are checked against the file before anything is allocated
+    in.seekg(0, std::ios::end);
+    const uint64_t file_size = static_cast<uint64_t>(in.tellg());
+    in.seekg(sizeof(h));
+    const uint64_t body = file_size - sizeof(h);
+    if (h.num_history > body / sizeof(double) || h.rng_size > body ||
+        2 * h.num_cells * sizeof(int) + h.num_history * sizeof(double) + h.rng_size != body) {
+        return fail("checkpoint is truncated or corrupt");
+    }
+
+    state.design = h.design;
+    state.epoch = h.epoch;
+    state.moves_per_epoch = h.moves_per_epoch;
+    state.finished = h.finished != 0;
+    state.best_epoch = h.best_epoch;
+    state.adaptive = h.adaptive != 0;
+    state.T = h.T;
+    state.best_cost = h.best_cost;
+    state.window = h.window;
+    state.x.resize(h.num_cells);
+    state.y.resize(h.num_cells);
+    state.cost_history.resize(h.num_history);
+    std::string rng(h.rng_size, '\0');
+    in.read(reinterpret_cast<char*>(state.x.data()), state.x.size() * sizeof(int));
+    in.read(reinterpret_cast<char*>(state.y.data()), state.y.size() * sizeof(int));
+    in.read(reinterpret_cast<char*>(state.cost_history.data()), state.cost_history.size() * sizeof(double));
+    in.read(&rng[0], rng.size());
+    if (!in) return fail("checkpoint is truncated or corrupt");
+
+    std::istringstream rng_text(rng);
+    rng_text >> state.rng;
+    if (rng_text.fail() || state.epoch < 0 || state.moves_per_epoch <= 0 || state.cost_history.empty()) {
+        return fail("checkpoint is corrupt");
+    }
+    return true;
+}
+
+void CheckpointWriter::submit(AnnealCheckpoint state) {
+    wait();
+    pending_ = std::move(state);
+    thread_ = std::thread([this]() { last_ok_ = Checkpoint::write(pending_, filename_); });
+}
+
+bool CheckpointWriter::wait() {
+    if (thread_.joinable()) {
+        thread_.join();
+        ok_ = ok_ && last_ok_;
+    }
+    return ok_;
+}
@@ -0,0 +1,79 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include "../model/placement.h"
+#include <cstdint>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Checkpoints of a SimulatedAnnealing run.
+// A checkpoint holds everything optimize() needs to continue exactly where
+// it stopped: the cell positions, the temperature and move window, the
+// move generator state, the epoch and the cost history. The cost engine
+// keeps only integer terms, so rebuilding it from the positions gives the
+// same move deltas and a resumed run is bit-identical to an uninterrupted
+// one.
+//
+// Files are written to `<file>.tmp` and renamed over `<file>`, so a job
+// killed mid-write leaves the previous checkpoint intact. The design
+// itself is not stored; a fingerprint of the grid and cells makes sure
+// the checkpoint is resumed against the same input.
+
+struct AnnealCheckpoint {
+    uint64_t design = 0;            // fingerprint() of the placement
+    int epoch = 0;                  // Epochs completed
+    int moves_per_epoch = 0;
+    bool finished = false;          // Epoch limit reached or converged
+    double T = 0.0;                 // Temperature for the next epoch
+    bool adaptive = false;          // Written by the adaptive schedule
+    double window = 0.0;            // Its move window for the next epoch
+    double best_cost = 0.0;         // Lowest cost seen so far
+    int best_epoch = 0;             // Epochs completed when it was seen
+    std::mt19937 rng;
+    std::vector<double> cost_history;
+    std::vector<int> x, y;          // Cell positions by dense index
+
+    // Hash of the grid size and every cell's id, size and fixed flag
+    static uint64_t fingerprint(const Placement& pl);
+
+    // Copy the cell positions to or from the placement
+    void savePositions(const Placement& pl);
+    void restorePositions(Placement& pl) const;
+};
+
+class Checkpoint {
+public:
+    // Write `state` atomically; false, after printing the error, on failure
+    static bool write(const AnnealCheckpoint& state, const std::string& filename);
+
+    // Read a checkpoint and check it belongs to `pl`; false, after
+    // printing the error, if it cannot be used
+    static bool read(const std::string& filename, const Placement& pl, AnnealCheckpoint& state);
+};
+
+// Writes checkpoints on a background thread so the annealer only pays for
+// copying its state. A new checkpoint waits for the previous write.
+class CheckpointWriter {
+public:
+    explicit CheckpointWriter(const std::string& filename) : filename_(filename) {}
+    ~CheckpointWriter() { wait(); }
+
+    CheckpointWriter(const CheckpointWriter&) = delete;
+    CheckpointWriter& operator=(const CheckpointWriter&) = delete;
+
+    void submit(AnnealCheckpoint state);
+
+    // Wait for the pending write; false if any write failed
+    bool wait();
+
+private:
+    std::string filename_;
+    AnnealCheckpoint pending_;
+    std::thread thread_;
+    bool ok_ = true;
+    bool last_ok_ = true;
+};
+
+#endif // CHECKPOINT_H
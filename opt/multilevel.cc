@@ -0,0 +1,276 @@
+#include "multilevel.h"
+#include "anneal.h"
+#include "../cost/cost.h"
+#include "../util/profiler.h"
+#include "../util/thread_pool.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <iostream>
+
+namespace {
+
+// Work is split into this many chunks whatever the thread count
+const int kChunks = 16;
+
+// Nets with more pins say little about which cells belong together
+const int kMaxScoredNetPins = 16;
+
+// Stop coarsening when a level keeps more than this share of the cells
+const double kMinReduction = 0.9;
+
+void forChunks(ThreadPool& pool, int n, const std::function<void(int, int, int)>& fn) {
+    pool.parallelFor(kChunks, [&](int c) {
+        fn(c, static_cast<int>(static_cast<long long>(n) * c / kChunks),
+           static_cast<int>(static_cast<long long>(n) * (c + 1) / kChunks));
+    });
+}
+
+int countMovable(const Placement& pl) {
+    int count = 0;
+    for (const auto& cell : pl.cells) {
+        if (!cell.fixed) count++;
+    }
+    return count;
+}
+
+}  // namespace
+
+bool MultilevelAnnealer::coarsen(const Placement& fine, double max_area, ThreadPool& pool,
+                                 Level& level) {
+    ProfileScope scope("multilevel_coarsen");
+    const Netlist& nl = fine.netlist;
+    const int n = static_cast<int>(fine.cells.size());
+
+    // Best neighbour of every movable cell: connectivity (1 / (p - 1) per
+    // shared p-pin net) per unit of combined area
+    std::vector<int> best(n, -1);
+    forChunks(pool, n, [&](int, int begin, int end) {
+        std::vector<std::pair<int, double>> neighbours;
+        for (int u = begin; u < end; ++u) {
+            const Cell& cu = fine.cells[u];
+            if (cu.fixed) continue;
+            neighbours.clear();
+            for (int k = nl.cell_net_start[u]; k < nl.cell_net_start[u + 1]; ++k) {
+                int net = nl.cell_nets[k];
+                int p0 = nl.net_pin_start[net], p1 = nl.net_pin_start[net + 1];
+                if (p1 - p0 < 2 || p1 - p0 > kMaxScoredNetPins) continue;
+                double weight = 1.0 / (p1 - p0 - 1);
+                for (int p = p0; p < p1; ++p) {
+                    int v = nl.pin_cell[p];
+                    if (v < 0 || v == u || fine.cells[v].fixed) continue;
+                    neighbours.emplace_back(v, weight);
+                }
+            }
+            std::sort(neighbours.begin(), neighbours.end());
+
+            const double area_u = static_cast<double>(cu.w) * cu.h;
+            double best_score = 0.0;
+            for (size_t i = 0; i < neighbours.size();) {
+                int v = neighbours[i].first;
+                double weight = 0.0;
+                for (; i < neighbours.size() && neighbours[i].first == v; ++i) {
+                    weight += neighbours[i].second;
+                }
+                double area = area_u + static_cast<double>(fine.cells[v].w) * fine.cells[v].h;
+                if (area > max_area) continue;
+                double score = weight / area;
+                if (score > best_score) {
+                    best_score = score;
+                    best[u] = v;
+                }
+            }
+        }
+    });
+
+    // Heavy-edge matching in index order
+    std::vector<int> partner(n, -1);
+    int pairs = 0;
+    for (int u = 0; u < n; ++u) {
+        int v = best[u];
+        if (v < 0 || partner[u] >= 0 || partner[v] >= 0) continue;
+        partner[u] = v;
+        partner[v] = u;
+        pairs++;
+    }
+    int movable = countMovable(fine);
+    if (pairs == 0 || movable - pairs > kMinReduction * movable) return false;
+
+    // Cluster cells, numbered by their first member
+    Placement& coarse = level.pl;
+    level.cluster.assign(n, -1);
+    std::vector<bool> merged;
+    for (int u = 0; u < n; ++u) {
+        if (level.cluster[u] >= 0) continue;
+        const int c = static_cast<int>(coarse.cells.size());
+        const Cell& cu = fine.cells[u];
+        level.cluster[u] = c;
+        int v = partner[u];
+        if (v < 0) {
+            coarse.cells.emplace_back(c, cu.x, cu.y, cu.w, cu.h, cu.fixed);
+            merged.push_back(false);
+            continue;
+        }
+        level.cluster[v] = c;
+
+        // Square-ish footprint of the summed area, placed at the
+        // area-weighted center of the pair
+        const Cell& cv = fine.cells[v];
+        double area_u = static_cast<double>(cu.w) * cu.h;
+        double area_v = static_cast<double>(cv.w) * cv.h;
+        int w = static_cast<int>(std::ceil(std::sqrt(area_u + area_v)));
+        w = std::min(std::max(w, std::max(cu.w, cv.w)), fine.grid.W);
+        int h = std::min(static_cast<int>(std::ceil((area_u + area_v) / w)), fine.grid.H);
+        h = std::max(h, std::max(cu.h, cv.h));
+        double cx = ((cu.x + 0.5 * cu.w) * area_u + (cv.x + 0.5 * cv.w) * area_v) / (area_u + area_v);
+        double cy = ((cu.y + 0.5 * cu.h) * area_u + (cv.y + 0.5 * cv.h) * area_v) / (area_u + area_v);
+        int x = std::max(0, std::min(static_cast<int>(std::lround(cx - 0.5 * w)), fine.grid.W - w));
+        int y = std::max(0, std::min(static_cast<int>(std::lround(cy - 0.5 * h)), fine.grid.H - h));
+        coarse.cells.emplace_back(c, x, y, w, h, false);
+        merged.push_back(true);
+    }
+
+    // Coarse nets: pins keep their offsets on unmerged cells and move to
+    // the center of merged ones, one per cluster; nets left inside a
+    // single cluster are dropped
+    std::vector<std::vector<Net>> chunk_nets(kChunks);
+    forChunks(pool, nl.numNets(), [&](int chunk, int begin, int end) {
+        struct Entry {
+            int cluster, dx, dy;
+        };
+        std::vector<Entry> entries;
+        for (int net = begin; net < end; ++net) {
+            entries.clear();
+            for (int p = nl.net_pin_start[net]; p < nl.net_pin_start[net + 1]; ++p) {
+                int u = nl.pin_cell[p];
+                if (u < 0) continue;
+                int c = level.cluster[u];
+                if (merged[c]) {
+                    entries.push_back(Entry{c, coarse.cells[c].w / 2, coarse.cells[c].h / 2});
+                } else {
+                    entries.push_back(Entry{c, nl.pin_dx[p], nl.pin_dy[p]});
+                }
+            }
+            std::stable_sort(entries.begin(), entries.end(),
+                             [](const Entry& a, const Entry& b) { return a.cluster < b.cluster; });
+            Net coarse_net;
+            int distinct = 0;
+            for (size_t i = 0; i < entries.size(); ++i) {
+                bool repeat = i > 0 && entries[i].cluster == entries[i - 1].cluster;
+                if (!repeat) distinct++;
+                if (repeat && merged[entries[i].cluster]) continue;
+                coarse_net.pins.emplace_back(entries[i].cluster, entries[i].dx, entries[i].dy);
+            }
+            if (distinct >= 2) chunk_nets[chunk].push_back(std::move(coarse_net));
+        }
+    });
+    for (auto& nets : chunk_nets) {
+        for (auto& net : nets) {
+            net.id = static_cast<int>(coarse.nets.size());
+            coarse.nets.push_back(std::move(net));
+        }
+    }
+
+    // Positions only: annealing does not need the occupancy map
+    coarse.grid.W = fine.grid.W;
+    coarse.grid.H = fine.grid.H;
+    coarse.buildIndex();
+    return true;
+}
+
+void MultilevelAnnealer::project(const Level& level, Placement& fine) {
+    ProfileScope scope("multilevel_project");
+    const Placement& coarse = level.pl;
+    std::vector<std::vector<int>> members(coarse.cells.size());
+    for (size_t u = 0; u < fine.cells.size(); ++u) {
+        members[level.cluster[u]].push_back(static_cast<int>(u));
+    }
+
+    // Members side by side, centred on the cluster
+    for (size_t c = 0; c < coarse.cells.size(); ++c) {
+        const Cell& cluster = coarse.cells[c];
+        if (members[c].size() == 1) {
+            Cell& cell = fine.cells[members[c][0]];
+            if (!cell.fixed) {
+                cell.x = cluster.x;
+                cell.y = cluster.y;
+            }
+            continue;
+        }
+        int total_w = 0;
+        for (int u : members[c]) total_w += fine.cells[u].w;
+        int x = cluster.x + (cluster.w - total_w) / 2;
+        for (int u : members[c]) {
+            Cell& cell = fine.cells[u];
+            cell.x = std::max(0, std::min(x, fine.grid.W - cell.w));
+            cell.y = std::max(0, std::min(cluster.y + (cluster.h - cell.h) / 2, fine.grid.H - cell.h));
+            x += cell.w;
+        }
+    }
+    fine.updateGrid();
+}
+
+void MultilevelAnnealer::optimize(Placement& pl, const MultilevelOptions& options) {
+    if (!pl.hasIndex()) {
+        pl.buildIndex();
+    }
+    auto start = std::chrono::steady_clock::now();
+
+    // Clusters are capped so the coarsest level still has about
+    // min_cells of them
+    double movable_area = 0.0;
+    for (const auto& cell : pl.cells) {
+        if (!cell.fixed) movable_area += static_cast<double>(cell.w) * cell.h;
+    }
+    const double max_area = movable_area / std::max(1, options.min_cells);
+
+    ThreadPool pool(options.num_threads);
+    std::vector<Level> levels;
+    levels.reserve(options.max_levels);
+    std::cout << "Multilevel annealing: level 0 has " << countMovable(pl) << " movable cells, "
+              << pl.nets.size() << " nets" << std::endl;
+    while (static_cast<int>(levels.size()) < options.max_levels) {
+        const Placement& finer = levels.empty() ? pl : levels.back().pl;
+        if (countMovable(finer) <= options.min_cells) break;
+        Level level;
+        if (!coarsen(finer, max_area, pool, level)) break;
+        levels.push_back(std::move(level));
+        std::cout << "  Level " << levels.size() << ": " << countMovable(levels.back().pl)
+                  << " movable clusters, " << levels.back().pl.nets.size() << " nets" << std::endl;
+    }
+    std::chrono::duration<double> coarsen_time = std::chrono::steady_clock::now() - start;
+    std::cout << "  Coarsening time: " << coarsen_time.count() << " s" << std::endl;
+
+    // Full anneal at the top of the hierarchy
+    const int top = static_cast<int>(levels.size());
+    Placement& coarsest = levels.empty() ? pl : levels.back().pl;
+    auto level_start = std::chrono::steady_clock::now();
+    SimulatedAnnealing sa(T0_, alpha_, lambda_overlap_, lambda_density_, density_bin_size_);
+    sa.setSeed(options.seed + static_cast<unsigned>(top));
+    sa.setVerbose(false);
+    sa.optimize(coarsest, options.coarse_epochs, 0);
+    std::chrono::duration<double> level_time = std::chrono::steady_clock::now() - level_start;
+    std::cout << "  Level " << top << " annealed: HPWL = " << CostCalculator::calculateTotalHPWL(coarsest)
+              << ", " << level_time.count() << " s" << std::endl;
+
+    // Unpack and refine, level by level
+    for (int l = top - 1; l >= 0; --l) {
+        Placement& finer = l == 0 ? pl : levels[l - 1].pl;
+        level_start = std::chrono::steady_clock::now();
+        project(levels[l], finer);
+        SimulatedAnnealing refine(options.refine_t0, alpha_, lambda_overlap_, lambda_density_,
+                                  density_bin_size_);
+        refine.setSeed(options.seed + static_cast<unsigned>(l));
+        refine.setVerbose(false);
+        refine.setRandomStart(false);
+        refine.optimize(finer, options.refine_epochs, 0);
+        level_time = std::chrono::steady_clock::now() - level_start;
+        std::cout << "  Level " << l << " refined: HPWL = " << CostCalculator::calculateTotalHPWL(finer)
+                  << ", " << level_time.count() << " s" << std::endl;
+    }
+
+    std::cout << "Final cost: "
+              << CostCalculator::calculateTotalCost(pl, lambda_overlap_, lambda_density_, density_bin_size_)
+              << std::endl;
+}
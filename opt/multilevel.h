@@ -0,0 +1,65 @@
+#ifndef MULTILEVEL_H
+#define MULTILEVEL_H
+
+#include "../model/placement.h"
+#include <vector>
+
+class ThreadPool;
+
+// Multilevel simulated annealing (coarsen / anneal / uncoarsen).
+// The netlist is coarsened by heavy-edge matching: every movable cell
+// picks the neighbour it shares the most connectivity with per unit of
+// combined area, and mutually available pairs merge into one cluster cell
+// (area summed, pins of a net on the same cluster merged into one at its
+// center). This repeats until few cells are left. The coarsest level is
+// annealed from a random placement, then each level's clusters are
+// unpacked side by side around the cluster center and refined with a
+// short low-temperature anneal, down to the original cells. Neighbour
+// scores and coarse nets are computed in parallel over fixed chunks, so
+// the hierarchy does not depend on the thread count.
+
+struct MultilevelOptions {
+    unsigned seed = 1;             // Level l anneals with seed + l
+    int num_threads = 0;           // Coarsening threads; 0 = hardware concurrency
+    int min_cells = 200;           // Stop coarsening at this many movable cells
+    int max_levels = 10;
+    int coarse_epochs = 100;       // Full anneal of the coarsest level
+    int refine_epochs = 20;        // Short anneal of every finer level
+    double refine_t0 = 10.0;       // Starting temperature of the refinement
+};
+
+class MultilevelAnnealer {
+public:
+    MultilevelAnnealer(double T0 = 1000.0, double alpha = 0.90,
+                       double lambda_overlap = 1.0, double lambda_density = 0.1,
+                       int density_bin_size = 0)
+        : T0_(T0), alpha_(alpha), lambda_overlap_(lambda_overlap),
+          lambda_density_(lambda_density), density_bin_size_(density_bin_size) {}
+
+    // Anneal `pl` through the cluster hierarchy; positions are updated in
+    // place and the grid rebuilt
+    void optimize(Placement& pl, const MultilevelOptions& options);
+
+private:
+    // One coarsening step: the clustered placement plus, for every cell of
+    // the finer level, the index of its cluster
+    struct Level {
+        Placement pl;
+        std::vector<int> cluster;
+    };
+
+    // Cluster `fine` with clusters of at most `max_area`; returns false
+    // when matching removed too few cells to be worth another level
+    static bool coarsen(const Placement& fine, double max_area, ThreadPool& pool, Level& level);
+
+    // Place the finer level's cells from their clusters' positions
+    static void project(const Level& level, Placement& fine);
+
+    double T0_;
+    double alpha_;
+    double lambda_overlap_;
+    double lambda_density_;
+    int density_bin_size_;
+};
+
+#endif // MULTILEVEL_H
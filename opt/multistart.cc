@@ -0,0 +1,129 @@
+#include "multistart.h"
+#include "../cost/incremental_cost.h"
+#include "../util/thread_pool.h"
+#include <algorithm>
+#include <iostream>
+#include <memory>
+
+namespace {
+
+// State of one annealing chain
+struct Chain {
+    Placement pl;
+    SimulatedAnnealing sa;
+    std::unique_ptr<IncrementalCost> cost;
+    std::vector<double> history;
+    bool stalled = false;
+    int epochs_run = 0;
+    int restarts = 0;
+
+    Chain(const Placement& base, const SimulatedAnnealing& proto)
+        : pl(base.copyWithoutOccupancy()), sa(proto) {}
+};
+
+}  // namespace
+
+std::vector<unsigned> MultiStartAnnealer::makeSeeds(unsigned base, int count) {
+    std::vector<unsigned> seeds;
+    for (int i = 0; i < count; ++i) {
+        seeds.push_back(base + static_cast<unsigned>(i));
+    }
+    return seeds;
+}
+
+void MultiStartAnnealer::optimize(Placement& pl, const MultiStartOptions& options) {
+    std::vector<unsigned> seeds = options.seeds;
+    if (seeds.empty()) {
+        seeds.push_back(1);
+    }
+    if (!pl.hasIndex()) {
+        pl.buildIndex();
+    }
+
+    const int num_chains = static_cast<int>(seeds.size());
+    const int moves_per_epoch = options.moves_per_epoch > 0
+        ? options.moves_per_epoch : SimulatedAnnealing::defaultMovesPerEpoch(pl);
+    int num_threads = options.num_threads > 0 ? options.num_threads : ThreadPool::defaultThreads();
+    ThreadPool pool(std::min(num_threads, num_chains));
+
+    std::cout << "Multi-start annealing: " << num_chains << " chains on "
+              << pool.size() << " threads" << std::endl;
+
+    // Each chain starts from its own seeded random placement
+    std::vector<std::unique_ptr<Chain>> chains(num_chains);
+    SimulatedAnnealing proto(T0_, alpha_, lambda_overlap_, lambda_density_, density_bin_size_);
+    proto.setVerbose(false);
+    pool.parallelFor(num_chains, [&](int i) {
+        auto chain = std::make_unique<Chain>(pl, proto);
+        chain->sa.setSeed(seeds[i]);
+        chain->sa.setTemperature(T0_);
+        chain->sa.randomInitialPlacement(chain->pl);
+        chain->sa.prepare(chain->pl);
+        chain->cost = std::make_unique<IncrementalCost>(chain->pl, lambda_overlap_,
+                                                        lambda_density_, density_bin_size_);
+        chain->history.push_back(chain->cost->totalCost());
+        chains[i] = std::move(chain);
+    });
+
+    auto best_chain = [&]() {
+        int best = 0;
+        for (int i = 1; i < num_chains; ++i) {
+            if (chains[i]->cost->totalCost() < chains[best]->cost->totalCost()) best = i;
+        }
+        return best;
+    };
+
+    const int block = options.restart_interval > 0 ? options.restart_interval : options.max_epochs;
+    for (int done = 0; done < options.max_epochs; done += block) {
+        const int epochs = std::min(block, options.max_epochs - done);
+
+        // Chains are independent between epoch boundaries
+        pool.parallelFor(num_chains, [&](int i) {
+            Chain& c = *chains[i];
+            for (int e = 0; e < epochs && !c.stalled; ++e) {
+                c.sa.sweep(c.pl, *c.cost, moves_per_epoch, c.sa.getTemperature());
+                c.history.push_back(c.cost->totalCost());
+                c.sa.cool();
+                c.epochs_run++;
+                c.stalled = SimulatedAnnealing::hasStalled(c.history);
+            }
+        });
+
+        int best = best_chain();
+        double best_cost = chains[best]->cost->totalCost();
+        std::cout << "Epoch " << done + epochs - 1 << ": best cost = " << best_cost
+                  << " (chain " << best << ", seed " << seeds[best] << ")" << std::endl;
+
+        bool all_stalled = std::all_of(chains.begin(), chains.end(),
+                                       [](const std::unique_ptr<Chain>& c) { return c->stalled; });
+        if (all_stalled) {
+            std::cout << "All chains converged" << std::endl;
+            break;
+        }
+
+        // Restart weak chains from the current best
+        if (options.restart_interval > 0 && done + epochs < options.max_epochs) {
+            for (int i = 0; i < num_chains; ++i) {
+                Chain& c = *chains[i];
+                if (i == best || c.cost->totalCost() <= best_cost * options.restart_ratio) continue;
+                c.pl.cells = chains[best]->pl.cells;
+                c.cost->rebuild();
+                c.history.assign(1, c.cost->totalCost());
+                c.stalled = false;
+                c.restarts++;
+            }
+        }
+    }
+
+    for (int i = 0; i < num_chains; ++i) {
+        const Chain& c = *chains[i];
+        std::cout << "  Chain " << i << " (seed " << seeds[i] << "): cost = "
+                  << c.cost->totalCost() << ", epochs = " << c.epochs_run
+                  << ", restarts = " << c.restarts << std::endl;
+    }
+
+    int best = best_chain();
+    pl.cells = chains[best]->pl.cells;
+    pl.updateGrid();
+    std::cout << "Final cost: " << chains[best]->cost->totalCost() << std::endl;
+}
@@ -0,0 +1,47 @@
+#ifndef MULTISTART_H
+#define MULTISTART_H
+
+#include "anneal.h"
+#include "../model/placement.h"
+#include <vector>
+
+// Parallel multi-start simulated annealing.
+// Runs one independent annealing chain per seed on a thread pool, each on
+// its own copy of the placement, and keeps the best result. Optionally,
+// at every restart interval the chains whose cost is well above the current
+// best continue from a copy of the best placement. Chains only interact at
+// those epoch boundaries and ties break on chain order, so a given seed list
+// gives identical results for any thread count.
+
+struct MultiStartOptions {
+    std::vector<unsigned> seeds;   // One chain per seed
+    int num_threads = 0;           // 0 = hardware concurrency
+    int max_epochs = 100;
+    int moves_per_epoch = 0;       // 0 = SimulatedAnnealing default
+    int restart_interval = 0;      // Epochs between restarts (0 = never)
+    double restart_ratio = 1.05;   // Restart chains with cost > best * ratio
+};
+
+class MultiStartAnnealer {
+public:
+    MultiStartAnnealer(double T0 = 1000.0, double alpha = 0.90,
+                       double lambda_overlap = 1.0, double lambda_density = 0.1,
+                       int density_bin_size = 0)
+        : T0_(T0), alpha_(alpha), lambda_overlap_(lambda_overlap),
+          lambda_density_(lambda_density), density_bin_size_(density_bin_size) {}
+
+    // Anneal from random initial placements; `pl` receives the best chain
+    void optimize(Placement& pl, const MultiStartOptions& options);
+
+    // Seeds base, base + 1, ..., base + count - 1
+    static std::vector<unsigned> makeSeeds(unsigned base, int count);
+
+private:
+    double T0_;
+    double alpha_;
+    double lambda_overlap_;
+    double lambda_density_;
+    int density_bin_size_;
+};
+
+#endif // MULTISTART_H
@@ -0,0 +1,315 @@
+#include "partition_anneal.h"
+#include "../cost/cost.h"
+#include "../cost/density_map.h"
+#include "../cost/incremental_cost.h"
+#include "../util/thread_pool.h"
+#include <algorithm>
+#include <iostream>
+
+namespace {
+
+// Upper bound on stripes chosen automatically
+const int kMaxAutoRegions = 16;
+
+// Default stripe count: stripes at least 8 average cells wide
+int autoRegions(const Placement& pl) {
+    long long dim_sum = 0;
+    int movable = 0;
+    for (const auto& cell : pl.cells) {
+        if (cell.fixed) continue;
+        dim_sum += std::max(cell.w, cell.h);
+        movable++;
+    }
+    if (movable == 0) return 1;
+    int avg_dim = std::max(1, static_cast<int>(dim_sum / movable));
+    int regions = std::min(pl.grid.W, pl.grid.H) / (8 * avg_dim);
+    return std::max(1, std::min(kMaxAutoRegions, regions));
+}
+
+unsigned regionSeed(unsigned seed, int phase, int region) {
+    return seed * 0x9e3779b1u + static_cast<unsigned>(phase) * 0x85ebca77u +
+           static_cast<unsigned>(region) * 0xc2b2ae3du;
+}
+
+// One stripe of a phase. Kept across phases so its buffers are reused.
+struct Stripe {
+    std::vector<int> own;       // Movable cells entirely inside the stripe
+    std::vector<int> reaching;  // Other cells that intersect the stripe
+    Placement sub;              // Own cells first, then fixed context copies
+    std::vector<int> global;    // Sub-placement cell -> placement cell
+    std::vector<int> nets;      // Sub-placement net -> placement net
+    std::vector<int> shared;    // Sub-placement nets with other stripes' cells
+    std::vector<long long> shared_hpwl;  // Their HPWL at the start of the phase
+    int accepted = 0;
+    double hpwl_delta = 0.0;
+    double overlap_delta = 0.0;
+    DensityMap density;         // Density bins after the stripe's moves
+};
+
+// Per-thread placement -> sub-placement index maps. Entries are -1 except
+// while a sub-placement is being built, and are reset one by one after it.
+struct StripeScratch {
+    std::vector<int> local_cell;
+    std::vector<int> local_net;
+};
+
+StripeScratch& stripeScratch(int num_cells, int num_nets) {
+    thread_local StripeScratch scratch;
+    if (static_cast<int>(scratch.local_cell.size()) < num_cells) scratch.local_cell.resize(num_cells, -1);
+    if (static_cast<int>(scratch.local_net.size()) < num_nets) scratch.local_net.resize(num_nets, -1);
+    return scratch;
+}
+
+// Fill the stripe's sub-placement: its own cells, fixed copies of the
+// cells reaching into it and of the other cells on its nets, and the CSR
+// netlist of those nets over the sub-placement's indices. Annealing only
+// reads the CSR netlist, so sub.nets are placeholders and the id map is
+// left empty. Nets that also have cells of other stripes (by `owner`) are
+// listed in s.shared.
+void buildSub(const Placement& pl, const std::vector<int>& owner, int r, Stripe& s) {
+    const Netlist& nl = pl.netlist;
+    StripeScratch& scratch = stripeScratch(static_cast<int>(pl.cells.size()), nl.numNets());
+    std::vector<int>& local = scratch.local_cell;
+    std::vector<int>& local_net = scratch.local_net;
+
+    Placement& sub = s.sub;
+    sub.grid.W = pl.grid.W;
+    sub.grid.H = pl.grid.H;
+    sub.cells.clear();
+    s.global.clear();
+    s.nets.clear();
+    s.shared.clear();
+    auto add = [&](int i, bool fixed) {
+        if (local[i] >= 0) return;
+        local[i] = static_cast<int>(sub.cells.size());
+        sub.cells.push_back(pl.cells[i]);
+        if (fixed) sub.cells.back().fixed = true;
+        s.global.push_back(i);
+    };
+    for (int i : s.own) add(i, false);
+    for (int i : s.reaching) add(i, true);
+    for (int i : s.own) {
+        for (int k = nl.cell_net_start[i]; k < nl.cell_net_start[i + 1]; ++k) {
+            int net = nl.cell_nets[k];
+            if (local_net[net] >= 0) continue;
+            local_net[net] = static_cast<int>(s.nets.size());
+            bool shared = false;
+            for (int p = nl.net_pin_start[net]; p < nl.net_pin_start[net + 1]; ++p) {
+                int c = nl.pin_cell[p];
+                if (c < 0) continue;
+                add(c, true);
+                shared = shared || (owner[c] >= 0 && owner[c] != r);
+            }
+            if (shared) s.shared.push_back(static_cast<int>(s.nets.size()));
+            s.nets.push_back(net);
+        }
+    }
+
+    Netlist& snl = sub.netlist;
+    snl.net_pin_start.assign(1, 0);
+    snl.pin_cell.clear();
+    snl.pin_dx.clear();
+    snl.pin_dy.clear();
+    snl.pin_net.clear();
+    for (size_t n = 0; n < s.nets.size(); ++n) {
+        const int net = s.nets[n];
+        for (int p = nl.net_pin_start[net]; p < nl.net_pin_start[net + 1]; ++p) {
+            snl.pin_cell.push_back(nl.pin_cell[p] >= 0 ? local[nl.pin_cell[p]] : -1);
+            snl.pin_dx.push_back(nl.pin_dx[p]);
+            snl.pin_dy.push_back(nl.pin_dy[p]);
+            snl.pin_net.push_back(static_cast<int>(n));
+        }
+        snl.net_pin_start.push_back(static_cast<int>(snl.pin_cell.size()));
+    }
+    snl.buildAdjacency(static_cast<int>(sub.cells.size()));
+    sub.nets.resize(s.nets.size());
+
+    for (int i : s.global) local[i] = -1;
+    for (int net : s.nets) local_net[net] = -1;
+}
+
+}  // namespace
+
+std::vector<int> PartitionedAnnealer::stripeBounds(int extent, int num_regions, int phase) {
+    num_regions = std::max(1, std::min(num_regions, extent));
+    int stripe = extent / num_regions;
+    // Every other pair of phases shifts the boundaries by half a stripe
+    int offset = ((phase / 2) % 2 == 1) ? stripe / 2 : 0;
+
+    std::vector<int> bounds;
+    bounds.push_back(0);
+    for (int k = 1; k < num_regions; ++k) {
+        bounds.push_back(k * stripe - offset);
+    }
+    bounds.push_back(extent);
+    return bounds;
+}
+
+void PartitionedAnnealer::optimize(Placement& pl, const PartitionOptions& options) {
+    if (!pl.hasIndex()) {
+        pl.buildIndex();
+    }
+
+    SimulatedAnnealing proto(T0_, alpha_, lambda_overlap_, lambda_density_, density_bin_size_);
+    proto.setVerbose(false);
+    proto.setSeed(options.seed);
+    proto.randomInitialPlacement(pl);
+
+    const int num_cells = static_cast<int>(pl.cells.size());
+    const int num_regions = options.num_regions > 0 ? options.num_regions : autoRegions(pl);
+    const int moves_per_epoch = options.moves_per_epoch > 0
+        ? options.moves_per_epoch : SimulatedAnnealing::defaultMovesPerEpoch(pl);
+    int num_threads = options.num_threads > 0 ? options.num_threads : ThreadPool::defaultThreads();
+    ThreadPool pool(std::min(num_threads, num_regions));
+
+    std::cout << "Partitioned annealing: " << num_regions << " stripes on "
+              << pool.size() << " threads" << std::endl;
+
+    // The cost is tracked from the stripes' deltas rather than recomputed
+    CostBreakdown start = CostCalculator::calculateCostBreakdown(pl, lambda_overlap_, lambda_density_,
+                                                                 density_bin_size_);
+    double hpwl = start.hpwl;
+    double overlap = start.overlap;
+    DensityMap density;
+    density.build(pl, density_bin_size_, density_bin_size_);
+    auto total_cost = [&]() {
+        return hpwl + lambda_overlap_ * overlap + lambda_density_ * density.variance();
+    };
+
+    std::vector<double> cost_history;
+    double current_cost = total_cost();
+    cost_history.push_back(current_cost);
+    std::cout << "Initial cost: " << current_cost << std::endl;
+
+    double T = T0_;
+    std::vector<Stripe> stripes(num_regions);
+    std::vector<int> owner(num_cells);
+
+    for (int epoch = 0; epoch < options.max_epochs; ++epoch) {
+        const bool vertical = (epoch % 2 == 0);
+        const int extent = vertical ? pl.grid.W : pl.grid.H;
+        const std::vector<int> bounds = stripeBounds(extent, num_regions, epoch);
+        const int regions = static_cast<int>(bounds.size()) - 1;
+
+        // One pass over the cells: movable cells entirely inside a stripe
+        // belong to it, every other cell is context for the stripes it
+        // intersects
+        int assigned = 0;
+        for (auto& s : stripes) {
+            s.own.clear();
+            s.reaching.clear();
+        }
+        for (int i = 0; i < num_cells; ++i) {
+            const Cell& cell = pl.cells[i];
+            owner[i] = -1;
+            int lo = vertical ? cell.x : cell.y;
+            int hi = lo + (vertical ? cell.w : cell.h);
+            if (hi <= 0 || lo >= extent) continue;
+            int r0 = static_cast<int>(std::upper_bound(bounds.begin(), bounds.end(), lo) - bounds.begin()) - 1;
+            int r1 = static_cast<int>(std::lower_bound(bounds.begin(), bounds.end(), hi) - bounds.begin()) - 1;
+            r0 = std::max(0, r0);
+            r1 = std::min(regions - 1, r1);
+            if (!cell.fixed && r0 == r1 && lo >= 0 && hi <= extent) {
+                stripes[r0].own.push_back(i);
+                owner[i] = r0;
+                assigned++;
+                continue;
+            }
+            for (int r = r0; r <= r1; ++r) stripes[r].reaching.push_back(i);
+        }
+
+        // Stripes only read pl.cells here; results are written back after
+        // all of them are done
+        pool.parallelFor(regions, [&](int r) {
+            Stripe& s = stripes[r];
+            s.accepted = 0;
+            s.hpwl_delta = 0.0;
+            s.overlap_delta = 0.0;
+            if (s.own.empty()) return;
+            buildSub(pl, owner, r, s);
+
+            SimulatedAnnealing sa(proto);
+            sa.setSeed(regionSeed(options.seed, epoch, r));
+            if (vertical) {
+                sa.setBounds(bounds[r], 0, bounds[r + 1], pl.grid.H);
+            } else {
+                sa.setBounds(0, bounds[r], pl.grid.W, bounds[r + 1]);
+            }
+            sa.prepare(s.sub);
+            IncrementalCost cost(s.sub, lambda_overlap_, lambda_density_, density_bin_size_);
+            cost.setDensityMap(density);
+            const double hpwl_before = cost.hpwl();
+            const double overlap_before = cost.overlap();
+            s.shared_hpwl.clear();
+            for (int n : s.shared) s.shared_hpwl.push_back(CostCalculator::calculateNetHPWL(s.sub, n));
+
+            // Moves are shared out in proportion to the stripe's cells
+            int moves = static_cast<int>(static_cast<long long>(moves_per_epoch) * s.own.size() / num_cells);
+            s.accepted = sa.sweep(s.sub, cost, std::max(1, moves), T);
+            s.overlap_delta = cost.overlap() - overlap_before;
+            s.density = cost.densityMap();
+
+            // The stripe's HPWL delta is exact for the nets only it moves;
+            // shared nets are scored below, once every stripe is written back
+            s.hpwl_delta = cost.hpwl() - hpwl_before;
+            for (size_t k = 0; k < s.shared.size(); ++k) {
+                s.hpwl_delta -= CostCalculator::calculateNetHPWL(s.sub, s.shared[k]) - s.shared_hpwl[k];
+            }
+        });
+        pool.parallelFor(regions, [&](int r) {
+            const Stripe& s = stripes[r];
+            for (size_t k = 0; k < s.own.size(); ++k) {
+                pl.cells[s.own[k]].x = s.sub.cells[k].x;
+                pl.cells[s.own[k]].y = s.sub.cells[k].y;
+            }
+        });
+
+        // A shared net is scored by the first stripe that has cells on it
+        pool.parallelFor(regions, [&](int r) {
+            Stripe& s = stripes[r];
+            const Netlist& nl = pl.netlist;
+            for (size_t k = 0; k < s.shared.size(); ++k) {
+                const int net = s.nets[s.shared[k]];
+                int first = r;
+                for (int p = nl.net_pin_start[net]; p < nl.net_pin_start[net + 1]; ++p) {
+                    int c = nl.pin_cell[p];
+                    if (c >= 0 && owner[c] >= 0) first = std::min(first, owner[c]);
+                }
+                if (first == r) s.hpwl_delta += CostCalculator::calculateNetHPWL(pl, net) - s.shared_hpwl[k];
+            }
+        });
+
+        int accepted_moves = 0;
+        const DensityMap before = density;
+        for (int r = 0; r < regions; ++r) {
+            const Stripe& s = stripes[r];
+            accepted_moves += s.accepted;
+            if (s.own.empty()) continue;
+            hpwl += s.hpwl_delta;
+            overlap += s.overlap_delta;
+            density.addChange(before, s.density);
+        }
+        current_cost = total_cost();
+        cost_history.push_back(current_cost);
+
+        // Cool down
+        T *= alpha_;
+
+        if (epoch % 10 == 0 || epoch == options.max_epochs - 1) {
+            std::cout << "Epoch " << epoch << ": cost = " << current_cost
+                      << ", T = " << T << ", accepted = " << accepted_moves
+                      << "/" << moves_per_epoch << ", cells in stripes = "
+                      << assigned << std::endl;
+        }
+
+        if (SimulatedAnnealing::hasStalled(cost_history)) {
+            std::cout << "Converged at epoch " << epoch << std::endl;
+            break;
+        }
+    }
+
+    pl.updateGrid();
+    std::cout << "Final cost: "
+              << CostCalculator::calculateTotalCost(pl, lambda_overlap_, lambda_density_, density_bin_size_)
+              << std::endl;
+}
@@ -0,0 +1,57 @@
+#ifndef PARTITION_ANNEAL_H
+#define PARTITION_ANNEAL_H
+
+#include "anneal.h"
+#include "../model/placement.h"
+#include <vector>
+
+// Spatially partitioned parallel annealing of a single placement.
+// Each epoch (phase) splits the grid into stripes and anneals every stripe's
+// movable cells on its own thread, with moves bounded to the stripe. One
+// pass over the cells per phase sorts them into stripes: movable cells
+// entirely inside a stripe belong to it, and every other cell is context
+// for the stripes it intersects. A stripe is annealed on a sub-placement
+// holding its own cells plus fixed copies of its context cells and of the
+// cells on the same nets; its density bins start from the whole
+// placement's map. Stripes read the placement as it was at the start of
+// the phase and are written back once all are done, so only nets that
+// cross a stripe boundary see stale positions for the other stripes'
+// cells. The phase's cost follows from the stripes' deltas: overlap and
+// density changes are merged exactly, and nets shared by stripes are
+// re-scored once after the write-back. Stripes alternate between vertical
+// and horizontal and shift by half a stripe every other phase, so cells
+// can migrate. Cells straddling a boundary stay put for that phase. Stripe
+// seeds derive from the base seed, the phase and the stripe, so results do
+// not depend on the thread count.
+
+struct PartitionOptions {
+    unsigned seed = 1;
+    int num_regions = 0;           // Stripes per phase; 0 = choose from grid and cell size
+    int num_threads = 0;           // 0 = hardware concurrency
+    int max_epochs = 100;
+    int moves_per_epoch = 0;       // Total over all stripes; 0 = SimulatedAnnealing default
+};
+
+class PartitionedAnnealer {
+public:
+    PartitionedAnnealer(double T0 = 1000.0, double alpha = 0.90,
+                        double lambda_overlap = 1.0, double lambda_density = 0.1,
+                        int density_bin_size = 0)
+        : T0_(T0), alpha_(alpha), lambda_overlap_(lambda_overlap),
+          lambda_density_(lambda_density), density_bin_size_(density_bin_size) {}
+
+    // Anneal from a random initial placement, in place
+    void optimize(Placement& pl, const PartitionOptions& options);
+
+    // Stripe boundaries [b_0 = 0, ..., b_n = extent] for a phase
+    static std::vector<int> stripeBounds(int extent, int num_regions, int phase);
+
+private:
+    double T0_;
+    double alpha_;
+    double lambda_overlap_;
+    double lambda_density_;
+    int density_bin_size_;
+};
+
+#endif // PARTITION_ANNEAL_H
@@ -0,0 +1,185 @@
+#include "tempering.h"
+#include "../cost/incremental_cost.h"
+#include "../util/thread_pool.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <memory>
+#include <random>
+
+namespace {
+
+// One replica: a placement with its own move generator and cost engine
+struct Replica {
+    Placement pl;
+    SimulatedAnnealing sa;
+    std::unique_ptr<IncrementalCost> cost;
+    int accepted = 0;
+
+    Replica(const Placement& base, const SimulatedAnnealing& proto)
+        : pl(base.copyWithoutOccupancy()), sa(proto) {}
+};
+
+}  // namespace
+
+std::vector<double> ParallelTempering::temperatureLadder(double t_max, double t_min, int count) {
+    std::vector<double> ladder;
+    if (count <= 1) {
+        ladder.push_back(t_max);
+        return ladder;
+    }
+    double ratio = std::pow(t_min / t_max, 1.0 / (count - 1));
+    double T = t_max;
+    for (int i = 0; i < count; ++i) {
+        ladder.push_back(T);
+        T *= ratio;
+    }
+    return ladder;
+}
+
+void ParallelTempering::optimize(Placement& pl, const TemperingOptions& options) {
+    if (!pl.hasIndex()) {
+        pl.buildIndex();
+    }
+
+    const int num_replicas = std::max(1, options.num_replicas);
+    const int moves_per_round = options.moves_per_round > 0
+        ? options.moves_per_round : SimulatedAnnealing::defaultMovesPerEpoch(pl);
+
+    int num_threads = options.num_threads > 0 ? options.num_threads : ThreadPool::defaultThreads();
+    ThreadPool pool(std::min(num_threads, num_replicas));
+
+    std::vector<std::unique_ptr<Replica>> replicas(num_replicas);
+    SimulatedAnnealing proto(T0_, alpha_, lambda_overlap_, lambda_density_, density_bin_size_);
+    proto.setVerbose(false);
+    pool.parallelFor(num_replicas, [&](int r) {
+        auto replica = std::make_unique<Replica>(pl, proto);
+        replica->sa.setSeed(options.seed + static_cast<unsigned>(r));
+        replica->sa.randomInitialPlacement(replica->pl);
+        replica->sa.prepare(replica->pl);
+        replica->cost = std::make_unique<IncrementalCost>(replica->pl, lambda_overlap_,
+                                                          lambda_density_, density_bin_size_);
+        replicas[r] = std::move(replica);
+    });
+
+    // Ladder ends from the design's cost scale, measured on replica 0 as
+    // the adaptive schedule does: the hot end accepts most sampled uphill
+    // moves, the cold end is where the adaptive schedule would stop
+    const AdaptiveOptions adaptive;
+    double t_max = options.t_max;
+    if (t_max <= 0.0) {
+        Replica& rep = *replicas[0];
+        const int samples = std::max(100, std::min(static_cast<int>(rep.pl.cells.size()), 10000));
+        t_max = rep.sa.sampleTemperature(rep.pl, *rep.cost, samples, adaptive.initial_acceptance);
+        if (t_max <= 0.0) t_max = T0_;
+    }
+    double t_min = options.t_min;
+    if (t_min <= 0.0) {
+        const double num_nets = std::max<double>(1.0, static_cast<double>(pl.nets.size()));
+        t_min = std::min(t_max, adaptive.exit_ratio * replicas[0]->cost->totalCost() / num_nets);
+    }
+    const std::vector<double> ladder = temperatureLadder(t_max, t_min, num_replicas);
+
+    std::cout << "Parallel tempering: " << num_replicas << " replicas on "
+              << pool.size() << " threads, T = " << ladder.front()
+              << " .. " << ladder.back() << std::endl;
+
+    // at_temp[k] = replica currently running at ladder[k]
+    std::vector<int> at_temp(num_replicas);
+    for (int k = 0; k < num_replicas; ++k) at_temp[k] = k;
+
+    // Move window of each temperature, held near the target acceptance by
+    // the adaptive schedule's range limiter; it stays with the temperature
+    // when replicas are exchanged
+    const double max_window = std::max(1, std::max(pl.grid.W, pl.grid.H));
+    std::vector<double> window(num_replicas, max_window);
+
+    std::vector<int> swap_attempts(std::max(0, num_replicas - 1), 0);
+    std::vector<int> swap_accepts(std::max(0, num_replicas - 1), 0);
+    std::mt19937 exchange_rng(options.seed ^ 0x9e3779b9u);
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+
+    // Best placement seen so far
+    std::vector<Cell> best_cells;
+    double best_cost = 0.0;
+    auto track_best = [&]() {
+        int best = 0;
+        for (int r = 1; r < num_replicas; ++r) {
+            if (replicas[r]->cost->totalCost() < replicas[best]->cost->totalCost()) best = r;
+        }
+        double c = replicas[best]->cost->totalCost();
+        if (best_cells.empty() || c < best_cost) {
+            best_cost = c;
+            best_cells = replicas[best]->pl.cells;
+        }
+    };
+    track_best();
+    std::cout << "Initial best cost: " << best_cost << std::endl;
+
+    std::vector<double> cost_history;
+    cost_history.push_back(best_cost);
+
+    for (int round = 0; round < options.rounds; ++round) {
+        // Replicas are independent within a round
+        pool.parallelFor(num_replicas, [&](int k) {
+            Replica& rep = *replicas[at_temp[k]];
+            rep.sa.setWindow(window[k]);
+            rep.accepted = rep.sa.sweep(rep.pl, *rep.cost, moves_per_round, ladder[k]);
+        });
+        for (int k = 0; k < num_replicas; ++k) {
+            double acceptance = static_cast<double>(replicas[at_temp[k]]->accepted) / moves_per_round;
+            window[k] *= 1.0 - adaptive.target_acceptance + acceptance;
+            window[k] = std::max(1.0, std::min(window[k], max_window));
+        }
+
+        // Exchange neighbouring temperatures (even pairs, then odd pairs)
+        for (int k = round % 2; k + 1 < num_replicas; k += 2) {
+            double e_hot = replicas[at_temp[k]]->cost->totalCost();
+            double e_cold = replicas[at_temp[k + 1]]->cost->totalCost();
+            double exponent = (1.0 / ladder[k] - 1.0 / ladder[k + 1]) * (e_hot - e_cold);
+            swap_attempts[k]++;
+            if (exponent >= 0.0 || uniform(exchange_rng) < std::exp(exponent)) {
+                std::swap(at_temp[k], at_temp[k + 1]);
+                swap_accepts[k]++;
+            }
+        }
+
+        track_best();
+        cost_history.push_back(best_cost);
+
+        if (round % 10 == 0 || round == options.rounds - 1) {
+            const Replica& cold = *replicas[at_temp[num_replicas - 1]];
+            std::cout << "Round " << round << ": best cost = " << best_cost
+                      << ", coldest = " << cold.cost->totalCost()
+                      << ", accepted = " << cold.accepted << "/" << moves_per_round << std::endl;
+        }
+
+        if (SimulatedAnnealing::hasStalled(cost_history)) {
+            std::cout << "Converged at round " << round << std::endl;
+            break;
+        }
+    }
+
+    // Greedy quench of the coldest replica, as at the end of the adaptive
+    // schedule
+    {
+        Replica& cold = *replicas[at_temp[num_replicas - 1]];
+        cold.sa.setWindow(window[num_replicas - 1]);
+        cold.sa.sweep(cold.pl, *cold.cost, moves_per_round, 0.0);
+        track_best();
+        std::cout << "Quench: coldest = " << cold.cost->totalCost() << std::endl;
+    }
+
+    // Swap acceptance per neighbouring pair
+    for (int k = 0; k + 1 < num_replicas; ++k) {
+        double rate = swap_attempts[k] > 0
+            ? 100.0 * swap_accepts[k] / swap_attempts[k] : 0.0;
+        std::cout << "  T " << ladder[k] << " <-> " << ladder[k + 1] << ": "
+                  << swap_accepts[k] << "/" << swap_attempts[k] << " swaps ("
+                  << rate << "%)" << std::endl;
+    }
+
+    pl.cells = best_cells;
+    pl.updateGrid();
+    std::cout << "Final cost: " << best_cost << std::endl;
+}
@@ -0,0 +1,55 @@
+#ifndef TEMPERING_H
+#define TEMPERING_H
+
+#include "anneal.h"
+#include "../model/placement.h"
+#include <vector>
+
+// Parallel tempering (replica exchange) optimizer.
+// Runs K replicas at a geometric ladder of fixed temperatures, one sweep per
+// replica per round on a thread pool. By default the ladder spans the
+// design's cost scale: the hot end is the adaptive schedule's sampled T0
+// and the cold end its exit temperature at the starting cost. Every
+// temperature keeps its own move window, adjusted by the range limiter of
+// the adaptive schedule. After each round, neighbouring temperatures
+// exchange their replicas with the Metropolis criterion
+// min(1, exp((1/T_i - 1/T_j) * (E_i - E_j))); even and odd pairs alternate
+// between rounds. Exchanges only permute which replica runs at which
+// temperature, so no placement is copied. The coldest replica ends with a
+// greedy quench, and the best placement seen by any replica is kept.
+// Replica and exchange seeds derive from one base seed, so results do not
+// depend on the thread count.
+
+struct TemperingOptions {
+    unsigned seed = 1;             // Replica r uses seed + r; exchanges use their own stream
+    int num_replicas = 8;
+    int num_threads = 0;           // 0 = hardware concurrency
+    int rounds = 100;
+    int moves_per_round = 0;       // Per replica; 0 = SimulatedAnnealing default
+    double t_max = 0.0;            // 0 = from sampled uphill moves
+    double t_min = 0.0;            // 0 = adaptive exit temperature
+};
+
+class ParallelTempering {
+public:
+    ParallelTempering(double T0 = 1000.0, double alpha = 0.90,
+                      double lambda_overlap = 1.0, double lambda_density = 0.1,
+                      int density_bin_size = 0)
+        : T0_(T0), alpha_(alpha), lambda_overlap_(lambda_overlap),
+          lambda_density_(lambda_density), density_bin_size_(density_bin_size) {}
+
+    // Optimize from random initial placements; `pl` receives the best one
+    void optimize(Placement& pl, const TemperingOptions& options);
+
+    // Geometric ladder from t_max down to t_min (index 0 is the hottest)
+    static std::vector<double> temperatureLadder(double t_max, double t_min, int count);
+
+private:
+    double T0_;
+    double alpha_;
+    double lambda_overlap_;
+    double lambda_density_;
+    int density_bin_size_;
+};
+
+#endif // TEMPERING_H
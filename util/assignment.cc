@@ -0,0 +1,65 @@
+#include "assignment.h"
+#include <cstddef>
+#include <limits>
+
+double AssignmentSolver::solve(const std::vector<double>& cost, int n, std::vector<int>& assign) {
+    assign.assign(n, -1);
+    if (n <= 0) return 0.0;
+
+    const double inf = std::numeric_limits<double>::infinity();
+
+    // 1-based: column 0 is a virtual column holding the row being added
+    std::vector<double> u(n + 1, 0.0), v(n + 1, 0.0);
+    std::vector<int> row_of(n + 1, 0);   // Row matched to each column
+    std::vector<int> way(n + 1, 0);      // Previous column on the augmenting path
+
+    for (int i = 1; i <= n; ++i) {
+        row_of[0] = i;
+        int j0 = 0;
+        std::vector<double> min_v(n + 1, inf);
+        std::vector<char> used(n + 1, 0);
+
+        // Grow a shortest augmenting path until it reaches a free column
+        do {
+            used[j0] = 1;
+            int i0 = row_of[j0];
+            double delta = inf;
+            int j1 = 0;
+            for (int j = 1; j <= n; ++j) {
+                if (used[j]) continue;
+                double cur = cost[static_cast<size_t>(i0 - 1) * n + (j - 1)] - u[i0] - v[j];
+                if (cur < min_v[j]) {
+                    min_v[j] = cur;
+                    way[j] = j0;
+                }
+                if (min_v[j] < delta) {
+                    delta = min_v[j];
+                    j1 = j;
+                }
+            }
+            for (int j = 0; j <= n; ++j) {
+                if (used[j]) {
+                    u[row_of[j]] += delta;
+                    v[j] -= delta;
+                } else {
+                    min_v[j] -= delta;
+                }
+            }
+            j0 = j1;
+        } while (row_of[j0] != 0);
+
+        // Flip the matching along the path
+        do {
+            int j1 = way[j0];
+            row_of[j0] = row_of[j1];
+            j0 = j1;
+        } while (j0 != 0);
+    }
+
+    double total = 0.0;
+    for (int j = 1; j <= n; ++j) {
+        assign[row_of[j] - 1] = j - 1;
+        total += cost[static_cast<size_t>(row_of[j] - 1) * n + (j - 1)];
+    }
+    return total;
+}
@@ -0,0 +1,17 @@
+#ifndef ASSIGNMENT_H
+#define ASSIGNMENT_H
+
+#include <vector>
+
+// Minimum-cost assignment (Hungarian algorithm with potentials, O(n^3)).
+// Used by independent-set matching to place n cells on n slots.
+
+class AssignmentSolver {
+public:
+    // cost is an n x n row-major matrix: cost[i * n + j] is the cost of
+    // giving row i column j. Fills assign[i] with the column of row i and
+    // returns the total cost.
+    static double solve(const std::vector<double>& cost, int n, std::vector<int>& assign);
+};
+
+#endif // ASSIGNMENT_H
@@ -0,0 +1,283 @@
+#include "profiler.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+bool Profiler::enabled_ = false;
+std::atomic<uint64_t> Profiler::counters_[Profiler::NUM_COUNTERS];
+
+namespace {
+
+const char* const kCounterNames[Profiler::NUM_COUNTERS] = {
+    "moves_proposed", "moves_accepted", "cost_evaluations",
+    "full_cost_evaluations", "grid_updates", "legal_search_steps"
+};
+
+// Perf counters, in column order
+const int kNumHardware = 5;
+const char* const kHardwareNames[kNumHardware] = {
+    "cycles", "instructions", "cache_references", "cache_misses", "page_faults"
+};
+static_assert(kNumHardware <= ProfileScope::kMaxHardware, "ProfileScope keeps every perf counter");
+
+// Trace events kept; later scopes are only summarised
+const size_t kMaxTraceEvents = 1 << 20;
+
+struct ScopeStats {
+    uint64_t calls = 0;
+    double total = 0.0, min = 0.0, max = 0.0;  // Seconds
+    uint64_t hw[kNumHardware] = {};
+    bool has_hw = false;
+};
+
+struct TraceEvent {
+    const char* name;
+    int tid;
+    double ts_us, dur_us;
+};
+
+struct ProfileState {
+    std::mutex mutex;
+    std::chrono::steady_clock::time_point start;
+    std::thread::id main_thread;
+    std::map<std::string, ScopeStats> stats;
+    std::vector<TraceEvent> events;
+    uint64_t dropped = 0;
+    int hw_fd[kNumHardware] = {-1, -1, -1, -1, -1};
+    bool hw_any = false;
+    std::string hw_error;
+    int num_threads = 0;
+};
+
+ProfileState& profileState() {
+    static ProfileState state;
+    return state;
+}
+
+std::atomic<int> next_thread_index(0);
+
+// Small stable thread number for the trace; the enabling thread is 0
+int threadIndex() {
+    thread_local int index = next_thread_index.fetch_add(1);
+    return index;
+}
+
+#ifdef __linux__
+int openPerfCounter(int k) {
+    static const uint32_t types[kNumHardware] = {
+        PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_SOFTWARE
+    };
+    static const uint64_t configs[kNumHardware] = {
+        PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_REFERENCES,
+        PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_SW_PAGE_FAULTS
+    };
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = types[k];
+    attr.config = configs[k];
+    attr.inherit = 1;          // Count threads started later too
+    attr.exclude_kernel = 1;   // Allowed without privileges
+    attr.exclude_hv = 1;
+    return static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0));
+}
+#endif
+
+double secondsSince(std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point t) {
+    return std::chrono::duration<double>(t - start).count();
+}
+
+}  // namespace
+
+void Profiler::enable(bool hardware) {
+    ProfileState& s = profileState();
+    s.start = Clock::now();
+    s.main_thread = std::this_thread::get_id();
+    threadIndex();
+    for (auto& c : counters_) c.store(0, std::memory_order_relaxed);
+
+#ifdef __linux__
+    if (hardware) {
+        for (int k = 0; k < kNumHardware; ++k) {
+            s.hw_fd[k] = openPerfCounter(k);
+            if (s.hw_fd[k] >= 0) {
+                s.hw_any = true;
+            } else if (s.hw_error.empty()) {
+                s.hw_error = std::string(kHardwareNames[k]) + ": " + std::strerror(errno);
+            }
+        }
+    }
+#else
+    if (hardware) s.hw_error = "perf_event_open needs Linux";
+#endif
+    enabled_ = true;
+}
+
+bool Profiler::readHardware(uint64_t values[]) {
+    ProfileState& s = profileState();
+    if (!s.hw_any) return false;
+    for (int k = 0; k < kNumHardware; ++k) {
+        values[k] = 0;
+#ifdef __linux__
+        if (s.hw_fd[k] >= 0 && read(s.hw_fd[k], &values[k], sizeof(values[k])) != sizeof(values[k])) {
+            values[k] = 0;
+        }
+#endif
+    }
+    return true;
+}
+
+bool Profiler::onMainThread() {
+    return std::this_thread::get_id() == profileState().main_thread;
+}
+
+void Profiler::record(const char* name, Clock::time_point start, Clock::time_point end,
+                      const uint64_t* hw_start, const uint64_t* hw_end) {
+    ProfileState& s = profileState();
+    const int tid = threadIndex();
+    const double seconds = secondsSince(start, end);
+
+    std::lock_guard<std::mutex> lock(s.mutex);
+    s.num_threads = std::max(s.num_threads, tid + 1);
+    ScopeStats& st = s.stats[name];
+    st.min = st.calls == 0 ? seconds : std::min(st.min, seconds);
+    st.max = std::max(st.max, seconds);
+    st.total += seconds;
+    st.calls++;
+    if (hw_start && hw_end) {
+        st.has_hw = true;
+        for (int k = 0; k < kNumHardware; ++k) st.hw[k] += hw_end[k] - hw_start[k];
+    }
+    if (s.events.size() < kMaxTraceEvents) {
+        s.events.push_back(TraceEvent{name, tid, secondsSince(s.start, start) * 1e6, seconds * 1e6});
+    } else {
+        s.dropped++;
+    }
+}
+
+void ProfileScope::begin() {
+    if (Profiler::onMainThread()) has_hw_ = Profiler::readHardware(hw_);
+    start_ = Profiler::Clock::now();
+}
+
+void ProfileScope::end() {
+    const Profiler::Clock::time_point end = Profiler::Clock::now();
+    uint64_t hw_end[kMaxHardware];
+    if (has_hw_ && Profiler::readHardware(hw_end)) {
+        Profiler::record(name_, start_, end, hw_, hw_end);
+    } else {
+        Profiler::record(name_, start_, end, nullptr, nullptr);
+    }
+}
+
+void Profiler::writeSummary(std::ostream& out) {
+    if (!enabled_) return;
+    ProfileState& s = profileState();
+    const double wall = secondsSince(s.start, Clock::now());
+    uint64_t hw_total[kNumHardware] = {};
+    const bool has_hw = readHardware(hw_total);
+
+    std::lock_guard<std::mutex> lock(s.mutex);
+    std::vector<std::pair<std::string, ScopeStats>> scopes(s.stats.begin(), s.stats.end());
+    std::stable_sort(scopes.begin(), scopes.end(), [](const std::pair<std::string, ScopeStats>& a,
+                                                      const std::pair<std::string, ScopeStats>& b) {
+        return a.second.total > b.second.total;
+    });
+
+    const std::ios::fmtflags flags = out.flags();
+    const std::streamsize precision = out.precision();
+    out << std::fixed;
+    out << "Profile (wall " << std::setprecision(3) << wall << " s, " << s.num_threads << " threads)\n";
+    out << "  " << std::left << std::setw(28) << "Scope" << std::right << std::setw(10) << "Calls"
+        << std::setw(12) << "Total s" << std::setw(12) << "Mean ms" << std::setw(12) << "Max ms"
+        << std::setw(9) << "% wall";
+    for (int k = 0; k < kNumHardware; ++k) {
+        if (s.hw_fd[k] >= 0) out << std::setw(18) << kHardwareNames[k];
+    }
+    out << "\n";
+    for (const auto& entry : scopes) {
+        const ScopeStats& st = entry.second;
+        out << "  " << std::left << std::setw(28) << entry.first << std::right << std::setw(10) << st.calls
+            << std::setw(12) << std::setprecision(3) << st.total
+            << std::setw(12) << st.total / st.calls * 1e3 << std::setw(12) << st.max * 1e3
+            << std::setw(9) << std::setprecision(1) << (wall > 0 ? 100.0 * st.total / wall : 0.0);
+        for (int k = 0; k < kNumHardware; ++k) {
+            if (s.hw_fd[k] < 0) continue;
+            if (st.has_hw) out << std::setw(18) << st.hw[k];
+            else out << std::setw(18) << "-";
+        }
+        out << "\n";
+    }
+
+    out << "Counters\n";
+    for (int c = 0; c < NUM_COUNTERS; ++c) {
+        out << "  " << std::left << std::setw(28) << kCounterNames[c] << std::right << std::setw(16)
+            << counters_[c].load(std::memory_order_relaxed) << "\n";
+    }
+    if (has_hw) {
+        out << "Perf counters (whole run)\n";
+        for (int k = 0; k < kNumHardware; ++k) {
+            if (s.hw_fd[k] < 0) continue;
+            out << "  " << std::left << std::setw(28) << kHardwareNames[k] << std::right << std::setw(16)
+                << hw_total[k] << "\n";
+        }
+    }
+    if (!s.hw_error.empty()) {
+        out << "Some perf counters are unavailable (" << s.hw_error << ")\n";
+    }
+    if (s.dropped > 0) {
+        out << s.dropped << " scopes were left out of the trace (limit " << kMaxTraceEvents << ")\n";
+    }
+    out.flags(flags);
+    out.precision(precision);
+}
+
+bool Profiler::writeTrace(const std::string& filename) {
+    if (!enabled_) return false;
+    ProfileState& s = profileState();
+    std::ofstream out(filename);
+    if (!out.is_open()) {
+        std::cerr << "Error: Cannot open file " << filename << " for writing" << std::endl;
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(s.mutex);
+    out << std::fixed << std::setprecision(3);
+    out << "{\"traceEvents\":[\n";
+    for (int t = 0; t < std::max(1, s.num_threads); ++t) {
+        out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << t
+            << ",\"args\":{\"name\":\"" << (t == 0 ? std::string("main") : "thread " + std::to_string(t))
+            << "\"}},\n";
+    }
+    for (size_t i = 0; i < s.events.size(); ++i) {
+        const TraceEvent& e = s.events[i];
+        out << "{\"name\":\"" << e.name << "\",\"cat\":\"placement\",\"ph\":\"X\",\"pid\":1,\"tid\":" << e.tid
+            << ",\"ts\":" << e.ts_us << ",\"dur\":" << e.dur_us << "}"
+            << (i + 1 < s.events.size() ? ",\n" : "\n");
+    }
+    out << "],\n\"displayTimeUnit\":\"ms\",\n\"otherData\":{";
+    for (int c = 0; c < NUM_COUNTERS; ++c) {
+        out << (c ? "," : "") << "\"" << kCounterNames[c] << "\":\""
+            << counters_[c].load(std::memory_order_relaxed) << "\"";
+    }
+    out << "}}\n";
+    out.close();
+    if (out.fail()) {
+        std::cerr << "Error: Failed writing " << filename << std::endl;
+        return false;
+    }
+    return true;
+}
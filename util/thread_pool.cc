@@ -0,0 +1,67 @@
+#include "thread_pool.h"
+
+ThreadPool::ThreadPool(int num_threads) : stop_(false) {
+    if (num_threads <= 0) {
+        num_threads = defaultThreads();
+    }
+    workers_.reserve(num_threads);
+    for (int i = 0; i < num_threads; ++i) {
+        workers_.emplace_back([this] { workerLoop(); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    cv_.notify_all();
+    for (auto& worker : workers_) {
+        worker.join();
+    }
+}
+
+int ThreadPool::defaultThreads() {
+    unsigned n = std::thread::hardware_concurrency();
+    return n == 0 ? 1 : static_cast<int>(n);
+}
+
+std::future<void> ThreadPool::submit(std::function<void()> task) {
+    std::packaged_task<void()> packaged(std::move(task));
+    std::future<void> result = packaged.get_future();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        tasks_.push(std::move(packaged));
+    }
+    cv_.notify_one();
+    return result;
+}
+
+void ThreadPool::parallelFor(int n, const std::function<void(int)>& fn) {
+    std::vector<std::future<void>> pending;
+    pending.reserve(n);
+    for (int i = 0; i < n; ++i) {
+        pending.push_back(submit([&fn, i] { fn(i); }));
+    }
+    // Wait for everything before rethrowing so no task outlives `fn`
+    for (auto& f : pending) {
+        f.wait();
+    }
+    for (auto& f : pending) {
+        f.get();
+    }
+}
+
+void ThreadPool::workerLoop() {
+    for (;;) {
+        std::packaged_task<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cv_.wait(lock, [this] { return stop_ || !tasks_.empty(); });
+            if (stop_ && tasks_.empty()) return;
+            task = std::move(tasks_.front());
+            tasks_.pop();
+        }
+        task();
+    }
+}
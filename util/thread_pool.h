@@ -0,0 +1,47 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+// Fixed-size worker pool shared by the parallel optimizers.
+// Tasks run in FIFO order; parallelFor() blocks until every index is done
+// and rethrows the first exception raised by a task. Do not call
+// parallelFor() from inside a pool task: the caller would hold a worker.
+
+class ThreadPool {
+public:
+    // num_threads <= 0 uses defaultThreads()
+    explicit ThreadPool(int num_threads = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    int size() const { return static_cast<int>(workers_.size()); }
+
+    // Queue a task; the future reports completion (and exceptions)
+    std::future<void> submit(std::function<void()> task);
+
+    // Run fn(i) for every i in [0, n) and wait for all of them
+    void parallelFor(int n, const std::function<void(int)>& fn);
+
+    // Hardware concurrency, at least 1
+    static int defaultThreads();
+
+private:
+    std::vector<std::thread> workers_;
+    std::queue<std::packaged_task<void()>> tasks_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool stop_;
+
+    void workerLoop();
+};
+
+#endif // THREAD_POOL_H
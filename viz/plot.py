@@ -1,26 +1,73 @@
 #!/usr/bin/env python3
 """
 Visualization script for placement results.
-Reads JSON output and displays the placement using matplotlib.
+Reads JSON output, or the binary sidecar written with --sidecar, and
+displays the placement using matplotlib.
 """
 
 import json
 import matplotlib.pyplot as plt
 import matplotlib.patches as patches
+import numpy as np
 import sys
 import argparse
 
-def load_placement(filename):
-    """Load placement data from JSON file."""
+# Binary sidecar written by --sidecar (see viz/write_json.h)
+SIDECAR_MAGIC = b'PLCVIZ\0\0'
+SIDECAR_HEADER = np.dtype([('magic', 'S8'), ('version', '=i4'),
+                           ('grid_w', '=i4'), ('grid_h', '=i4'),
+                           ('num_cells', '=i4'), ('num_nets', '=i4'), ('num_pins', '=i4')])
+
+def load_sidecar(filename):
+    """Load placement arrays from a binary sidecar file."""
+    with open(filename, 'rb') as f:
+        header = np.fromfile(f, dtype=SIDECAR_HEADER, count=1)[0]
+        body = np.fromfile(f, dtype='=i4')
+    if header['version'] != 1:
+        raise ValueError(f"unsupported sidecar version {header['version']}")
+    n, m, p = int(header['num_cells']), int(header['num_nets']), int(header['num_pins'])
+    sizes = [('id', n), ('x', n), ('y', n), ('w', n), ('h', n), ('fixed', n),
+             ('net_pin_start', m + 1), ('pin_cell', p), ('pin_dx', p), ('pin_dy', p)]
+    if len(body) != sum(size for _, size in sizes):
+        raise ValueError('sidecar file is truncated or corrupt')
+    data = {'grid_w': int(header['grid_w']), 'grid_h': int(header['grid_h'])}
+    start = 0
+    for name, size in sizes:
+        data[name] = body[start:start + size]
+        start += size
+    data['fixed'] = data['fixed'].astype(bool)
+    return data
+
+def load_json(filename):
+    """Load placement data from JSON file into the sidecar's arrays."""
     with open(filename, 'r') as f:
-        return json.load(f)
+        doc = json.load(f)
+    cells = doc['cells']
+    nets = doc.get('nets', [])
+    data = {'grid_w': doc['grid']['width'], 'grid_h': doc['grid']['height']}
+    for key in ('id', 'x', 'y', 'w', 'h'):
+        data[key] = np.array([c[key] for c in cells], dtype=np.int32)
+    data['fixed'] = np.array([c.get('fixed', False) for c in cells], dtype=bool)
+    index = {int(cell_id): i for i, cell_id in enumerate(data['id'])}
+    pins = [pin for net in nets for pin in net['pins']]
+    data['net_pin_start'] = np.cumsum([0] + [len(net['pins']) for net in nets]).astype(np.int32)
+    data['pin_cell'] = np.array([index.get(pin['cell_id'], -1) for pin in pins], dtype=np.int32)
+    data['pin_dx'] = np.array([pin['offset_x'] for pin in pins], dtype=np.int32)
+    data['pin_dy'] = np.array([pin['offset_y'] for pin in pins], dtype=np.int32)
+    return data
+
+def load_placement(filename):
+    """Load placement data from a JSON or sidecar file."""
+    with open(filename, 'rb') as f:
+        is_sidecar = f.read(len(SIDECAR_MAGIC)) == SIDECAR_MAGIC
+    return load_sidecar(filename) if is_sidecar else load_json(filename)
 
 def plot_placement(data, output_file=None, show_nets=True):
     """Plot the placement visualization."""
     fig, ax = plt.subplots(1, 1, figsize=(12, 10))
     
-    grid_w = data['grid']['width']
-    grid_h = data['grid']['height']
+    grid_w = data['grid_w']
+    grid_h = data['grid_h']
     
     # Set axis limits
     ax.set_xlim(0, grid_w)
@@ -42,13 +89,13 @@ def plot_placement(data, output_file=None, show_nets=True):
     
     # Draw cells
     cell_rects = {}
-    for i, cell in enumerate(data['cells']):
-        x = cell['x']
-        y = cell['y']
-        w = cell['w']
-        h = cell['h']
-        cell_id = cell['id']
-        fixed = cell.get('fixed', False)
+    for i in range(len(data['id'])):
+        x = int(data['x'][i])
+        y = int(data['y'][i])
+        w = int(data['w'][i])
+        h = int(data['h'][i])
+        cell_id = int(data['id'][i])
+        fixed = data['fixed'][i]
         
         color = colors(i % 20)
         if fixed:
@@ -70,19 +117,19 @@ def plot_placement(data, output_file=None, show_nets=True):
     
     # Draw nets
     if show_nets:
-        for net in data['nets']:
-            if len(net['pins']) < 2:
+        net_pin_start = data['net_pin_start']
+        for k in range(len(net_pin_start) - 1):
+            pins = slice(net_pin_start[k], net_pin_start[k + 1])
+            if pins.stop - pins.start < 2:
                 continue
             
-            # Get pin positions
-            pin_positions = []
-            for pin in net['pins']:
-                cell_id = pin['cell_id']
-                cell = next((c for c in data['cells'] if c['id'] == cell_id), None)
-                if cell:
-                    pin_x = cell['x'] + pin['offset_x']
-                    pin_y = cell['y'] + pin['offset_y']
-                    pin_positions.append((pin_x, pin_y))
+            # Get pin positions (pins of unknown cells are skipped)
+            cell = data['pin_cell'][pins]
+            known = cell >= 0
+            cell = cell[known]
+            pin_xs = data['x'][cell] + data['pin_dx'][pins][known]
+            pin_ys = data['y'][cell] + data['pin_dy'][pins][known]
+            pin_positions = list(zip(pin_xs.tolist(), pin_ys.tolist()))
             
             # Draw bounding box (HPWL visualization)
             if len(pin_positions) >= 2:
@@ -115,7 +162,7 @@ def plot_placement(data, output_file=None, show_nets=True):
 
 def main():
     parser = argparse.ArgumentParser(description='Visualize placement results')
-    parser.add_argument('input_file', help='Input JSON file')
+    parser.add_argument('input_file', help='Input JSON or sidecar file')
     parser.add_argument('-o', '--output', help='Output image file (optional)')
     parser.add_argument('--no-nets', action='store_true', help='Hide net visualization')
     
@@ -127,7 +174,7 @@ def main():
     except FileNotFoundError:
         print(f"Error: File {args.input_file} not found", file=sys.stderr)
         sys.exit(1)
-    except json.JSONDecodeError as e:
+    except (json.JSONDecodeError, UnicodeDecodeError) as e:
         print(f"Error: Invalid JSON file: {e}", file=sys.stderr)
         sys.exit(1)
     except Exception as e:
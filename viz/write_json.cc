@@ -1,72 +1,273 @@
 #include "write_json.h"
+#include <charconv>
+#include <cstdio>
+#include <cstring>
 #include <fstream>
-#include <sstream>
-#include <iomanip>
 #include <iostream>
+#include <unordered_map>
+#include <vector>
 
-std::string JsonWriter::placementToJson(const Placement& pl) {
-    std::ostringstream oss;
-    oss << std::fixed << std::setprecision(2);
-    
-    oss << "{\n";
-    oss << "  \"grid\": {\n";
-    oss << "    \"width\": " << pl.grid.W << ",\n";
-    oss << "    \"height\": " << pl.grid.H << "\n";
-    oss << "  },\n";
-    
-    oss << "  \"cells\": [\n";
+const char SidecarHeader::kMagic[8] = {'P', 'L', 'C', 'V', 'I', 'Z', '\0', '\0'};
+
+static_assert(sizeof(SidecarHeader) == 32, "Sidecar header is read by numpy as 8 bytes + 6 int32");
+
+namespace {
+
+// Bytes buffered before they are handed to the sink
+const size_t kBufferSize = 1 << 20;
+
+// Longest single token: an int with sign, or a key
+const size_t kMaxToken = 64;
+
+// Buffered JSON output to a FILE* or a std::string
+class JsonStream {
+public:
+    JsonStream(std::FILE* file, bool compact) : file_(file), text_(nullptr), compact_(compact) {
+        buffer_.resize(kBufferSize);
+    }
+    JsonStream(std::string* text, bool compact) : file_(nullptr), text_(text), compact_(compact) {
+        buffer_.resize(kBufferSize);
+    }
+    ~JsonStream() { flush(); }
+
+    void put(char c) {
+        reserve(1);
+        buffer_[used_++] = c;
+    }
+
+    // `s` is a literal no longer than kMaxToken
+    void put(const char* s) {
+        size_t n = std::strlen(s);
+        reserve(n);
+        std::memcpy(buffer_.data() + used_, s, n);
+        used_ += n;
+    }
+
+    void putInt(int value) {
+        reserve(kMaxToken);
+        char* begin = buffer_.data() + used_;
+        used_ += std::to_chars(begin, begin + kMaxToken, value).ptr - begin;
+    }
+
+    void putBool(bool value) { put(value ? "true" : "false"); }
+
+    // Line break and indentation; nothing in compact mode
+    void newline(int indent) {
+        if (compact_) return;
+        reserve(1 + indent);
+        buffer_[used_++] = '\n';
+        std::memset(buffer_.data() + used_, ' ', indent);
+        used_ += indent;
+    }
+
+    // "name": with the space only when pretty
+    void key(const char* name) {
+        put('"');
+        put(name);
+        put(compact_ ? "\":" : "\": ");
+    }
+
+    // One line of an object: "name": value, followed by a comma unless last
+    void field(int indent, const char* name, int value, bool last = false) {
+        newline(indent);
+        key(name);
+        putInt(value);
+        if (!last) put(',');
+    }
+
+    void flush() {
+        if (used_ == 0) return;
+        if (file_) {
+            if (std::fwrite(buffer_.data(), 1, used_, file_) != used_) failed_ = true;
+        } else {
+            text_->append(buffer_.data(), used_);
+        }
+        used_ = 0;
+    }
+
+    bool failed() const { return failed_; }
+
+private:
+    std::FILE* file_;
+    std::string* text_;
+    bool compact_;
+    std::vector<char> buffer_;
+    size_t used_ = 0;
+    bool failed_ = false;
+
+    void reserve(size_t n) {
+        if (used_ + n > buffer_.size()) flush();
+        if (n > buffer_.size()) buffer_.resize(n);
+    }
+};
+
+void writeDocument(const Placement& pl, const JsonOptions& options, JsonStream& out) {
+    out.put('{');
+    out.newline(2);
+    out.key("grid");
+    out.put('{');
+    out.field(4, "width", pl.grid.W);
+    out.field(4, "height", pl.grid.H, true);
+    out.newline(2);
+    out.put("},");
+
+    out.newline(2);
+    out.key("cells");
+    out.put('[');
     for (size_t i = 0; i < pl.cells.size(); ++i) {
         const auto& cell = pl.cells[i];
-        oss << "    {\n";
-        oss << "      \"id\": " << cell.id << ",\n";
-        oss << "      \"x\": " << cell.x << ",\n";
-        oss << "      \"y\": " << cell.y << ",\n";
-        oss << "      \"w\": " << cell.w << ",\n";
-        oss << "      \"h\": " << cell.h << ",\n";
-        oss << "      \"fixed\": " << (cell.fixed ? "true" : "false") << "\n";
-        oss << "    }";
-        if (i < pl.cells.size() - 1) oss << ",";
-        oss << "\n";
-    }
-    oss << "  ],\n";
-    
-    oss << "  \"nets\": [\n";
-    for (size_t i = 0; i < pl.nets.size(); ++i) {
-        const auto& net = pl.nets[i];
-        oss << "    {\n";
-        oss << "      \"id\": " << net.id << ",\n";
-        oss << "      \"pins\": [\n";
-        for (size_t j = 0; j < net.pins.size(); ++j) {
-            const auto& pin = net.pins[j];
-            oss << "        {\n";
-            oss << "          \"cell_id\": " << pin.cell_id << ",\n";
-            oss << "          \"offset_x\": " << pin.offset_x << ",\n";
-            oss << "          \"offset_y\": " << pin.offset_y << "\n";
-            oss << "        }";
-            if (j < net.pins.size() - 1) oss << ",";
-            oss << "\n";
+        if (i > 0) out.put(',');
+        out.newline(4);
+        out.put('{');
+        out.field(6, "id", cell.id);
+        out.field(6, "x", cell.x);
+        out.field(6, "y", cell.y);
+        out.field(6, "w", cell.w);
+        out.field(6, "h", cell.h);
+        out.newline(6);
+        out.key("fixed");
+        out.putBool(cell.fixed);
+        out.newline(4);
+        out.put('}');
+    }
+    out.newline(2);
+    out.put(']');
+
+    if (options.include_nets) {
+        out.put(',');
+        out.newline(2);
+        out.key("nets");
+        out.put('[');
+        for (size_t i = 0; i < pl.nets.size(); ++i) {
+            const auto& net = pl.nets[i];
+            if (i > 0) out.put(',');
+            out.newline(4);
+            out.put('{');
+            out.field(6, "id", net.id);
+            out.newline(6);
+            out.key("pins");
+            out.put('[');
+            for (size_t j = 0; j < net.pins.size(); ++j) {
+                const auto& pin = net.pins[j];
+                if (j > 0) out.put(',');
+                out.newline(8);
+                out.put('{');
+                out.field(10, "cell_id", pin.cell_id);
+                out.field(10, "offset_x", pin.offset_x);
+                out.field(10, "offset_y", pin.offset_y, true);
+                out.newline(8);
+                out.put('}');
+            }
+            out.newline(6);
+            out.put(']');
+            out.newline(4);
+            out.put('}');
         }
-        oss << "      ]\n";
-        oss << "    }";
-        if (i < pl.nets.size() - 1) oss << ",";
-        oss << "\n";
-    }
-    oss << "  ]\n";
-    oss << "}\n";
-    
-    return oss.str();
+        out.newline(2);
+        out.put(']');
+    }
+    out.newline(0);
+    out.put("}\n");
+}
+
+void writeColumn(std::ofstream& out, const std::vector<int32_t>& column) {
+    if (!column.empty()) {
+        out.write(reinterpret_cast<const char*>(column.data()),
+                  static_cast<std::streamsize>(column.size() * sizeof(int32_t)));
+    }
 }
 
-void JsonWriter::writePlacement(const Placement& pl, const std::string& filename) {
-    std::ofstream file(filename);
-    if (!file.is_open()) {
+}  // namespace
+
+std::string JsonWriter::placementToJson(const Placement& pl, const JsonOptions& options) {
+    std::string text;
+    {
+        JsonStream out(&text, options.compact);
+        writeDocument(pl, options, out);
+    }
+    return text;
+}
+
+void JsonWriter::writePlacement(const Placement& pl, const std::string& filename, const JsonOptions& options) {
+    std::FILE* file = std::fopen(filename.c_str(), "wb");
+    if (!file) {
         std::cerr << "Error: Cannot open file " << filename << " for writing" << std::endl;
         return;
     }
-    
-    file << placementToJson(pl);
-    file.close();
-    
+
+    bool failed;
+    {
+        JsonStream out(file, options.compact);
+        writeDocument(pl, options, out);
+        out.flush();
+        failed = out.failed();
+    }
+    if (std::fclose(file) != 0) failed = true;
+    if (failed) {
+        std::cerr << "Error: Failed writing " << filename << std::endl;
+        return;
+    }
+
     std::cout << "Placement written to " << filename << std::endl;
 }
 
+bool JsonWriter::writeSidecar(const Placement& pl, const std::string& filename, bool include_nets) {
+    const size_t n = pl.cells.size();
+    std::vector<int32_t> id(n), x(n), y(n), w(n), h(n), fixed(n);
+    for (size_t i = 0; i < n; ++i) {
+        const Cell& cell = pl.cells[i];
+        id[i] = cell.id;
+        x[i] = cell.x;
+        y[i] = cell.y;
+        w[i] = cell.w;
+        h[i] = cell.h;
+        fixed[i] = cell.fixed ? 1 : 0;
+    }
+
+    // Pins refer to cells by index; reuse the netlist when it is built
+    std::vector<int32_t> net_pin_start(1, 0), pin_cell, pin_dx, pin_dy;
+    if (include_nets && pl.hasIndex()) {
+        net_pin_start = pl.netlist.net_pin_start;
+        pin_cell = pl.netlist.pin_cell;
+        pin_dx = pl.netlist.pin_dx;
+        pin_dy = pl.netlist.pin_dy;
+    } else if (include_nets) {
+        std::unordered_map<int, int> index;
+        index.reserve(n);
+        for (size_t i = 0; i < n; ++i) index.emplace(pl.cells[i].id, static_cast<int>(i));
+        for (const auto& net : pl.nets) {
+            for (const auto& pin : net.pins) {
+                auto it = index.find(pin.cell_id);
+                pin_cell.push_back(it == index.end() ? -1 : it->second);
+                pin_dx.push_back(pin.offset_x);
+                pin_dy.push_back(pin.offset_y);
+            }
+            net_pin_start.push_back(static_cast<int32_t>(pin_cell.size()));
+        }
+    }
+
+    SidecarHeader header;
+    std::memcpy(header.magic, SidecarHeader::kMagic, sizeof(header.magic));
+    header.version = SidecarHeader::kVersion;
+    header.grid_w = pl.grid.W;
+    header.grid_h = pl.grid.H;
+    header.num_cells = static_cast<int32_t>(n);
+    header.num_nets = static_cast<int32_t>(net_pin_start.size() - 1);
+    header.num_pins = static_cast<int32_t>(pin_cell.size());
+
+    std::ofstream out(filename, std::ios::binary);
+    if (!out.is_open()) {
+        std::cerr << "Error: Cannot open file " << filename << " for writing" << std::endl;
+        return false;
+    }
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    for (const auto* column : {&id, &x, &y, &w, &h, &fixed, &net_pin_start, &pin_cell, &pin_dx, &pin_dy}) {
+        writeColumn(out, *column);
+    }
+    out.close();
+    if (out.fail()) {
+        std::cerr << "Error: Failed writing " << filename << std::endl;
+        return false;
+    }
+    return true;
+}
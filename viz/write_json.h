@@ -2,18 +2,50 @@
 #define WRITE_JSON_H
 
 #include "../model/placement.h"
+#include <cstdint>
 #include <string>
 
-// Output placement results to JSON format for visualization
+// Output placement results to JSON format for visualization.
+// The document is streamed through a fixed buffer with integers formatted
+// by std::to_chars, so writing never holds the whole file in memory.
+// The default pretty layout puts one field per line; compact mode drops
+// all whitespace. Nets never change during placement, so they can be
+// left out.
+
+struct JsonOptions {
+    bool compact = false;       // No whitespace between tokens
+    bool include_nets = true;   // Write the "nets" array
+};
+
+// Binary sidecar read by viz/plot.py with numpy instead of parsing JSON.
+// Native byte order, every field an int32 after the 8-byte magic:
+//   magic "PLCVIZ\0\0", version, grid_w, grid_h, num_cells, num_nets, num_pins
+//   cell id, x, y, w, h, fixed        num_cells each
+//   net_pin_start                     num_nets + 1
+//   pin_cell, pin_dx, pin_dy          num_pins each
+// pin_cell is the index of the pin's cell in the cell arrays, -1 if the
+// cell does not exist. Without nets, num_nets and num_pins are 0.
+struct SidecarHeader {
+    static const char kMagic[8];
+    static const int32_t kVersion = 1;
+
+    char magic[8];
+    int32_t version;
+    int32_t grid_w, grid_h;
+    int32_t num_cells, num_nets, num_pins;
+};
 
 class JsonWriter {
 public:
     // Write placement to JSON file
-    static void writePlacement(const Placement& pl, const std::string& filename);
-    
+    static void writePlacement(const Placement& pl, const std::string& filename,
+                               const JsonOptions& options = JsonOptions());
+
     // Write placement to JSON string
-    static std::string placementToJson(const Placement& pl);
+    static std::string placementToJson(const Placement& pl, const JsonOptions& options = JsonOptions());
+
+    // Write the binary sidecar; false, after printing the error, on failure
+    static bool writeSidecar(const Placement& pl, const std::string& filename, bool include_nets = true);
 };
 
 #endif // WRITE_JSON_H
-